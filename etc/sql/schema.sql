@@ -211,6 +211,33 @@ CREATE TABLE exec_t (
 CREATE INDEX exec_accnt_seq_id_idx ON exec_t (accnt, seq_id);
 CREATE INDEX exec_state_archive_idx ON exec_t (state_id, archive);
 
+CREATE TABLE posn_t (
+  accnt CHAR(16) NOT NULL,
+  market_id BIGINT NOT NULL,
+  instr CHAR(16) NOT NULL,
+  settl_day INT NULL DEFAULT NULL,
+  buy_lots BIGINT NOT NULL DEFAULT 0,
+  buy_cost BIGINT NOT NULL DEFAULT 0,
+  sell_lots BIGINT NOT NULL DEFAULT 0,
+  sell_cost BIGINT NOT NULL DEFAULT 0,
+
+  PRIMARY KEY (accnt, market_id),
+
+  FOREIGN KEY (market_id) REFERENCES market_t (id),
+  FOREIGN KEY (instr) REFERENCES instr_t (symbol)
+)
+;
+
+-- Encoded messages in the order that they were journaled, from which replication followers catch
+-- up. The daemon deletes rows older than the most recent journ_retain messages, unless they have yet
+-- to be acknowledged by a connected follower. The last row is never deleted, because it holds the
+-- journal's sequence number.
+CREATE TABLE journ_t (
+  seq INTEGER NOT NULL PRIMARY KEY,
+  msg BLOB NOT NULL
+)
+;
+
 CREATE TRIGGER before_insert_on_exec1
   BEFORE INSERT ON exec_t
   WHEN NEW.order_id IS NOT NULL
@@ -315,6 +342,34 @@ CREATE TRIGGER after_insert_on_exec1
   END
 ;
 
+CREATE TRIGGER after_insert_on_exec2
+  AFTER INSERT ON exec_t
+  WHEN NEW.state_id = 4
+  BEGIN
+    INSERT OR IGNORE INTO posn_t (
+      accnt,
+      market_id,
+      instr,
+      settl_day
+    ) VALUES (
+      NEW.accnt,
+      NEW.market_id,
+      NEW.instr,
+      NEW.settl_day
+    );
+    UPDATE posn_t
+    SET
+      buy_lots = buy_lots + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots ELSE 0 END,
+      buy_cost = buy_cost
+        + CASE WHEN NEW.side_id = 1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END,
+      sell_lots = sell_lots + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots ELSE 0 END,
+      sell_cost = sell_cost
+        + CASE WHEN NEW.side_id = -1 THEN NEW.last_lots * NEW.last_ticks ELSE 0 END
+    WHERE accnt = NEW.accnt
+    AND market_id = NEW.market_id;
+  END
+;
+
 CREATE VIEW asset_v AS
   SELECT
     a.id,
@@ -425,19 +480,5 @@ CREATE VIEW exec_v AS
   ON e.liq_ind_id = r.id
 ;
 
-CREATE VIEW posn_v AS
-  SELECT
-    e.accnt,
-    e.market_id,
-    e.instr,
-    e.settl_day,
-    e.side_id,
-    SUM(e.last_lots) lots,
-    SUM(e.last_lots * e.last_ticks) cost
-  FROM exec_t e
-  WHERE e.state_id = 4
-  GROUP BY e.accnt, e.market_id, e.side_id
-;
-
 COMMIT
 ;
@@ -0,0 +1,94 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "AgentStats.hpp"
+
+#include "MemQueue.hpp"
+
+#include <swirly/util/String.hpp>
+
+namespace swirly {
+inline namespace app {
+namespace {
+constexpr std::size_t blockSize(std::size_t slots) noexcept
+{
+    return sizeof(AgentStatsBlock::Impl) + slots * sizeof(AgentStats);
+}
+} // namespace
+
+AgentStatsBlock::AgentStatsBlock(std::size_t slots)
+: memMap_{os::mmap(nullptr, blockSize(slots), PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1,
+                   0)}
+, impl_{static_cast<Impl*>(memMap_.get().data())}
+{
+    impl_->slots = slots;
+}
+
+AgentStatsBlock::AgentStatsBlock(const char* path, bool readOnly)
+: fh_{os::open(path, readOnly ? O_RDONLY : O_RDWR)}
+{
+    const auto size = detail::fileSize(fh_.get());
+    if (size < sizeof(Impl)) {
+        throw std::runtime_error{"agent stats file too small"};
+    }
+    memMap_ = os::mmap(nullptr, size, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fh_.get(), 0);
+    impl_ = static_cast<Impl*>(memMap_.get().data());
+    if (blockSize(impl_->slots) > size) {
+        throw std::runtime_error{"agent stats file truncated"};
+    }
+}
+
+AgentStatsBlock::~AgentStatsBlock() = default;
+
+AgentStatsBlock::AgentStatsBlock(AgentStatsBlock&&) noexcept = default;
+
+AgentStatsBlock& AgentStatsBlock::operator=(AgentStatsBlock&&) noexcept = default;
+
+AgentStats* AgentStatsBlock::alloc(std::string_view name) noexcept
+{
+    assert(!name.empty());
+    name = name.substr(0, AgentStats::MaxName);
+    AgentStats* slot{nullptr};
+    for (std::size_t i{0}; i < impl_->slots; ++i) {
+        auto& stats = impl_->stats[i];
+        if (app::name(stats) == name) {
+            slot = &stats;
+            break;
+        }
+        if (!slot && !used(i)) {
+            slot = &stats;
+        }
+    }
+    if (slot) {
+        std::memset(slot, 0, sizeof(*slot));
+        pstrcpy<'\0'>(slot->name, name);
+    }
+    return slot;
+}
+
+void createAgentStatsBlock(const char* path, std::size_t slots, mode_t mode)
+{
+    FileHandle fh{os::open(path, O_RDWR | O_CREAT | O_EXCL, mode)};
+    // Extended files are zero-filled, so every slot is initially unused.
+    os::ftruncate(fh.get(), blockSize(slots));
+    MMap memMap{os::mmap(nullptr, sizeof(AgentStatsBlock::Impl), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fh.get(), 0)};
+    static_cast<AgentStatsBlock::Impl*>(memMap.get().data())->slots = slots;
+}
+
+} // namespace app
+} // namespace swirly
@@ -0,0 +1,194 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_APP_AGENTSTATS_HPP
+#define SWIRLY_APP_AGENTSTATS_HPP
+
+#include <swirly/sys/File.hpp>
+#include <swirly/sys/MMap.hpp>
+#include <swirly/sys/Memory.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+namespace swirly {
+inline namespace app {
+
+/**
+ * Counters maintained by an agent thread. Each block is written by a single thread, and may be read
+ * by other threads or processes at any time without synchronisation. Readers should use snapshot()
+ * to load the counters.
+ */
+struct alignas(CacheLineSize) AgentStats {
+    enum : std::size_t { MaxName = 16, Buckets = 16 };
+    /**
+     * Thread name. Not null-terminated if it fills the array.
+     */
+    char name[MaxName];
+    /**
+     * Total work items reported by the agent.
+     */
+    std::uint64_t workItems;
+    /**
+     * Calls to the agent that did some work.
+     */
+    std::uint64_t busyCycles;
+    /**
+     * Calls to the agent that did no work.
+     */
+    std::uint64_t idleCycles;
+    /**
+     * Nanoseconds spent in idle spells, including the backoff and the calls that found no work.
+     */
+    std::uint64_t idleNanos;
+    /**
+     * Histogram of work items per busy cycle. Bucket i counts batches of size [2^i, 2^(i+1)), and
+     * the last bucket also counts all larger batches.
+     */
+    std::uint64_t batchSizes[Buckets];
+};
+static_assert(std::is_trivially_copyable_v<AgentStats>);
+static_assert(sizeof(AgentStats) % CacheLineSize == 0);
+
+inline std::string_view name(const AgentStats& stats) noexcept
+{
+    return {stats.name, strnlen(stats.name, AgentStats::MaxName)};
+}
+
+/**
+ * Returns the histogram bucket for a batch of size n, which must be positive.
+ */
+constexpr std::size_t batchBucket(std::uint64_t n) noexcept
+{
+    const std::size_t i = 63 - __builtin_clzll(n);
+    return i < AgentStats::Buckets ? i : AgentStats::Buckets - 1;
+}
+
+namespace detail {
+inline void increment(std::uint64_t& counter, std::uint64_t n = 1) noexcept
+{
+    // Single writer, so there is no need for a read-modify-write.
+    __atomic_store_n(&counter, counter + n, __ATOMIC_RELAXED);
+}
+} // namespace detail
+
+inline void recordBusy(AgentStats& stats, std::uint64_t n) noexcept
+{
+    detail::increment(stats.workItems, n);
+    detail::increment(stats.busyCycles);
+    detail::increment(stats.batchSizes[batchBucket(n)]);
+}
+
+inline void recordIdle(AgentStats& stats) noexcept
+{
+    detail::increment(stats.idleCycles);
+}
+
+inline void recordIdleTime(AgentStats& stats, std::chrono::nanoseconds ns) noexcept
+{
+    detail::increment(stats.idleNanos, ns.count());
+}
+
+/**
+ * Load counters written by another thread or process.
+ */
+inline AgentStats snapshot(const AgentStats& stats) noexcept
+{
+    AgentStats copy;
+    std::memcpy(copy.name, stats.name, sizeof(copy.name));
+    copy.workItems = __atomic_load_n(&stats.workItems, __ATOMIC_RELAXED);
+    copy.busyCycles = __atomic_load_n(&stats.busyCycles, __ATOMIC_RELAXED);
+    copy.idleCycles = __atomic_load_n(&stats.idleCycles, __ATOMIC_RELAXED);
+    copy.idleNanos = __atomic_load_n(&stats.idleNanos, __ATOMIC_RELAXED);
+    for (std::size_t i{0}; i < AgentStats::Buckets; ++i) {
+        copy.batchSizes[i] = __atomic_load_n(&stats.batchSizes[i], __ATOMIC_RELAXED);
+    }
+    return copy;
+}
+
+/**
+ * Fixed array of AgentStats blocks, which may be shared with other processes through a file. The
+ * file is mapped read-only by readers, so that monitoring tools cannot disturb the agents.
+ */
+class SWIRLY_API AgentStatsBlock {
+  public:
+    struct alignas(CacheLineSize) Impl {
+        std::uint64_t slots;
+        alignas(CacheLineSize) AgentStats stats[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(offsetof(Impl, stats) == CacheLineSize);
+
+    AgentStatsBlock(std::nullptr_t = nullptr) noexcept {}
+    /**
+     * Private block for use within a single process.
+     *
+     * @param slots Maximum number of agents.
+     */
+    explicit AgentStatsBlock(std::size_t slots);
+    /**
+     * Open file-based block.
+     *
+     * @param path File created by createAgentStatsBlock().
+     *
+     * @param readOnly Map the file read-only.
+     */
+    explicit AgentStatsBlock(const char* path, bool readOnly = false);
+    ~AgentStatsBlock();
+
+    // Copy.
+    AgentStatsBlock(const AgentStatsBlock& rhs) = delete;
+    AgentStatsBlock& operator=(const AgentStatsBlock& rhs) = delete;
+
+    // Move.
+    AgentStatsBlock(AgentStatsBlock&&) noexcept;
+    AgentStatsBlock& operator=(AgentStatsBlock&&) noexcept;
+
+    /**
+     * Returns the number of slots.
+     */
+    std::size_t slots() const noexcept { return impl_ ? impl_->slots : 0; }
+    const AgentStats& operator[](std::size_t i) const noexcept { return impl_->stats[i]; }
+    /**
+     * Returns true if the slot has been assigned to an agent.
+     */
+    bool used(std::size_t i) const noexcept { return impl_->stats[i].name[0] != '\0'; }
+
+    /**
+     * Returns the slot for the named agent, claiming an unused slot if there is none. The counters
+     * are reset, so that a restarted process does not inherit stale values. This function is not
+     * thread-safe; slots should be assigned before the agent threads are started.
+     *
+     * @return null if all slots are in use.
+     */
+    AgentStats* alloc(std::string_view name) noexcept;
+
+  private:
+    FileHandle fh_{nullptr};
+    MMap memMap_{nullptr};
+    Impl* impl_{nullptr};
+};
+
+/**
+ * Initialise file-based AgentStatsBlock.
+ */
+SWIRLY_API void createAgentStatsBlock(const char* path, std::size_t slots, mode_t mode);
+
+} // namespace app
+} // namespace swirly
+
+#endif // SWIRLY_APP_AGENTSTATS_HPP
@@ -0,0 +1,98 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "AgentStats.hpp"
+
+#include "Thread.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+
+using namespace std;
+using namespace swirly;
+
+BOOST_AUTO_TEST_SUITE(AgentStatsSuite)
+
+BOOST_AUTO_TEST_CASE(BatchBucketCase)
+{
+    BOOST_TEST(batchBucket(1) == 0U);
+    BOOST_TEST(batchBucket(2) == 1U);
+    BOOST_TEST(batchBucket(3) == 1U);
+    BOOST_TEST(batchBucket(4) == 2U);
+    BOOST_TEST(batchBucket(1 << 20) == AgentStats::Buckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(AgentStatsAllocCase)
+{
+    AgentStatsBlock block{2};
+    BOOST_TEST(block.slots() == 2U);
+    BOOST_TEST(!block.used(0));
+
+    auto* const a = block.alloc("journ"sv);
+    BOOST_TEST(a == &block[0]);
+    BOOST_TEST(name(*a) == "journ"sv);
+    recordBusy(*a, 5);
+    BOOST_TEST(a->workItems == 5U);
+    BOOST_TEST(a->batchSizes[2] == 1U);
+
+    // Long names are truncated.
+    auto* const b = block.alloc("abcdefghijklmnopqrstuvwxyz"sv);
+    BOOST_TEST(b == &block[1]);
+    BOOST_TEST(name(*b) == "abcdefghijklmnop"sv);
+
+    BOOST_TEST(!block.alloc("other"sv));
+    // Existing slots are reused and reset.
+    BOOST_TEST(block.alloc("journ"sv) == a);
+    BOOST_TEST(a->workItems == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(AgentStatsFileCase)
+{
+    char path[] = "/tmp/swirly-stats-XXXXXX";
+    close(mkstemp(path));
+    unlink(path);
+    createAgentStatsBlock(path, 4, 0644);
+    {
+        AgentStatsBlock writer{path};
+        AgentStatsBlock reader{path, true};
+        BOOST_TEST(reader.slots() == 4U);
+
+        auto* const stats = writer.alloc("test"sv);
+        int calls{0};
+        auto agent = [&calls]() {
+            // Alternate between a batch of three and an empty poll.
+            return ++calls % 2 == 0 ? 3 : 0;
+        };
+        {
+            ThreadConfig config{"test"s};
+            config.stats = stats;
+            AgentThread thread{agent, config};
+            while (snapshot(reader[0]).busyCycles < 100) {
+                this_thread::yield();
+            }
+        }
+        const auto snap = snapshot(reader[0]);
+        BOOST_TEST(name(snap) == "test"sv);
+        BOOST_TEST(snap.workItems == 3 * snap.busyCycles);
+        BOOST_TEST(snap.batchSizes[1] == snap.busyCycles);
+        BOOST_TEST(snap.idleCycles >= snap.busyCycles);
+        BOOST_TEST(!reader.used(1));
+    }
+    unlink(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,317 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_APP_BROADCASTQUEUE_HPP
+#define SWIRLY_APP_BROADCASTQUEUE_HPP
+
+#include <swirly/app/MemQueue.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace swirly {
+inline namespace app {
+
+/**
+ * Single-producer broadcast queue, where each consumer has its own read cursor.
+ *
+ * Every element posted to the queue is seen by every attached consumer. Only critical consumers
+ * apply backpressure to the producer. A non-critical consumer that falls more than the capacity
+ * behind is fast-forwarded to the oldest available element, and the number of elements skipped is
+ * recorded in its cursor.
+ *
+ * Elements are fixed-size, so the queue cannot carry the variable-length frames of MsgQueue. It
+ * currently carries only the market-data book updates.
+ */
+template <typename ValueT>
+class BroadcastQueue {
+    static_assert(std::is_trivially_copyable_v<ValueT>);
+
+  public:
+    enum : std::size_t { MaxConsumers = 8 };
+    enum : std::uint32_t { Attached = 1 << 0, Critical = 1 << 1 };
+
+    struct alignas(CacheLineSize) Elem {
+        // Position plus one once published, or zero while being written.
+        std::int64_t seq;
+        ValueT val;
+    };
+    static_assert(std::is_trivially_copyable_v<Elem>);
+    struct alignas(CacheLineSize) Cursor {
+        std::int64_t rpos;
+        std::int64_t drops;
+        std::uint32_t flags;
+    };
+    static_assert(std::is_trivially_copyable_v<Cursor>);
+    struct alignas(CacheLineSize) Impl {
+        // Ensure that the write position and each read cursor are in different cache-lines.
+        std::int64_t wpos;
+        alignas(CacheLineSize) Cursor cursors[MaxConsumers];
+        alignas(CacheLineSize) Elem elems[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(sizeof(Impl) == (1 + MaxConsumers) * CacheLineSize);
+    static_assert(offsetof(Impl, wpos) == 0 * CacheLineSize);
+    static_assert(offsetof(Impl, cursors) == 1 * CacheLineSize);
+    static_assert(offsetof(Impl, elems) == (1 + MaxConsumers) * CacheLineSize);
+
+    constexpr BroadcastQueue(std::nullptr_t = nullptr) noexcept {}
+    explicit BroadcastQueue(std::size_t capacity)
+    : capacity_{nextPow2(capacity)}
+    , mask_{capacity_ - 1}
+    , memMap_{os::mmap(nullptr, size(capacity_), PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1,
+                       0)}
+    , impl_{static_cast<Impl*>(memMap_.get().data())}
+    {
+        assert(capacity >= 2);
+        // Anonymous mappings are zero-filled, which is the initial state of the queue.
+    }
+    explicit BroadcastQueue(const char* path)
+    : fh_{os::open(path, O_RDWR)}
+    , capacity_{capacity(detail::fileSize(fh_.get()))}
+    , mask_{capacity_ - 1}
+    , memMap_{os::mmap(nullptr, size(capacity_), PROT_READ | PROT_WRITE, MAP_SHARED, fh_.get(), 0)}
+    , impl_{static_cast<Impl*>(memMap_.get().data())}
+    {
+        if (!isPow2(capacity_)) {
+            throw std::runtime_error{"capacity not a power of two"};
+        }
+    }
+    ~BroadcastQueue() = default;
+
+    // Copy.
+    BroadcastQueue(const BroadcastQueue& rhs) = delete;
+    BroadcastQueue& operator=(const BroadcastQueue& rhs) = delete;
+
+    // Move.
+    BroadcastQueue(BroadcastQueue&& rhs) noexcept
+    : fh_{std::move(rhs.fh_)}
+    , capacity_{rhs.capacity_}
+    , mask_{rhs.mask_}
+    , gate_{rhs.gate_}
+    , memMap_{std::move(rhs.memMap_)}
+    , impl_{rhs.impl_}
+    {
+        rhs.capacity_ = 0;
+        rhs.mask_ = 0;
+        rhs.gate_ = 0;
+        rhs.impl_ = nullptr;
+    }
+    BroadcastQueue& operator=(BroadcastQueue&& rhs) noexcept
+    {
+        reset();
+        swap(rhs);
+        return *this;
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    /**
+     * Returns the number of elements that the consumer has yet to read.
+     */
+    std::size_t lag(std::size_t id) const noexcept
+    {
+        const auto rpos = __atomic_load_n(&impl_->cursors[id].rpos, __ATOMIC_ACQUIRE);
+        const auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_ACQUIRE);
+        return wpos - rpos;
+    }
+    /**
+     * Returns the number of elements that a non-critical consumer has missed because it was
+     * overrun by the producer.
+     */
+    std::size_t drops(std::size_t id) const noexcept
+    {
+        return __atomic_load_n(&impl_->cursors[id].drops, __ATOMIC_RELAXED);
+    }
+    void reset(std::nullptr_t = nullptr) noexcept
+    {
+        // Reverse order.
+        impl_ = nullptr;
+        memMap_.reset(nullptr);
+        gate_ = 0;
+        mask_ = 0;
+        capacity_ = 0;
+        fh_.reset(nullptr);
+    }
+    void swap(BroadcastQueue& rhs) noexcept
+    {
+        fh_.swap(rhs.fh_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(mask_, rhs.mask_);
+        std::swap(gate_, rhs.gate_);
+        memMap_.swap(rhs.memMap_);
+        std::swap(impl_, rhs.impl_);
+    }
+    /**
+     * Attach a consumer positioned at the current write position.
+     *
+     * @param critical True if the consumer may apply backpressure to the producer.
+     *
+     * @return the consumer id.
+     */
+    std::size_t attach(bool critical)
+    {
+        const std::uint32_t flags{critical ? Attached | Critical : Attached};
+        for (std::size_t id{0}; id < MaxConsumers; ++id) {
+            auto& cursor = impl_->cursors[id];
+            std::uint32_t expected{0};
+            // Claim the cursor before publishing its read position.
+            if (__atomic_compare_exchange_n(&cursor.flags, &expected, Attached, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                __atomic_store_n(&cursor.drops, 0, __ATOMIC_RELAXED);
+                __atomic_store_n(&cursor.rpos, __atomic_load_n(&impl_->wpos, __ATOMIC_ACQUIRE),
+                                 __ATOMIC_RELAXED);
+                __atomic_store_n(&cursor.flags, flags, __ATOMIC_RELEASE);
+                return id;
+            }
+        }
+        throw std::runtime_error{"too many consumers"};
+    }
+    void detach(std::size_t id) noexcept
+    {
+        __atomic_store_n(&impl_->cursors[id].flags, 0, __ATOMIC_RELEASE);
+    }
+    /**
+     * Returns false if there are no unread elements for the consumer.
+     */
+    template <typename FnT>
+    bool fetch(std::size_t id, FnT fn) noexcept
+    {
+        static_assert(std::is_nothrow_invocable_v<FnT, const ValueT&>);
+        auto& cursor = impl_->cursors[id];
+        // Only the consumer writes its own read position.
+        auto rpos = __atomic_load_n(&cursor.rpos, __ATOMIC_RELAXED);
+        for (;;) {
+            const auto& elem = impl_->elems[rpos & mask_];
+            const auto seq = __atomic_load_n(&elem.seq, __ATOMIC_ACQUIRE);
+            const auto diff = seq - (rpos + 1);
+            if (diff == 0) {
+                // The producer may overwrite the element while it is being copied, so the sequence
+                // is checked again after the copy.
+                ValueT val;
+                std::memcpy(&val, &elem.val, sizeof(ValueT));
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&elem.seq, __ATOMIC_RELAXED) == seq) {
+                    // Commit.
+                    __atomic_store_n(&cursor.rpos, rpos + 1, __ATOMIC_RELEASE);
+                    fn(val);
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                // Overrun by the producer, so skip to the oldest element that is still available.
+                const auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_ACQUIRE);
+                const auto next = wpos - static_cast<std::int64_t>(capacity_);
+                if (next > rpos) {
+                    __atomic_fetch_add(&cursor.drops, next - rpos, __ATOMIC_RELAXED);
+                    rpos = next;
+                    __atomic_store_n(&cursor.rpos, rpos, __ATOMIC_RELEASE);
+                }
+            }
+        }
+        return true;
+    }
+    /**
+     * Returns false if a critical consumer would be overrun.
+     */
+    template <typename FnT>
+    bool post(FnT fn) noexcept
+    {
+        static_assert(std::is_nothrow_invocable_v<FnT, ValueT&>);
+        // Only the producer writes the write position.
+        const auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_RELAXED);
+        if (wpos - gate_ >= static_cast<std::int64_t>(capacity_)) {
+            // Avoid scanning the cursors until the cached gate has been reached.
+            gate_ = minCritical(wpos);
+            if (wpos - gate_ >= static_cast<std::int64_t>(capacity_)) {
+                return false;
+            }
+        }
+        auto& elem = impl_->elems[wpos & mask_];
+        __atomic_store_n(&elem.seq, 0, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        fn(elem.val);
+        // Commit.
+        __atomic_store_n(&elem.seq, wpos + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&impl_->wpos, wpos + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+    /**
+     * Returns false if there are no unread elements for the consumer.
+     */
+    bool pop(std::size_t id, ValueT& val) noexcept
+    {
+        return fetch(id, [&val](const ValueT& ref) noexcept { val = ref; });
+    }
+    /**
+     * Returns false if a critical consumer would be overrun.
+     */
+    bool push(const ValueT& val) noexcept
+    {
+        return post([&val](ValueT & ref) noexcept { ref = val; });
+    }
+
+  private:
+    static constexpr std::size_t capacity(std::size_t size) noexcept
+    {
+        return (size - sizeof(Impl)) / sizeof(Elem);
+    }
+    static constexpr std::size_t size(std::size_t capacity) noexcept
+    {
+        return sizeof(Impl) + capacity * sizeof(Elem);
+    }
+    std::int64_t minCritical(std::int64_t wpos) const noexcept
+    {
+        auto min = wpos;
+        for (const auto& cursor : impl_->cursors) {
+            if (__atomic_load_n(&cursor.flags, __ATOMIC_ACQUIRE) & Critical) {
+                min = std::min(min, __atomic_load_n(&cursor.rpos, __ATOMIC_ACQUIRE));
+            }
+        }
+        return min;
+    }
+
+    FileHandle fh_{nullptr};
+    std::uint64_t capacity_{}, mask_{};
+    // Cached lower bound of the critical read positions.
+    std::int64_t gate_{};
+    MMap memMap_{nullptr};
+    Impl* impl_{nullptr};
+};
+
+/**
+ * Initialise file-based BroadcastQueue.
+ */
+template <typename ValueT>
+void createBroadcastQueue(const char* path, std::size_t capacity, mode_t mode)
+{
+    using Elem = typename BroadcastQueue<ValueT>::Elem;
+    using Impl = typename BroadcastQueue<ValueT>::Impl;
+
+    assert(capacity >= 2);
+
+    capacity = nextPow2(capacity);
+    const auto size = sizeof(Impl) + capacity * sizeof(Elem);
+
+    FileHandle fh{os::open(path, O_RDWR | O_CREAT | O_EXCL, mode)};
+    // Extended files are zero-filled, which is the initial state of the queue.
+    os::ftruncate(fh.get(), size);
+}
+
+} // namespace app
+} // namespace swirly
+
+#endif // SWIRLY_APP_BROADCASTQUEUE_HPP
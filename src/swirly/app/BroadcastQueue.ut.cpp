@@ -0,0 +1,87 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "BroadcastQueue.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+BOOST_AUTO_TEST_SUITE(BroadcastQueueSuite)
+
+BOOST_AUTO_TEST_CASE(BroadcastQueueFanOutCase)
+{
+    BroadcastQueue<int> q{4};
+    BOOST_TEST(q.capacity() == 4U);
+
+    const auto a = q.attach(true);
+    const auto b = q.attach(false);
+    BOOST_TEST(a != b);
+
+    BOOST_TEST(q.push(101));
+    BOOST_TEST(q.push(202));
+    BOOST_TEST(q.lag(a) == 2U);
+    BOOST_TEST(q.lag(b) == 2U);
+
+    // Each consumer sees every element.
+    int val{};
+    BOOST_TEST(q.pop(a, val));
+    BOOST_TEST(val == 101);
+    BOOST_TEST(q.pop(a, val));
+    BOOST_TEST(val == 202);
+    BOOST_TEST(!q.pop(a, val));
+
+    BOOST_TEST(q.pop(b, val));
+    BOOST_TEST(val == 101);
+    BOOST_TEST(q.lag(b) == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(BroadcastQueueBackpressureCase)
+{
+    BroadcastQueue<int> q{4};
+
+    const auto a = q.attach(true);
+    const auto b = q.attach(false);
+
+    for (int i{0}; i < 4; ++i) {
+        BOOST_TEST(q.push(i));
+    }
+    // Critical consumer is full.
+    BOOST_TEST(!q.push(4));
+
+    int val{};
+    BOOST_TEST(q.pop(a, val));
+    BOOST_TEST(val == 0);
+    BOOST_TEST(q.push(4));
+
+    // Non-critical consumer has been overrun by one element.
+    BOOST_TEST(q.pop(b, val));
+    BOOST_TEST(val == 1);
+    BOOST_TEST(q.drops(b) == 1U);
+    BOOST_TEST(q.drops(a) == 0U);
+
+    // Detached critical consumer no longer applies backpressure.
+    q.detach(a);
+    for (int i{5}; i < 12; ++i) {
+        BOOST_TEST(q.push(i));
+    }
+    BOOST_TEST(q.pop(b, val));
+    BOOST_TEST(val == 8);
+    BOOST_TEST(q.drops(b) == 7U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_APP_COMPOSITEAGENT_HPP
+#define SWIRLY_APP_COMPOSITEAGENT_HPP
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace swirly {
+inline namespace app {
+
+/**
+ * Multiplex several agents on a single thread.
+ *
+ * Each invocation gives every agent exactly one turn, and returns the total work done. The agent
+ * that goes first is rotated on each invocation, so that no agent is systematically delayed by the
+ * others. Agents should bound the work done in a single turn if they share a thread with agents
+ * that are sensitive to latency.
+ */
+template <typename... AgentsT>
+class CompositeAgent {
+    static_assert(sizeof...(AgentsT) > 0);
+
+  public:
+    enum : std::size_t { Size = sizeof...(AgentsT) };
+
+    explicit CompositeAgent(AgentsT&... agents) noexcept
+    : agents_{agents...}
+    {
+    }
+    ~CompositeAgent() = default;
+
+    // Copy.
+    CompositeAgent(const CompositeAgent&) noexcept = delete;
+    CompositeAgent& operator=(const CompositeAgent&) noexcept = delete;
+
+    // Move.
+    CompositeAgent(CompositeAgent&&) noexcept = delete;
+    CompositeAgent& operator=(CompositeAgent&&) noexcept = delete;
+
+    int operator()() { return invoke(std::index_sequence_for<AgentsT...>{}); }
+
+  private:
+    template <std::size_t... IndexN>
+    int invoke(std::index_sequence<IndexN...>)
+    {
+        int n{0};
+        // Agents from the first in turn to the last, followed by the remainder.
+        ((n += IndexN >= first_ ? std::get<IndexN>(agents_)() : 0), ...);
+        ((n += IndexN < first_ ? std::get<IndexN>(agents_)() : 0), ...);
+        first_ = first_ + 1 < Size ? first_ + 1 : 0;
+        return n;
+    }
+    std::tuple<AgentsT&...> agents_;
+    std::size_t first_{0};
+};
+
+} // namespace app
+} // namespace swirly
+
+#endif // SWIRLY_APP_COMPOSITEAGENT_HPP
@@ -0,0 +1,60 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "CompositeAgent.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+using namespace std;
+using namespace swirly;
+
+BOOST_AUTO_TEST_SUITE(CompositeAgentSuite)
+
+BOOST_AUTO_TEST_CASE(CompositeAgentCase)
+{
+    string order;
+    auto a = [&order]() {
+        order += 'a';
+        return 1;
+    };
+    auto b = [&order]() {
+        order += 'b';
+        return 0;
+    };
+    auto c = [&order]() {
+        order += 'c';
+        return 2;
+    };
+    CompositeAgent agent{a, b, c};
+    BOOST_TEST(agent.Size == 3U);
+
+    // Every agent has one turn per invocation, and the first turn is rotated.
+    BOOST_TEST(agent() == 3);
+    BOOST_TEST(order == "abc");
+    order.clear();
+    BOOST_TEST(agent() == 3);
+    BOOST_TEST(order == "bca");
+    order.clear();
+    BOOST_TEST(agent() == 3);
+    BOOST_TEST(order == "cab");
+    order.clear();
+    BOOST_TEST(agent() == 3);
+    BOOST_TEST(order == "abc");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,267 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_APP_FRAMEQUEUE_HPP
+#define SWIRLY_APP_FRAMEQUEUE_HPP
+
+#include <swirly/app/MemQueue.hpp>
+
+namespace swirly {
+inline namespace app {
+
+/**
+ * Single-producer, single-consumer queue of variable-length records.
+ *
+ * Each record is framed by a header holding the payload size and type, and is padded to a multiple
+ * of FrameAlign bytes, so that several small records may share a cache-line. Records are never
+ * split across the end of the buffer; a padding frame is used to skip the remainder instead.
+ */
+class FrameQueue {
+  public:
+    enum : std::size_t { FrameAlign = 8 };
+    enum : std::int32_t { Padding = -1 };
+
+    struct FrameHeader {
+        std::uint32_t size;
+        std::int32_t type;
+    };
+    static_assert(sizeof(FrameHeader) == FrameAlign);
+
+    // Identifies a file-based queue and its layout.
+    enum : std::uint64_t { Magic = 0x53574952'4c594651 };
+    enum : std::uint32_t { Version = 1 };
+
+    struct alignas(CacheLineSize) Impl {
+        // Written once when the queue is created.
+        std::uint64_t magic;
+        std::uint32_t version;
+        // Ensure that read and write positions are in different cache-lines.
+        alignas(CacheLineSize) std::int64_t rpos;
+        alignas(CacheLineSize) std::int64_t wpos;
+        alignas(CacheLineSize) char data[];
+    };
+    static_assert(std::is_trivially_copyable_v<Impl>);
+    static_assert(sizeof(Impl) == 3 * CacheLineSize);
+    static_assert(offsetof(Impl, magic) == 0 * CacheLineSize);
+    static_assert(offsetof(Impl, rpos) == 1 * CacheLineSize);
+    static_assert(offsetof(Impl, wpos) == 2 * CacheLineSize);
+    static_assert(offsetof(Impl, data) == 3 * CacheLineSize);
+
+    /**
+     * Returns the number of bytes occupied by a record with the specified payload size.
+     */
+    static constexpr std::size_t frameSize(std::size_t size) noexcept
+    {
+        return (sizeof(FrameHeader) + size + FrameAlign - 1) & ~(FrameAlign - 1);
+    }
+
+    FrameQueue(std::nullptr_t = nullptr) noexcept {}
+    /**
+     * @param capacity Capacity in bytes.
+     */
+    explicit FrameQueue(std::size_t capacity)
+    : capacity_{nextPow2(std::max<std::size_t>(capacity, CacheLineSize))}
+    , mask_{capacity_ - 1}
+    , memMap_{os::mmap(nullptr, sizeof(Impl) + capacity_, PROT_READ | PROT_WRITE,
+                       MAP_ANON | MAP_PRIVATE, -1, 0)}
+    , impl_{static_cast<Impl*>(memMap_.get().data())}
+    {
+        impl_->magic = Magic;
+        impl_->version = Version;
+    }
+    /**
+     * Open a queue created by createFrameQueue(). Files with a different layout, including those
+     * created by earlier versions, are rejected.
+     */
+    explicit FrameQueue(const char* path)
+    : fh_{os::open(path, O_RDWR)}
+    , capacity_{detail::fileSize(fh_.get()) - sizeof(Impl)}
+    , mask_{capacity_ - 1}
+    , memMap_{os::mmap(nullptr, sizeof(Impl) + capacity_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fh_.get(), 0)}
+    , impl_{static_cast<Impl*>(memMap_.get().data())}
+    {
+        if (impl_->magic != Magic) {
+            throw std::runtime_error{"not a frame queue"};
+        }
+        if (impl_->version != Version) {
+            throw std::runtime_error{"unsupported frame queue version"};
+        }
+        if (!isPow2(capacity_)) {
+            throw std::runtime_error{"capacity not a power of two"};
+        }
+    }
+    ~FrameQueue() = default;
+
+    // Copy.
+    FrameQueue(const FrameQueue& rhs) = delete;
+    FrameQueue& operator=(const FrameQueue& rhs) = delete;
+
+    // Move.
+    FrameQueue(FrameQueue&& rhs) noexcept
+    : fh_{std::move(rhs.fh_)}
+    , capacity_{rhs.capacity_}
+    , mask_{rhs.mask_}
+    , memMap_{std::move(rhs.memMap_)}
+    , impl_{rhs.impl_}
+    {
+        rhs.capacity_ = 0;
+        rhs.mask_ = 0;
+        rhs.impl_ = nullptr;
+    }
+    FrameQueue& operator=(FrameQueue&& rhs) noexcept
+    {
+        reset();
+        swap(rhs);
+        return *this;
+    }
+
+    /**
+     * Returns the capacity in bytes.
+     */
+    std::size_t capacity() const noexcept { return capacity_; }
+    /**
+     * Returns true if the queue is empty.
+     */
+    bool empty() const noexcept { return size() == 0; }
+    /**
+     * Returns the number of unused bytes.
+     */
+    std::size_t reserve() const noexcept { return capacity_ - size(); }
+    /**
+     * Returns the number of bytes in use, including headers and padding.
+     */
+    std::size_t size() const noexcept
+    {
+        // Acquire prevents reordering of these loads.
+        const auto rpos = __atomic_load_n(&impl_->rpos, __ATOMIC_ACQUIRE);
+        const auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_RELAXED);
+        return wpos - rpos;
+    }
+    void reset(std::nullptr_t = nullptr) noexcept
+    {
+        // Reverse order.
+        impl_ = nullptr;
+        memMap_.reset(nullptr);
+        mask_ = 0;
+        capacity_ = 0;
+        fh_.reset(nullptr);
+    }
+    void swap(FrameQueue& rhs) noexcept
+    {
+        fh_.swap(rhs.fh_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(mask_, rhs.mask_);
+        memMap_.swap(rhs.memMap_);
+        std::swap(impl_, rhs.impl_);
+    }
+    /**
+     * Invoke function with the type, payload and payload size of the next record. The record is
+     * only consumed if the function returns normally.
+     *
+     * Returns false if queue is empty.
+     */
+    template <typename FnT>
+    bool fetch(FnT fn)
+    {
+        // Only the consumer writes the read position.
+        auto rpos = __atomic_load_n(&impl_->rpos, __ATOMIC_RELAXED);
+        const auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_ACQUIRE);
+        if (rpos == wpos) {
+            return false;
+        }
+        auto* hdr = header(rpos);
+        if (hdr->type == Padding) {
+            rpos += frameSize(hdr->size);
+            __atomic_store_n(&impl_->rpos, rpos, __ATOMIC_RELEASE);
+            // The producer only writes padding when it is followed by a record.
+            hdr = header(rpos);
+        }
+        fn(hdr->type, reinterpret_cast<const char*>(hdr + 1), std::size_t{hdr->size});
+        // Commit.
+        __atomic_store_n(&impl_->rpos, rpos + frameSize(hdr->size), __ATOMIC_RELEASE);
+        return true;
+    }
+    /**
+     * Invoke function with a pointer to the payload, which must be filled with exactly size bytes.
+     *
+     * Returns false if capacity is exceeded.
+     */
+    template <typename FnT>
+    bool post(std::int32_t type, std::size_t size, FnT fn) noexcept
+    {
+        static_assert(std::is_nothrow_invocable_v<FnT, char*>);
+        const auto len = static_cast<std::int64_t>(frameSize(size));
+        // Only the producer writes the write position.
+        auto wpos = __atomic_load_n(&impl_->wpos, __ATOMIC_RELAXED);
+        const auto rpos = __atomic_load_n(&impl_->rpos, __ATOMIC_ACQUIRE);
+        // Space remaining before the end of the buffer.
+        const auto tail = static_cast<std::int64_t>(capacity_ - (wpos & mask_));
+        const auto need = tail < len ? tail + len : len;
+        if (wpos + need - rpos > static_cast<std::int64_t>(capacity_)) {
+            return false;
+        }
+        if (tail < len) {
+            auto* const pad = header(wpos);
+            pad->size = tail - sizeof(FrameHeader);
+            pad->type = Padding;
+            wpos += tail;
+        }
+        auto* const hdr = header(wpos);
+        fn(reinterpret_cast<char*>(hdr + 1));
+        hdr->size = size;
+        hdr->type = type;
+        // Commit.
+        __atomic_store_n(&impl_->wpos, wpos + len, __ATOMIC_RELEASE);
+        return true;
+    }
+
+  private:
+    FrameHeader* header(std::int64_t pos) const noexcept
+    {
+        return reinterpret_cast<FrameHeader*>(&impl_->data[pos & mask_]);
+    }
+
+    FileHandle fh_{nullptr};
+    std::uint64_t capacity_{}, mask_{};
+    MMap memMap_{nullptr};
+    Impl* impl_{nullptr};
+};
+
+/**
+ * Initialise file-based FrameQueue.
+ *
+ * @param capacity Capacity in bytes.
+ */
+inline void createFrameQueue(const char* path, std::size_t capacity, mode_t mode)
+{
+    capacity = nextPow2(std::max<std::size_t>(capacity, CacheLineSize));
+
+    FileHandle fh{os::open(path, O_RDWR | O_CREAT | O_EXCL, mode)};
+    // Extended files are zero-filled, which is the initial state of the queue.
+    os::ftruncate(fh.get(), sizeof(FrameQueue::Impl) + capacity);
+
+    MMap mm{os::mmap(nullptr, sizeof(FrameQueue::Impl), PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fh.get(), 0)};
+    auto* const impl = static_cast<FrameQueue::Impl*>(mm.get().data());
+    impl->magic = FrameQueue::Magic;
+    impl->version = FrameQueue::Version;
+}
+
+} // namespace app
+} // namespace swirly
+
+#endif // SWIRLY_APP_FRAMEQUEUE_HPP
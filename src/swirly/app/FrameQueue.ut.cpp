@@ -0,0 +1,144 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "FrameQueue.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+bool post(FrameQueue& q, int type, const char* str)
+{
+    const auto len = strlen(str);
+    return q.post(type, len, [str, len](char* data) noexcept { memcpy(data, str, len); });
+}
+
+string fetch(FrameQueue& q, int& type)
+{
+    string s;
+    q.fetch([&s, &type](int32_t t, const char* data, size_t size) {
+        type = t;
+        s.assign(data, size);
+    });
+    return s;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FrameQueueSuite)
+
+BOOST_AUTO_TEST_CASE(FrameQueueFrameSizeCase)
+{
+    BOOST_TEST(FrameQueue::frameSize(0) == 8U);
+    BOOST_TEST(FrameQueue::frameSize(1) == 16U);
+    BOOST_TEST(FrameQueue::frameSize(8) == 16U);
+    BOOST_TEST(FrameQueue::frameSize(9) == 24U);
+}
+
+BOOST_AUTO_TEST_CASE(FrameQueueBasicCase)
+{
+    FrameQueue q{64};
+    BOOST_TEST(q.capacity() == 64U);
+    BOOST_TEST(q.empty());
+
+    // Several small records share a cache-line.
+    BOOST_TEST(post(q, 1, "foo"));
+    BOOST_TEST(post(q, 2, "barbaz"));
+    BOOST_TEST(q.size() == 32U);
+
+    int type{};
+    BOOST_TEST(fetch(q, type) == "foo");
+    BOOST_TEST(type == 1);
+    BOOST_TEST(fetch(q, type) == "barbaz");
+    BOOST_TEST(type == 2);
+    BOOST_TEST(q.empty());
+    BOOST_TEST(!q.fetch([](int32_t, const char*, size_t) {}));
+}
+
+BOOST_AUTO_TEST_CASE(FrameQueueWrapCase)
+{
+    FrameQueue q{64};
+    int type{};
+
+    // 24 bytes.
+    BOOST_TEST(post(q, 1, "0123456789"));
+    // 24 bytes.
+    BOOST_TEST(post(q, 2, "abcdefghij"));
+    BOOST_TEST(fetch(q, type) == "0123456789");
+
+    // 24 bytes does not fit in the remaining 16 bytes, so the record is preceded by padding.
+    BOOST_TEST(post(q, 3, "ABCDEFGHIJ"));
+    BOOST_TEST(q.size() == 64U);
+    BOOST_TEST(!post(q, 4, ""));
+
+    BOOST_TEST(fetch(q, type) == "abcdefghij");
+    BOOST_TEST(type == 2);
+    BOOST_TEST(fetch(q, type) == "ABCDEFGHIJ");
+    BOOST_TEST(type == 3);
+    BOOST_TEST(q.empty());
+
+    // Larger than capacity.
+    BOOST_TEST(!post(q, 5, string(64, 'x').c_str()));
+}
+
+BOOST_AUTO_TEST_CASE(FrameQueueThrowCase)
+{
+    FrameQueue q{64};
+    BOOST_TEST(post(q, 1, "foo"));
+
+    // Record is not consumed if the function throws.
+    BOOST_CHECK_THROW(
+        q.fetch([](int32_t, const char*, size_t) { throw runtime_error{"error"}; }),
+        runtime_error);
+    int type{};
+    BOOST_TEST(fetch(q, type) == "foo");
+}
+
+BOOST_AUTO_TEST_CASE(FrameQueueFileCase)
+{
+    char path[] = "/tmp/swirly-frameq-XXXXXX";
+    close(mkstemp(path));
+    unlink(path);
+    createFrameQueue(path, 64, 0644);
+    {
+        FrameQueue writer{path};
+        FrameQueue reader{path};
+        BOOST_TEST(writer.capacity() == 64U);
+        BOOST_TEST(post(writer, 1, "foo"));
+        int type{};
+        BOOST_TEST(fetch(reader, type) == "foo");
+        BOOST_TEST(type == 1);
+    }
+    unlink(path);
+
+    // Files without the expected header are rejected.
+    char bad[] = "/tmp/swirly-frameq-XXXXXX";
+    const int fd{mkstemp(bad)};
+    BOOST_TEST(ftruncate(fd, sizeof(FrameQueue::Impl) + 64) == 0);
+    close(fd);
+    BOOST_CHECK_THROW(FrameQueue{bad}, runtime_error);
+    unlink(bad);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,14 @@
 #include <swirly/sys/File.hpp>
 #include <swirly/sys/MMap.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
 #include <fcntl.h>
 
 namespace swirly {
@@ -28,6 +36,85 @@ inline namespace app {
 using namespace std;
 namespace {
 
+constexpr size_t BlockSizes[] = {1 << 6,  2 << 6,  3 << 6,   4 << 6,   8 << 6,
+                                 16 << 6, 32 << 6, 64 << 6, 128 << 6, 256 << 6};
+static_assert(size(BlockSizes) == MemCtx::SizeClasses);
+
+// Maximum number of blocks held by a thread cache per size-class. Larger blocks are cached in
+// smaller numbers, so that no magazine holds more than 64KiB. Half a magazine is moved between a
+// thread cache and the shared pool at a time.
+constexpr MemSize MagazineSizes[] = {32, 32, 32, 32, 32, 32, 32, 16, 8, 4};
+static_assert(size(MagazineSizes) == MemCtx::SizeClasses);
+
+// Number of contexts that a thread can allocate from without flushing its cache on each switch,
+// such as an engine context and a persistent image.
+constexpr size_t ThreadCaches{4};
+
+/**
+ * Returns the size-class for the specified allocation size, or SizeClasses if the allocation must
+ * be satisfied by a run of whole pages.
+ */
+size_t sizeClass(size_t size) noexcept
+{
+    enum { Max = (1 << CacheLineBits) - 1 };
+    const auto cacheLines = (size + Max) >> CacheLineBits;
+    switch (nextPow2(cacheLines)) {
+    case 1: // 64
+        return 0;
+    case 2: // 128
+        return 1;
+    case 4: // 192 or 256
+        return cacheLines == 3 ? 2 : 3;
+    case 8: // 512
+        return 4;
+    case 16: // 1024
+        return 5;
+    case 32: // 2048
+        return 6;
+    case 64: // 4096
+        return 7;
+    case 128: // 8192
+        return 8;
+    case 256: // 16384
+        return 9;
+    }
+    return MemCtx::SizeClasses;
+}
+
+/**
+ * Thread-local stack of free blocks, linked by raw addresses stored in the first word of each
+ * block.
+ */
+struct Magazine {
+    void* pop() noexcept
+    {
+        assert(count > 0);
+        auto* const node = static_cast<MemNode<1>*>(head);
+        head = reinterpret_cast<void*>(node->next);
+        --count;
+        return node;
+    }
+    void push(void* addr) noexcept
+    {
+        static_cast<MemNode<1>*>(addr)->next = reinterpret_cast<uintptr_t>(head);
+        head = addr;
+        ++count;
+    }
+    void* head{nullptr};
+    MemSize count{0};
+};
+
+/**
+ * Allocation counters for a size-class. Only the owning thread writes them, so updates are plain
+ * stores, but they may be read concurrently by other threads.
+ */
+struct Counters {
+    uint64_t allocs{0};
+    uint64_t frees{0};
+    // Peak of allocs less frees, which may be negative if blocks are freed on another thread.
+    int64_t highWater{0};
+};
+
 FileHandle reserveFile(const char* path, size_t size)
 {
     FileHandle fh{os::open(path, O_RDWR | O_CREAT, 0644)};
@@ -35,103 +122,482 @@ FileHandle reserveFile(const char* path, size_t size)
     return fh;
 }
 
+// Identifies the layout of a file-backed pool.
+constexpr uint64_t MemMagic{0x53574952'4c590001};
+
+// Default huge page size on x86-64.
+constexpr size_t HugePageSize{2 << 20};
+
+bool transparentEnabled()
+{
+    ifstream is{"/sys/kernel/mm/transparent_hugepage/enabled"};
+    string line;
+    return getline(is, line) && line.find("[never]") == string::npos;
+}
+
+void adviseHuge(const MMap& memMap, MemInfo& info) noexcept
+{
+    info.transparent = madvise(memMap.get().data(), memMap.get().size(), MADV_HUGEPAGE) == 0
+        && transparentEnabled();
+}
+
+MMap mapAnon(size_t size, const MemOpts& opts, MemInfo& info)
+{
+    if (opts.hugePages) {
+        // Huge page mappings must be a whole number of huge pages.
+        error_code ec;
+        auto memMap = os::mmap(nullptr, (size + HugePageSize - 1) & ~(HugePageSize - 1),
+                               PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_HUGETLB, -1, 0,
+                               ec);
+        if (!ec) {
+            info.pageSize = HugePageSize;
+            return memMap;
+        }
+    }
+    auto memMap = os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (opts.hugePages) {
+        adviseHuge(memMap, info);
+    }
+    return memMap;
+}
+
+MMap mapFile(int fd, size_t size, const MemOpts& opts, MemInfo& info)
+{
+    auto memMap = os::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (opts.hugePages) {
+        adviseHuge(memMap, info);
+    }
+    return memMap;
+}
+
+void prefault(const MMap& memMap, bool anon) noexcept
+{
+    auto* const first = static_cast<volatile char*>(memMap.get().data());
+    auto* const last = first + memMap.get().size();
+    for (auto* p = first; p < last; p += PageSize) {
+        if (anon) {
+            // Fresh anonymous memory is zero-filled, so a write is harmless and avoids mapping the
+            // shared zero page.
+            *p = 0;
+        } else {
+            // A shared pool may already be in use.
+            static_cast<void>(*p);
+        }
+    }
+}
+
+// Identifiers of live contexts. A thread cache may only be flushed to a context that is still live.
+mutex liveMutex;
+vector<uint64_t> liveIds;
+atomic<uint64_t> lastId{0};
+
+bool isLive(uint64_t id)
+{
+    return find(liveIds.begin(), liveIds.end(), id) != liveIds.end();
+}
+
 } // namespace
 
 struct MemCtx::Impl {
-    explicit Impl(size_t maxSize)
+    struct Cache {
+        ~Cache()
+        {
+            lock_guard<mutex> lock{liveMutex};
+            if (impl && isLive(id)) {
+                impl->detach(*this);
+            }
+        }
+        void reset() noexcept
+        {
+            id = 0;
+            impl = nullptr;
+            fill(begin(mags), end(mags), Magazine{});
+            fill(begin(ctrs), end(ctrs), Counters{});
+        }
+        uint64_t id{0};
+        Impl* impl{nullptr};
+        Magazine mags[SizeClasses];
+        Counters ctrs[SizeClasses];
+    };
+
+    Impl(size_t maxSize, const MemOpts& opts)
     : maxSize{maxSize}
-    , memMap{os::mmap(nullptr, PageSize + maxSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE,
-                      -1, 0)}
+    , overflow{opts.overflow}
+    , memMap{mapAnon(PageSize + maxSize, opts, info)}
     , pool(*static_cast<MemPool*>(memMap.get().data()))
     {
+        init(opts, true);
     }
-    Impl(const char* path, size_t maxSize)
+    Impl(const char* path, size_t maxSize, const MemOpts& opts)
     : maxSize{maxSize}
+    // The contents of a file-backed pool must lie within the pool.
+    , overflow{false}
     , fh{reserveFile(path, PageSize + maxSize)}
-    , memMap{os::mmap(nullptr, PageSize + maxSize, PROT_READ | PROT_WRITE, MAP_SHARED, fh.get(), 0)}
+    , memMap{mapFile(fh.get(), PageSize + maxSize, opts, info)}
     , pool(*static_cast<MemPool*>(memMap.get().data()))
     {
+        // A pool that was not shut down cleanly may have been left mid-update.
+        warm = pool.magic == MemMagic && pool.clean != 0 && pool.offset <= maxSize;
+        if (!warm) {
+            memset(&pool, 0, sizeof(MemPool));
+            pool.magic = MemMagic;
+        }
+        pool.clean = 0;
+        init(opts, false);
+    }
+    ~Impl()
+    {
+        lock_guard<mutex> lock{liveMutex};
+        liveIds.erase(find(liveIds.begin(), liveIds.end(), id));
+        // Blocks cached by other threads are abandoned along with the memory-map.
+        for (auto& c : threadCaches) {
+            if (c.id == id) {
+                c.reset();
+            }
+        }
     }
     void* alloc(size_t size)
     {
-        void* addr;
-        enum { Max = (1 << CacheLineBits) - 1 };
-        const auto cacheLines = (size + Max) >> CacheLineBits;
-        switch (nextPow2(cacheLines)) {
-        case 1: // 64
-            addr = allocBlock(pool, pool.free1, maxSize);
-            break;
-        case 2: // 128
-            addr = allocBlock(pool, pool.free2, maxSize);
-            break;
-        case 4:
-            if (cacheLines == 3) {
-                // 192
-                addr = allocBlock(pool, pool.free3, maxSize);
-            } else {
-                // 256
-                addr = allocBlock(pool, pool.free4, maxSize);
+        void* const addr{allocPool(size)};
+        if (addr) {
+            return addr;
+        }
+        if (!overflow) {
+            throw bad_alloc{};
+        }
+        return allocHeap(size);
+    }
+    /**
+     * Returns null if the pool is exhausted.
+     */
+    void* allocPool(size_t size) noexcept
+    {
+        const auto sc = sizeClass(size);
+        if (sc == SizeClasses) {
+            return allocLarge(size);
+        }
+        auto& c = cache();
+        auto& mag = c.mags[sc];
+        if (mag.count == 0) {
+            const MemSize batch{MagazineSizes[sc] / 2};
+            MemSize carved{0};
+            visit(sc, [this, &mag, batch, &carved](auto& stack) {
+                carved = this->refill(stack, mag, batch);
+            });
+            refills[sc].fetch_add(1, memory_order_relaxed);
+            if (carved > 0) {
+                reserved[sc].fetch_add(carved * BlockSizes[sc], memory_order_relaxed);
+            } else if (mag.count == 0) {
+                return nullptr;
             }
-            break;
-        case 8: // 512
-            addr = allocBlock(pool, pool.free8, maxSize);
-            break;
-        case 16: // 1024
-            addr = allocBlock(pool, pool.free16, maxSize);
-            break;
-        case 32: // 2048
-            addr = allocBlock(pool, pool.free32, maxSize);
-            break;
-        default:
+        }
+        auto& ctr = c.ctrs[sc];
+        __atomic_store_n(&ctr.allocs, ctr.allocs + 1, __ATOMIC_RELAXED);
+        const auto live = static_cast<int64_t>(ctr.allocs - ctr.frees);
+        if (live > ctr.highWater) {
+            __atomic_store_n(&ctr.highWater, live, __ATOMIC_RELAXED);
+        }
+        return mag.pop();
+    }
+    void dealloc(void* addr, size_t size) noexcept
+    {
+        if (overflow && !contains(addr)) {
+            free(addr);
+            return;
+        }
+        const auto sc = sizeClass(size);
+        if (sc == SizeClasses) {
+            deallocLarge(addr, size);
+            return;
+        }
+        auto& c = cache();
+        auto& mag = c.mags[sc];
+        if (mag.count == MagazineSizes[sc]) {
+            const MemSize batch{MagazineSizes[sc] / 2};
+            visit(sc, [this, &mag, batch](auto& stack) { this->flush(stack, mag, batch); });
+            flushes[sc].fetch_add(1, memory_order_relaxed);
+        }
+        auto& ctr = c.ctrs[sc];
+        __atomic_store_n(&ctr.frees, ctr.frees + 1, __ATOMIC_RELAXED);
+        mag.push(addr);
+    }
+    MemStats stats(size_t sc) const
+    {
+        MemStats st{};
+        st.refills = refills[sc].load(memory_order_relaxed);
+        st.flushes = flushes[sc].load(memory_order_relaxed);
+        st.reserved = reserved[sc].load(memory_order_relaxed);
+
+        lock_guard<mutex> lock{liveMutex};
+        st.allocs = retired[sc].allocs;
+        st.frees = retired[sc].frees;
+        // Summed across threads, this is an upper bound when blocks are freed on another thread.
+        int64_t highWater{retired[sc].highWater};
+        for (const auto* c : caches) {
+            const auto& ctr = c->ctrs[sc];
+            st.allocs += __atomic_load_n(&ctr.allocs, __ATOMIC_RELAXED);
+            st.frees += __atomic_load_n(&ctr.frees, __ATOMIC_RELAXED);
+            highWater += __atomic_load_n(&ctr.highWater, __ATOMIC_RELAXED);
+        }
+        st.live = st.allocs - st.frees;
+        st.highWater = max<int64_t>(highWater, st.live);
+        return st;
+    }
+    MemStats largeStats() const noexcept
+    {
+        MemStats st{};
+        st.allocs = largeAllocs.load(memory_order_relaxed);
+        st.frees = largeFrees.load(memory_order_relaxed);
+        st.live = st.allocs - st.frees;
+        st.highWater = max(largeHighWater.load(memory_order_relaxed), st.live);
+        st.reserved = largeReserved.load(memory_order_relaxed);
+        return st;
+    }
+    void persist(void* root) noexcept
+    {
+        {
+            lock_guard<mutex> lock{liveMutex};
+            for (auto& c : threadCaches) {
+                if (c.id == id) {
+                    detach(c);
+                    c.reset();
+                }
+            }
+        }
+        pool.root = root ? ptrToOffset(pool, root) + 1 : 0;
+        // Ensure that the contents are written before the marker.
+        msync(memMap.get().data(), memMap.get().size(), MS_SYNC);
+        pool.clean = 1;
+        msync(&pool, PageSize, MS_SYNC);
+    }
+    const size_t maxSize;
+    const bool overflow;
+    const uint64_t id{++lastId};
+    MemInfo info{PageSize, false, false, false};
+    bool warm{false};
+    FileHandle fh;
+    MMap memMap;
+    MemPool& pool;
+    atomic<uint64_t> refills[SizeClasses]{};
+    atomic<uint64_t> flushes[SizeClasses]{};
+    // Bytes carved from unreserved memory.
+    atomic<uint64_t> reserved[SizeClasses]{};
+    // Caches bound to this context, and the counters of those that have since detached. Both are
+    // guarded by liveMutex.
+    vector<Cache*> caches;
+    Counters retired[SizeClasses];
+    atomic<uint64_t> largeAllocs{0}, largeFrees{0}, largeHighWater{0}, largeReserved{0};
+    // Allocations satisfied by the system heap once the pool was exhausted.
+    atomic<uint64_t> overflows{0};
+
+  private:
+    void init(const MemOpts& opts, bool anon)
+    {
+        if (opts.prefault) {
+            prefault(memMap, anon);
+            info.prefaulted = true;
+        }
+        if (opts.lock) {
+            // Failure is reported through info, typically due to RLIMIT_MEMLOCK.
+            info.locked = mlock(memMap.get().data(), memMap.get().size()) == 0;
+        }
+        lock_guard<mutex> lock{liveMutex};
+        liveIds.push_back(id);
+    }
+    /**
+     * Returns the calling thread's cache for this context, binding one if there is none.
+     */
+    Cache& cache() noexcept
+    {
+        for (auto& c : threadCaches) {
+            if (c.id == id) {
+                return c;
+            }
+        }
+        return bind();
+    }
+    Cache& bind() noexcept
+    {
+        lock_guard<mutex> lock{liveMutex};
+        // Prefer a cache that is unused, or bound to a context that no longer exists, over evicting
+        // the cache of a live context.
+        Cache* c{nullptr};
+        for (auto& x : threadCaches) {
+            if (!x.impl || !isLive(x.id)) {
+                c = &x;
+                break;
+            }
+        }
+        if (!c) {
+            c = &threadCaches[nextEvict++ % ThreadCaches];
+            c->impl->detach(*c);
+        }
+        c->reset();
+        c->id = id;
+        c->impl = this;
+        caches.push_back(c);
+        return *c;
+    }
+    /**
+     * Flush cache and fold its counters into the retired totals. The caller must hold liveMutex.
+     */
+    void detach(Cache& c) noexcept
+    {
+        for (size_t sc{0}; sc < SizeClasses; ++sc) {
+            auto& mag = c.mags[sc];
+            if (mag.count > 0) {
+                visit(sc, [this, &mag](auto& stack) { this->flush(stack, mag, mag.count); });
+                flushes[sc].fetch_add(1, memory_order_relaxed);
+            }
+            const auto& ctr = c.ctrs[sc];
+            retired[sc].allocs += ctr.allocs;
+            retired[sc].frees += ctr.frees;
+            retired[sc].highWater += ctr.highWater;
+        }
+        caches.erase(find(caches.begin(), caches.end(), &c));
+    }
+    /**
+     * Large objects are allocated as runs of whole pages, which are neither cached per thread nor
+     * split into blocks.
+     */
+    bool contains(const void* addr) const noexcept
+    {
+        const auto* const first = static_cast<const char*>(memMap.get().data());
+        return addr >= first && addr < first + memMap.get().size();
+    }
+    void* allocHeap(size_t size)
+    {
+        // Cache-line aligned, like the blocks in the pool.
+        const auto len = (size + CacheLineSize - 1) & ~(CacheLineSize - 1);
+        void* const addr{aligned_alloc(CacheLineSize, len)};
+        if (!addr) {
             throw bad_alloc{};
         }
+        overflows.fetch_add(1, memory_order_relaxed);
         return addr;
     }
-    void dealloc(void* addr, size_t size) noexcept
+    void* allocLarge(size_t size) noexcept
     {
-        const auto cacheLines = size >> CacheLineBits;
-        switch (nextPow2(cacheLines)) {
-        case 1: // 64
-            deallocBlock(pool, pool.free1, addr);
+        const auto pages = static_cast<MemSize>(ceilPage(size) >> PageBits);
+        void* addr{popRun(pool, pages)};
+        if (!addr) {
+            const auto offset = tryReservePages(pool, pages, maxSize);
+            if (offset == NoOffset) {
+                return nullptr;
+            }
+            addr = offsetToPtr(pool, offset);
+            largeReserved.fetch_add(pages * PageSize, memory_order_relaxed);
+        }
+        const auto allocs = largeAllocs.fetch_add(1, memory_order_relaxed) + 1;
+        const auto live = allocs - largeFrees.load(memory_order_relaxed);
+        auto highWater = largeHighWater.load(memory_order_relaxed);
+        while (live > highWater
+               && !largeHighWater.compare_exchange_weak(highWater, live, memory_order_relaxed)) {
+        }
+        return addr;
+    }
+    void deallocLarge(void* addr, size_t size) noexcept
+    {
+        pushRun(pool, addr, ceilPage(size) >> PageBits);
+        largeFrees.fetch_add(1, memory_order_relaxed);
+    }
+    template <typename FnT>
+    void visit(size_t sc, FnT fn) noexcept
+    {
+        switch (sc) {
+        case 0:
+            fn(pool.free1);
+            break;
+        case 1:
+            fn(pool.free2);
             break;
-        case 2: // 128
-            deallocBlock(pool, pool.free2, addr);
+        case 2:
+            fn(pool.free3);
+            break;
+        case 3:
+            fn(pool.free4);
             break;
         case 4:
-            if (cacheLines == 3) {
-                // 192
-                deallocBlock(pool, pool.free3, addr);
-            } else {
-                // 256
-                deallocBlock(pool, pool.free4, addr);
-            }
+            fn(pool.free8);
             break;
-        case 8: // 512
-            deallocBlock(pool, pool.free8, addr);
+        case 5:
+            fn(pool.free16);
             break;
-        case 16: // 1024
-            deallocBlock(pool, pool.free16, addr);
+        case 6:
+            fn(pool.free32);
             break;
-        case 32: // 2048
-            deallocBlock(pool, pool.free32, addr);
+        case 7:
+            fn(pool.free64);
+            break;
+        case 8:
+            fn(pool.free128);
+            break;
+        case 9:
+            fn(pool.free256);
             break;
-        default:
-            abort();
         }
     }
-    const size_t maxSize;
-    FileHandle fh;
-    MMap memMap;
-    MemPool& pool;
+    /**
+     * Returns the number of blocks carved from unreserved memory, which is zero if the magazine was
+     * refilled from the free list or the pool is exhausted.
+     */
+    template <size_t SizeN>
+    MemSize refill(MemStack<SizeN>& stack, Magazine& mag, MemSize batch) noexcept
+    {
+        // Prefer blocks from the shared free list.
+        for (MemSize i{0}; i < batch; ++i) {
+            auto* const node = pop(pool, stack);
+            if (!node) {
+                break;
+            }
+            mag.push(node);
+        }
+        if (mag.count == 0) {
+            // Carve a batch from unreserved memory with a single reservation.
+            MemSize n{batch};
+            auto offset = tryReserve(pool, n * SizeN, maxSize);
+            if (offset == NoOffset) {
+                // Fall back to a single block when the pool is nearly exhausted.
+                n = 1;
+                offset = tryReserve(pool, SizeN, maxSize);
+                if (offset == NoOffset) {
+                    return 0;
+                }
+            }
+            // Push in reverse so that blocks are handed out in address order.
+            for (auto i = n; i-- > 0;) {
+                mag.push(offsetToPtr(pool, offset + i * SizeN));
+            }
+            return n;
+        }
+        return 0;
+    }
+    template <size_t SizeN>
+    void flush(MemStack<SizeN>& stack, Magazine& mag, MemSize n) noexcept
+    {
+        auto* const first = static_cast<MemNode<SizeN>*>(mag.head);
+        auto* last = first;
+        for (MemSize i{1}; i < n; ++i) {
+            last = reinterpret_cast<MemNode<SizeN>*>(last->next);
+        }
+        mag.head = reinterpret_cast<void*>(last->next);
+        mag.count -= n;
+        pushChain(pool, stack, first, n);
+    }
+    static thread_local Cache threadCaches[ThreadCaches];
+    static thread_local size_t nextEvict;
 };
 
-MemCtx::MemCtx(size_t maxSize)
-: impl_{make_unique<Impl>(maxSize)}
+thread_local MemCtx::Impl::Cache MemCtx::Impl::threadCaches[ThreadCaches];
+thread_local size_t MemCtx::Impl::nextEvict{0};
+
+MemCtx::MemCtx(size_t maxSize, const MemOpts& opts)
+: impl_{make_unique<Impl>(maxSize, opts)}
 {
 }
 
-MemCtx::MemCtx(const char* path, size_t maxSize)
-: impl_{make_unique<Impl>(path, maxSize)}
+MemCtx::MemCtx(const char* path, size_t maxSize, const MemOpts& opts)
+: impl_{make_unique<Impl>(path, maxSize, opts)}
 {
 }
 
@@ -143,12 +609,24 @@ MemCtx::~MemCtx() = default;
 MemCtx::MemCtx(MemCtx&&) noexcept = default;
 MemCtx& MemCtx::operator=(MemCtx&&) noexcept = default;
 
-size_t MemCtx::maxSize() noexcept
+size_t MemCtx::maxSize() const noexcept
 {
     assert(impl_);
     return impl_->maxSize;
 }
 
+size_t MemCtx::reserved() const noexcept
+{
+    assert(impl_);
+    return __atomic_load_n(&impl_->pool.offset, __ATOMIC_RELAXED);
+}
+
+MemInfo MemCtx::info() const noexcept
+{
+    assert(impl_);
+    return impl_->info;
+}
+
 void* MemCtx::alloc(size_t size)
 {
     assert(impl_);
@@ -168,5 +646,57 @@ void MemCtx::dealloc(void* addr, size_t size) noexcept
     impl_->dealloc(addr, size);
 }
 
+size_t MemCtx::blockSize(size_t sizeClass) noexcept
+{
+    assert(sizeClass < SizeClasses);
+    return BlockSizes[sizeClass];
+}
+
+MemStats MemCtx::stats(size_t sizeClass) const noexcept
+{
+    assert(impl_);
+    assert(sizeClass < SizeClasses);
+    return impl_->stats(sizeClass);
+}
+
+uint64_t MemCtx::overflows() const noexcept
+{
+    assert(impl_);
+    return impl_->overflows.load(memory_order_relaxed);
+}
+
+MemStats MemCtx::largeStats() const noexcept
+{
+    assert(impl_);
+    return impl_->largeStats();
+}
+
+bool MemCtx::warm() const noexcept
+{
+    assert(impl_);
+    return impl_->warm;
+}
+
+void* MemCtx::root() const noexcept
+{
+    assert(impl_);
+    return rootExtent() > 0 ? offsetToPtr(impl_->pool, impl_->pool.root - 1) : nullptr;
+}
+
+size_t MemCtx::rootExtent() const noexcept
+{
+    assert(impl_);
+    const auto& pool = impl_->pool;
+    const auto offset = __atomic_load_n(&pool.offset, __ATOMIC_RELAXED);
+    // A root beyond the reserved region is treated as absent.
+    return pool.root != 0 && pool.root - 1 < offset ? offset - (pool.root - 1) : 0;
+}
+
+void MemCtx::persist(void* root) noexcept
+{
+    assert(impl_);
+    impl_->persist(root);
+}
+
 } // namespace app
 } // namespace swirly
@@ -20,22 +20,104 @@
 #include <swirly/Config.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace swirly {
 inline namespace app {
 
+/**
+ * Options controlling how the memory pool is backed.
+ */
+struct MemOpts {
+    /**
+     * Back the pool with huge pages, falling back to transparent huge pages if none are reserved.
+     */
+    bool hugePages{false};
+    /**
+     * Touch every page of the pool on construction.
+     */
+    bool prefault{false};
+    /**
+     * Lock the pool into memory.
+     */
+    bool lock{false};
+    /**
+     * Satisfy allocations from the system heap once the pool is exhausted, instead of throwing
+     * std::bad_alloc. Ignored for file-backed pools.
+     */
+    bool overflow{false};
+};
+
+/**
+ * Describes how the memory pool was actually backed.
+ */
+struct MemInfo {
+    /**
+     * Size of the pages mapped for the pool.
+     */
+    std::size_t pageSize;
+    /**
+     * True if the pool is eligible for transparent huge pages.
+     */
+    bool transparent;
+    bool prefaulted;
+    bool locked;
+};
+
+struct MemStats {
+    std::uint64_t allocs;
+    std::uint64_t frees;
+    /**
+     * Number of blocks currently allocated.
+     */
+    std::uint64_t live;
+    /**
+     * Peak number of blocks allocated. This is exact when a size-class is allocated and freed on a
+     * single thread, and an upper bound otherwise.
+     */
+    std::uint64_t highWater;
+    /**
+     * Bytes reserved from the pool for this size-class.
+     */
+    std::uint64_t reserved;
+    /**
+     * Number of times a thread cache was refilled from the shared pool.
+     */
+    std::uint64_t refills;
+    /**
+     * Number of times a thread cache was flushed to the shared pool.
+     */
+    std::uint64_t flushes;
+};
+
+/**
+ * Memory context with a fixed number of size-classes, each a multiple of the cache-line size.
+ * Allocations larger than the largest size-class are satisfied by runs of whole pages from the
+ * same pool.
+ *
+ * Each thread caches a small magazine of free blocks per size-class, so that most allocations and
+ * deallocations do not touch the lock-free free lists shared by all threads. A thread's cache is
+ * bound to the last context it used.
+ *
+ * Blocks are addressed by their offset into the pool, so a file-backed pool that was shut down
+ * cleanly can be remapped at a different address and reused, along with any offset-linked data
+ * held in it.
+ */
+
 class SWIRLY_API MemCtx {
   public:
+    enum : std::size_t { SizeClasses = 10 };
+
     /**
      * This constructor uses a anonymous, private memory-map.
      */
-    explicit MemCtx(std::size_t maxSize);
+    explicit MemCtx(std::size_t maxSize, const MemOpts& opts = {});
 
     /**
      * This constructor uses a shared memory-map.
      */
-    MemCtx(const char* path, std::size_t maxSize);
+    MemCtx(const char* path, std::size_t maxSize, const MemOpts& opts = {});
 
     MemCtx();
     ~MemCtx();
@@ -47,15 +129,70 @@ class SWIRLY_API MemCtx {
     MemCtx(MemCtx&&) noexcept;
     MemCtx& operator=(MemCtx&&) noexcept;
 
-    std::size_t maxSize() noexcept;
+    std::size_t maxSize() const noexcept;
+    /**
+     * Returns the number of bytes reserved from the pool, including large allocations.
+     */
+    std::size_t reserved() const noexcept;
+
+    MemInfo info() const noexcept;
 
     void* alloc(std::size_t size);
 
-    // Requested alignment must not be greater than the size of a cache-line.
+    // Requested alignment must not be greater than the size of a cache-line. Allocations larger than
+    // the largest size-class are page-aligned.
     void* alloc(std::size_t size, std::align_val_t al);
 
     void dealloc(void* addr, std::size_t size) noexcept;
 
+    /**
+     * Returns the block size of the specified size-class.
+     */
+    static std::size_t blockSize(std::size_t sizeClass) noexcept;
+
+    /**
+     * Returns statistics for the specified size-class.
+     */
+    MemStats stats(std::size_t sizeClass) const noexcept;
+
+    /**
+     * Returns statistics for allocations larger than the largest size-class. Refills and flushes
+     * are always zero.
+     */
+    MemStats largeStats() const noexcept;
+
+    /**
+     * Returns the number of allocations satisfied by the system heap because the pool was
+     * exhausted.
+     */
+    std::uint64_t overflows() const noexcept;
+
+    /**
+     * Returns true if a file-backed pool was reopened after a clean shutdown, in which case its
+     * contents are preserved. Otherwise, the pool is empty.
+     */
+    bool warm() const noexcept;
+
+    /**
+     * Returns the root block recorded at the last clean shutdown, or null if there is none.
+     */
+    void* root() const noexcept;
+
+    /**
+     * Returns the number of bytes from the root block to the end of the reserved region, which
+     * bounds the size of the root block, or zero if there is none.
+     */
+    std::size_t rootExtent() const noexcept;
+
+    /**
+     * Records the root block and marks the pool as cleanly shut down. The marker is cleared when
+     * the pool is next opened.
+     *
+     * Blocks cached by the calling thread are returned to the pool, but blocks cached by other
+     * threads are lost, so other threads should have exited.
+     */
+    void persist(void* root) noexcept;
+
   private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
@@ -19,6 +19,10 @@
 #include <boost/test/unit_test.hpp>
 
 #include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace std;
 using namespace swirly;
@@ -64,4 +68,215 @@ BOOST_AUTO_TEST_CASE(MemCtxCase)
     memCtx.dealloc(p2, sizeof(Foo));
 }
 
+BOOST_AUTO_TEST_CASE(MemCtxCacheCase)
+{
+    MemCtx memCtx{1 << 16};
+
+    vector<void*> blocks;
+    for (int i{0}; i < 40; ++i) {
+        blocks.push_back(memCtx.alloc(sizeof(Foo)));
+    }
+    // First refill carves a batch, then the shared free list is empty.
+    BOOST_TEST(memCtx.stats(1).refills == 3U);
+    for (auto* addr : blocks) {
+        memCtx.dealloc(addr, sizeof(Foo));
+    }
+    // The magazine holds at most 32 blocks.
+    BOOST_TEST(memCtx.stats(1).flushes == 1U);
+    BOOST_TEST(memCtx.stats(0).refills == 0U);
+
+    // Blocks freed on another thread are returned to the shared pool when it exits.
+    thread t{[&memCtx]() {
+        auto* addr = memCtx.alloc(sizeof(Foo));
+        memCtx.dealloc(addr, sizeof(Foo));
+    }};
+    t.join();
+    BOOST_TEST(memCtx.stats(1).refills == 4U);
+    BOOST_TEST(memCtx.stats(1).flushes == 2U);
+
+    BOOST_TEST(MemCtx::blockSize(2) == 192U);
+    BOOST_TEST(MemCtx::blockSize(9) == 16384U);
+    // Larger than the remaining pool.
+    BOOST_CHECK_THROW(memCtx.alloc(1 << 16), bad_alloc);
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxSwitchCase)
+{
+    MemCtx a{1 << 16}, b{1 << 16};
+
+    // A thread that alternates between contexts keeps a cache for each, so neither is flushed.
+    for (int i{0}; i < 100; ++i) {
+        a.dealloc(a.alloc(sizeof(Foo)), sizeof(Foo));
+        b.dealloc(b.alloc(sizeof(Foo)), sizeof(Foo));
+    }
+    BOOST_TEST(a.stats(1).refills == 1U);
+    BOOST_TEST(a.stats(1).flushes == 0U);
+    BOOST_TEST(b.stats(1).refills == 1U);
+    BOOST_TEST(b.stats(1).flushes == 0U);
+    BOOST_TEST(a.stats(1).allocs == 100U);
+    BOOST_TEST(b.stats(1).allocs == 100U);
+
+    // Beyond the per-thread limit, caches are evicted and flushed on a switch.
+    vector<MemCtx> ctxs;
+    for (int i{0}; i < 6; ++i) {
+        ctxs.emplace_back(1 << 16);
+    }
+    for (int i{0}; i < 10; ++i) {
+        for (auto& ctx : ctxs) {
+            ctx.dealloc(ctx.alloc(sizeof(Foo)), sizeof(Foo));
+        }
+    }
+    for (auto& ctx : ctxs) {
+        const auto st = ctx.stats(1);
+        BOOST_TEST(st.allocs == 10U);
+        BOOST_TEST(st.live == 0U);
+        BOOST_TEST(st.flushes > 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxLargeCase)
+{
+    MemCtx memCtx{1 << 20};
+
+    // Allocations beyond the largest size-class are whole pages.
+    auto* p1 = static_cast<char*>(memCtx.alloc(5 * 4096 - 100));
+    auto* p2 = static_cast<char*>(memCtx.alloc(5 * 4096));
+    BOOST_TEST(reinterpret_cast<uintptr_t>(p1) % 4096 == 0U);
+    BOOST_TEST(p2 == p1 + 5 * 4096);
+    memset(p1, 0xff, 5 * 4096 - 100);
+    memCtx.dealloc(p1, 5 * 4096 - 100);
+    memCtx.dealloc(p2, 5 * 4096);
+
+    // Adjacent free runs are merged.
+    auto* p3 = static_cast<char*>(memCtx.alloc(10 * 4096));
+    BOOST_TEST(p3 == p1);
+    memCtx.dealloc(p3, 10 * 4096);
+
+    // Free runs are split from the tail.
+    auto* p4 = static_cast<char*>(memCtx.alloc(6 * 4096));
+    BOOST_TEST(p4 == p1 + 4 * 4096);
+    memCtx.dealloc(p4, 6 * 4096);
+
+    const auto st = memCtx.largeStats();
+    BOOST_TEST(st.allocs == 4U);
+    BOOST_TEST(st.frees == 4U);
+    BOOST_TEST(st.live == 0U);
+    BOOST_TEST(st.highWater == 2U);
+    BOOST_TEST(st.reserved == 10U * 4096U);
+    BOOST_TEST(memCtx.reserved() == 10U * 4096U);
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxOverflowCase)
+{
+    MemOpts opts;
+    opts.overflow = true;
+    MemCtx memCtx{1 << 16, opts};
+
+    // Larger than the pool, so satisfied by the heap.
+    auto* p1 = static_cast<char*>(memCtx.alloc(1 << 17));
+    BOOST_TEST(reinterpret_cast<uintptr_t>(p1) % 64 == 0U);
+    memset(p1, 0xff, 1 << 17);
+    BOOST_TEST(memCtx.overflows() == 1U);
+    BOOST_TEST(memCtx.reserved() == 0U);
+
+    // Exhaust the pool with small blocks.
+    vector<void*> ptrs;
+    while (memCtx.overflows() == 1U) {
+        ptrs.push_back(memCtx.alloc(64));
+    }
+    BOOST_TEST(memCtx.overflows() == 2U);
+    for (auto* ptr : ptrs) {
+        memCtx.dealloc(ptr, 64);
+    }
+    memCtx.dealloc(p1, 1 << 17);
+    // Heap blocks are freed to the heap.
+    BOOST_TEST(memCtx.stats(0).allocs == ptrs.size() - 1);
+    BOOST_TEST(memCtx.stats(0).live == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxStatsCase)
+{
+    MemCtx memCtx{1 << 16};
+
+    vector<void*> blocks;
+    for (int i{0}; i < 10; ++i) {
+        blocks.push_back(memCtx.alloc(sizeof(Bar)));
+    }
+    for (int i{0}; i < 4; ++i) {
+        memCtx.dealloc(blocks.back(), sizeof(Bar));
+        blocks.pop_back();
+    }
+    auto st = memCtx.stats(4);
+    BOOST_TEST(st.allocs == 10U);
+    BOOST_TEST(st.frees == 4U);
+    BOOST_TEST(st.live == 6U);
+    BOOST_TEST(st.highWater == 10U);
+    // A single batch is carved from the pool.
+    BOOST_TEST(st.reserved == 16U * 512U);
+    BOOST_TEST(memCtx.reserved() == 16U * 512U);
+
+    // Counters of exited threads are retained.
+    thread t{[&memCtx]() {
+        auto* addr = memCtx.alloc(sizeof(Bar));
+        memCtx.dealloc(addr, sizeof(Bar));
+    }};
+    t.join();
+    st = memCtx.stats(4);
+    BOOST_TEST(st.allocs == 11U);
+    BOOST_TEST(st.frees == 5U);
+    BOOST_TEST(st.live == 6U);
+    BOOST_TEST(st.highWater == 11U);
+
+    for (auto* addr : blocks) {
+        memCtx.dealloc(addr, sizeof(Bar));
+    }
+    BOOST_TEST(memCtx.stats(4).live == 0U);
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxOptsCase)
+{
+    MemCtx memCtx{1 << 16, MemOpts{true, true, false}};
+
+    const auto info = memCtx.info();
+    // Huge pages may not be available, but the pool must be usable either way.
+    BOOST_TEST(info.pageSize >= 4096U);
+    BOOST_TEST(info.prefaulted);
+    BOOST_TEST(!info.locked);
+
+    char* p{static_cast<char*>(memCtx.alloc(sizeof(Bar)))};
+    strcpy(p, "test");
+    memCtx.dealloc(p, sizeof(Bar));
+}
+
+BOOST_AUTO_TEST_CASE(MemCtxPersistCase)
+{
+    char path[] = "/tmp/swirly-memctx.XXXXXX";
+    close(mkstemp(path));
+
+    {
+        MemCtx memCtx{path, 1 << 20};
+        BOOST_TEST(!memCtx.warm());
+        BOOST_TEST(!memCtx.root());
+
+        auto* p = static_cast<char*>(memCtx.alloc(5 * 4096));
+        strcpy(p, "test");
+        memCtx.persist(p);
+    }
+    {
+        // The pool is reopened after a clean shutdown.
+        MemCtx memCtx{path, 1 << 20};
+        BOOST_TEST(memCtx.warm());
+        BOOST_TEST(strcmp(static_cast<char*>(memCtx.root()), "test") == 0);
+        BOOST_TEST(memCtx.reserved() == 5U * 4096U);
+    }
+    {
+        // The pool was not shut down cleanly.
+        MemCtx memCtx{path, 1 << 20};
+        BOOST_TEST(!memCtx.warm());
+        BOOST_TEST(!memCtx.root());
+        BOOST_TEST(memCtx.reserved() == 0U);
+    }
+    unlink(path);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -17,6 +17,8 @@
 #ifndef SWIRLY_APP_MEMPOOL_HPP
 #define SWIRLY_APP_MEMPOOL_HPP
 
+#include <swirly/app/Backoff.hpp>
+
 #include <swirly/sys/Memory.hpp>
 
 #include <swirly/Config.h>
@@ -87,7 +89,18 @@ struct MemPool {
             MemStack<(8 << 6)> free8;
             MemStack<(16 << 6)> free16;
             MemStack<(32 << 6)> free32;
+            MemStack<(64 << 6)> free64;
+            MemStack<(128 << 6)> free128;
+            MemStack<(256 << 6)> free256;
             MemSize offset;
+            // Free runs of whole pages, ordered by offset and guarded by a spin-lock.
+            alignas(CacheLineSize) MemSize runs;
+            MemSize runLock;
+            // State preserved across restarts of a file-backed pool.
+            alignas(CacheLineSize) std::uint64_t magic;
+            // One plus the offset of the root block, or zero if there is none.
+            MemSize root;
+            MemSize clean;
         };
     };
     char storage[];
@@ -132,6 +145,39 @@ inline void push(const MemPool& pool, MemStack<SizeN>& stack, MemNode<SizeN>* no
                                           ));
 }
 
+/**
+ * Push a chain of nodes with a single compare-and-swap. On entry, the chain is linked by raw
+ * addresses stored in the next field; these are rewritten as tagged offsets.
+ */
+template <std::size_t SizeN>
+inline void pushChain(const MemPool& pool, MemStack<SizeN>& stack, MemNode<SizeN>* first,
+                      MemSize count)
+{
+    assert(count > 0);
+    // Reserve a distinct tag for each link in the chain.
+    auto tag = __atomic_add_fetch(&stack.tag, count, __ATOMIC_RELAXED) - count + 1;
+    const auto newHead = makeLink(tag++, ptrToOffset(pool, first));
+
+    auto* last = first;
+    for (MemSize i{1}; i < count; ++i) {
+        auto* const next = reinterpret_cast<MemNode<SizeN>*>(last->next);
+        last->next = makeLink(tag++, ptrToOffset(pool, next));
+        last = next;
+    }
+
+    decltype(stack.head) oldHead;
+    __atomic_load(&stack.head, &oldHead, __ATOMIC_RELAXED);
+    do {
+        last->next = oldHead;
+    } while (!__atomic_compare_exchange_n(&stack.head,
+                                          &oldHead,         // Expected.
+                                          newHead,          // Desired.
+                                          1,                // Weak.
+                                          __ATOMIC_RELEASE, // Success.
+                                          __ATOMIC_RELAXED  // Failure.
+                                          ));
+}
+
 template <std::size_t SizeN>
 inline MemNode<SizeN>* pop(const MemPool& pool, MemStack<SizeN>& stack)
 {
@@ -154,14 +200,22 @@ inline MemNode<SizeN>* pop(const MemPool& pool, MemStack<SizeN>& stack)
     return node;
 }
 
-inline MemSize reserve(MemPool& pool, MemSize size, MemSize maxSize)
+/**
+ * Sentinel offset returned by the non-throwing reserve functions when the pool is exhausted.
+ */
+constexpr MemSize NoOffset{~MemSize{0}};
+
+/**
+ * Returns NoOffset if the reservation would exceed maxSize.
+ */
+inline MemSize tryReserve(MemPool& pool, MemSize size, MemSize maxSize) noexcept
 {
     MemSize newOffset, oldOffset;
     __atomic_load(&pool.offset, &oldOffset, __ATOMIC_RELAXED);
     do {
         newOffset = oldOffset + size;
         if (newOffset > maxSize) {
-            throw std::bad_alloc{};
+            return NoOffset;
         }
     } while (!__atomic_compare_exchange_n(&pool.offset,
                                           &oldOffset,       // Expected.
@@ -173,6 +227,138 @@ inline MemSize reserve(MemPool& pool, MemSize size, MemSize maxSize)
     return oldOffset;
 }
 
+inline MemSize reserve(MemPool& pool, MemSize size, MemSize maxSize)
+{
+    const auto offset = tryReserve(pool, size, maxSize);
+    if (offset == NoOffset) {
+        throw std::bad_alloc{};
+    }
+    return offset;
+}
+
+/**
+ * Reserve a whole number of pages. Any space between the current offset and the next page boundary
+ * is skipped. Returns NoOffset if the reservation would exceed maxSize.
+ */
+inline MemSize tryReservePages(MemPool& pool, MemSize pages, MemSize maxSize) noexcept
+{
+    MemSize newOffset, oldOffset, offset;
+    __atomic_load(&pool.offset, &oldOffset, __ATOMIC_RELAXED);
+    do {
+        const auto first = ceilPage(oldOffset);
+        const auto last = first + pages * PageSize;
+        if (last > maxSize) {
+            return NoOffset;
+        }
+        offset = first;
+        newOffset = last;
+    } while (!__atomic_compare_exchange_n(&pool.offset,
+                                          &oldOffset,       // Expected.
+                                          newOffset,        // Desired.
+                                          1,                // Weak.
+                                          __ATOMIC_RELAXED, // Success.
+                                          __ATOMIC_RELAXED  // Failure.
+                                          ));
+    return offset;
+}
+
+/**
+ * Header stored at the start of each free run of pages.
+ */
+struct MemRun {
+    /**
+     * One plus the page index of the next run, or zero if this is the last.
+     */
+    MemSize next;
+    MemSize pages;
+};
+
+inline MemRun* runAt(const MemPool& pool, MemSize link) noexcept
+{
+    assert(link > 0);
+    return offsetToPtr<MemRun*>(pool, (link - 1) * PageSize);
+}
+
+inline void lockRuns(MemPool& pool) noexcept
+{
+    while (__atomic_exchange_n(&pool.runLock, 1, __ATOMIC_ACQUIRE)) {
+        cpuRelax();
+    }
+}
+
+inline void unlockRuns(MemPool& pool) noexcept
+{
+    __atomic_store_n(&pool.runLock, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Take a run of pages from the best-fitting free run, splitting it if necessary.
+ *
+ * Returns null if no free run is large enough.
+ */
+inline void* popRun(MemPool& pool, MemSize pages) noexcept
+{
+    lockRuns(pool);
+    MemSize* best{nullptr};
+    for (auto* link = &pool.runs; *link != 0; link = &runAt(pool, *link)->next) {
+        const auto n = runAt(pool, *link)->pages;
+        if (n >= pages && (!best || n < runAt(pool, *best)->pages)) {
+            best = link;
+            if (n == pages) {
+                break;
+            }
+        }
+    }
+    void* addr{nullptr};
+    if (best) {
+        auto* const run = runAt(pool, *best);
+        if (run->pages == pages) {
+            *best = run->next;
+            addr = run;
+        } else {
+            // Take the tail so that the run stays in place.
+            run->pages -= pages;
+            addr = reinterpret_cast<char*>(run) + run->pages * PageSize;
+        }
+    }
+    unlockRuns(pool);
+    return addr;
+}
+
+/**
+ * Return a run of pages to the free list, merging it with adjacent free runs.
+ */
+inline void pushRun(MemPool& pool, void* addr, MemSize pages) noexcept
+{
+    const MemSize first = ptrToOffset(pool, addr) >> PageBits;
+    lockRuns(pool);
+    MemSize* link{&pool.runs};
+    MemRun* prev{nullptr};
+    MemSize prevFirst{0};
+    while (*link != 0 && *link - 1 < first) {
+        prevFirst = *link - 1;
+        prev = runAt(pool, *link);
+        link = &prev->next;
+    }
+    auto* run = static_cast<MemRun*>(addr);
+    run->next = *link;
+    run->pages = pages;
+    if (run->next != 0 && first + pages == run->next - 1) {
+        // Merge with the following run.
+        const auto* const next = runAt(pool, run->next);
+        run->pages += next->pages;
+        run->next = next->next;
+    }
+    if (prev && prevFirst + prev->pages == first) {
+        // Merge with the preceding run.
+        prev->pages += run->pages;
+        prev->next = run->next;
+    } else {
+        *link = first + 1;
+    }
+    unlockRuns(pool);
+}
+
 template <std::size_t SizeN>
 inline void* allocBlock(MemPool& pool, MemStack<SizeN>& stack, MemSize maxSize)
 {
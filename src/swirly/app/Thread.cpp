@@ -18,33 +18,237 @@
 
 #include <swirly/sys/Reactor.hpp>
 
+#include <swirly/util/Exception.hpp>
+#include <swirly/util/String.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 namespace swirly {
 inline namespace app {
 using namespace std;
 namespace {
+
+// From linux/mempolicy.h, which is not always installed.
+constexpr int MpolPreferred{1};
+
+atomic<bool> failed_{false};
+
+/**
+ * Returns the CPUs of the NUMA node, or an empty list if the node does not exist.
+ */
+vector<int> nodeCpus(int node)
+{
+    ifstream is{"/sys/devices/system/node/node"s + to_string(node) + "/cpulist"};
+    string line;
+    return getline(is, line) ? parseCpuList(line) : vector<int>{};
+}
+
+struct PutCpuSet {
+    const cpu_set_t& cpus;
+};
+
+ostream& operator<<(ostream& os, PutCpuSet p)
+{
+    // Ranges of consecutive CPUs are collapsed, as in the kernel's CPU lists.
+    const char* sep{""};
+    for (int cpu{0}; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &p.cpus)) {
+            int last{cpu};
+            while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &p.cpus)) {
+                ++last;
+            }
+            os << sep << cpu;
+            if (last > cpu) {
+                os << '-' << last;
+            }
+            sep = ",";
+            cpu = last;
+        }
+    }
+    return os;
+}
+
+void setAffinity(const ThreadConfig& config)
+{
+    auto cpus = config.cpus;
+    if (cpus.empty() && config.numaNode >= 0) {
+        cpus = nodeCpus(config.numaNode);
+        if (cpus.empty()) {
+            SWIRLY_WARNING << "no cpus for numa node "sv << config.numaNode;
+        }
+    }
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    for (const auto cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cs);
+        }
+    }
+    if (const auto err = pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs); err != 0) {
+        SWIRLY_WARNING << "pthread_setaffinity_np failed: "sv << strerror(err);
+    }
+}
+
+void setScheduler(const ThreadConfig& config)
+{
+    if (config.priority == 0) {
+        return;
+    }
+    sched_param param{};
+    param.sched_priority = config.priority;
+    if (const auto err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); err != 0) {
+        // Typically EPERM without CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO.
+        SWIRLY_WARNING << "pthread_setschedparam failed: "sv << strerror(err);
+    }
+}
+
+void setMemPolicy(const ThreadConfig& config)
+{
+    if (config.numaNode < 0) {
+        return;
+    }
+    if (config.numaNode >= static_cast<int>(sizeof(unsigned long) * 8)) {
+        SWIRLY_WARNING << "invalid numa node "sv << config.numaNode;
+        return;
+    }
+    // The policy applies to memory first touched by this thread after the call.
+    const unsigned long mask{1UL << config.numaNode};
+    if (syscall(SYS_set_mempolicy, MpolPreferred, &mask, sizeof(mask) * 8 + 1) != 0) {
+        SWIRLY_WARNING << "set_mempolicy failed: "sv << strerror(errno);
+    }
+}
+
+void logPlacement(const ThreadConfig& config)
+{
+    unsigned cpu{0}, node{0};
+    syscall(SYS_getcpu, &cpu, &node, nullptr);
+
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    pthread_getaffinity_np(pthread_self(), sizeof(cs), &cs);
+
+    int policy{SCHED_OTHER};
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+
+    SWIRLY_NOTICE << "started "sv << config.name << " thread on cpu "sv << cpu << " node "sv
+                  << node << ", affinity "sv << PutCpuSet{cs} << ", "sv
+                  << (policy == SCHED_FIFO ? "fifo priority "sv : "priority "sv)
+                  << param.sched_priority;
+}
 void runReactor(Reactor& r, ThreadConfig config, const std::atomic<bool>& stop)
 {
     sigBlockAll();
-    pthread_setname_np(pthread_self(), config.name.c_str());
-    SWIRLY_NOTICE << "started "sv << config.name << " thread"sv;
+    applyThreadConfig(config);
     try {
         while (!stop.load(std::memory_order_acquire)) {
             r.poll();
         }
     } catch (const std::exception& e) {
         SWIRLY_ERROR << "exception: "sv << e.what();
-        kill(getpid(), SIGTERM);
+        notifyThreadFailure();
+    }
+    SWIRLY_NOTICE << "stopping "sv << config.name << " thread"sv;
+}
+
+void runReactorAgent(Reactor& r, void* agent, int (*fn)(void*), Millis idleTimeout,
+                     ThreadConfig config, const std::atomic<bool>& stop)
+{
+    sigBlockAll();
+    applyThreadConfig(config);
+    try {
+        int n{0};
+        while (!stop.load(std::memory_order_acquire)) {
+            // Busy-poll while there is work.
+            n = r.poll(n > 0 ? 0ms : idleTimeout);
+            n += fn(agent);
+        }
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+        notifyThreadFailure();
     }
     SWIRLY_NOTICE << "stopping "sv << config.name << " thread"sv;
 }
 } // namespace
 
+vector<int> parseCpuList(string_view list)
+{
+    vector<int> cpus;
+    while (!list.empty()) {
+        auto range = list.substr(0, list.find(','));
+        list.remove_prefix(min(range.size() + 1, list.size()));
+        // Allow for trailing whitespace, as in sysfs.
+        while (!range.empty() && isspace(range.back())) {
+            range.remove_suffix(1);
+        }
+        if (range.empty()) {
+            continue;
+        }
+        const auto dash = range.find('-');
+        const auto first = range.substr(0, dash);
+        const auto last = dash == string_view::npos ? first : range.substr(dash + 1);
+        const auto isNum = [](string_view sv) {
+            return !sv.empty()
+                && all_of(sv.begin(), sv.end(), [](char c) { return isdigit(c) != 0; });
+        };
+        if (!isNum(first) || !isNum(last) || stoi32(last) < stoi32(first)) {
+            throw Exception{errMsg() << "invalid cpu list: "sv << range};
+        }
+        for (auto cpu = stoi32(first); cpu <= stoi32(last); ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void applyThreadConfig(const ThreadConfig& config) noexcept
+{
+    pthread_setname_np(pthread_self(), config.name.c_str());
+    try {
+        setAffinity(config);
+    } catch (const exception& e) {
+        SWIRLY_WARNING << "failed to set affinity: "sv << e.what();
+    }
+    setScheduler(config);
+    setMemPolicy(config);
+    logPlacement(config);
+}
+
+void notifyThreadFailure() noexcept
+{
+    failed_.store(true, std::memory_order_release);
+    kill(getpid(), SIGTERM);
+}
+
+bool threadFailed() noexcept
+{
+    return failed_.load(std::memory_order_acquire);
+}
+
 ReactorThread::ReactorThread(Reactor& r, ThreadConfig config)
 : reactor_(r)
 , thread_{runReactor, std::ref(r), config, std::cref(stop_)}
 {
 }
 
+ReactorThread::ReactorThread(Reactor& r, void* agent, AgentFn fn, Millis idleTimeout,
+                             ThreadConfig config)
+: reactor_(r)
+, thread_{runReactorAgent, std::ref(r), agent, fn, idleTimeout, config, std::cref(stop_)}
+{
+}
+
 ReactorThread::~ReactorThread()
 {
     stop_.store(true, std::memory_order_release);
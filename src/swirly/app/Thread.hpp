@@ -17,16 +17,18 @@
 #ifndef SWIRLY_APP_THREAD_HPP
 #define SWIRLY_APP_THREAD_HPP
 
+#include <swirly/app/AgentStats.hpp>
 #include <swirly/app/Backoff.hpp>
 
 #include <swirly/sys/Signal.hpp>
 
 #include <swirly/util/Log.hpp>
+#include <swirly/util/Time.hpp>
 
 #include <atomic>
+#include <string_view>
 #include <thread>
-
-#include <unistd.h>
+#include <vector>
 
 namespace swirly {
 inline namespace sys {
@@ -36,8 +38,50 @@ inline namespace app {
 
 struct ThreadConfig {
     std::string name;
+    /**
+     * CPUs that the thread may run on. If empty, the thread may run on any CPU, or on those of its
+     * NUMA node if one is specified.
+     */
+    std::vector<int> cpus{};
+    /**
+     * Real-time SCHED_FIFO priority, or zero for the default time-sharing policy.
+     */
+    int priority{0};
+    /**
+     * NUMA node from which the thread prefers to allocate memory, or -1 for no preference.
+     */
+    int numaNode{-1};
+    /**
+     * Counters maintained by an AgentThread, or null if they are not published.
+     */
+    AgentStats* stats{nullptr};
 };
 
+/**
+ * Parse a CPU list of the form used by the kernel, e.g. "0-3,6".
+ *
+ * @throw Exception if the list is malformed.
+ */
+SWIRLY_API std::vector<int> parseCpuList(std::string_view list);
+
+/**
+ * Name the calling thread, and apply its CPU affinity, scheduling policy and NUMA placement. Each
+ * setting that cannot be applied is logged as a warning. The CPU and NUMA node that the thread
+ * actually landed on are then logged.
+ */
+SWIRLY_API void applyThreadConfig(const ThreadConfig& config) noexcept;
+
+/**
+ * Record that a thread was terminated by an exception, and signal the process to shut down.
+ */
+SWIRLY_API void notifyThreadFailure() noexcept;
+
+/**
+ * Returns true if any thread was terminated by an exception, in which case the shutdown is not
+ * orderly.
+ */
+SWIRLY_API bool threadFailed() noexcept;
+
 class AgentThread {
   public:
     template <typename AgentT>
@@ -65,30 +109,50 @@ class AgentThread {
     AgentThread& operator=(AgentThread&&) noexcept = delete;
 
   private:
+    enum : std::uint64_t { IdleClockMask = (1 << 10) - 1 };
+
     template <typename AgentT, typename BackoffT>
     static void run(AgentT& agent, BackoffT backoff, ThreadConfig config,
                     const std::atomic<bool>& stop)
     {
         using namespace std::literals::string_view_literals;
 
+        using Clock = std::chrono::steady_clock;
+
         sigBlockAll();
-        pthread_setname_np(pthread_self(), config.name.c_str());
-        SWIRLY_NOTICE << "started "sv << config.name << " thread"sv;
+        applyThreadConfig(config);
+        // Unpublished counters are maintained anyway to keep the loop free of branches.
+        AgentStats local{};
+        auto& stats = config.stats ? *config.stats : local;
         try {
             while (!stop.load(std::memory_order_relaxed)) {
-                if (agent() == 0) {
+                int n{agent()};
+                if (n == 0) {
+                    // The clock is read at the start and end of each idle spell, and periodically
+                    // during long spells so that readers see the time accumulate.
+                    auto start = Clock::now();
                     backoff.reset();
                     do {
+                        recordIdle(stats);
+                        if ((stats.idleCycles & IdleClockMask) == 0) {
+                            const auto now = Clock::now();
+                            recordIdleTime(stats, now - start);
+                            start = now;
+                        }
                         backoff.idle();
                         if (stop.load(std::memory_order_relaxed)) {
                             break;
                         }
-                    } while (agent() == 0);
+                    } while ((n = agent()) == 0);
+                    recordIdleTime(stats, Clock::now() - start);
+                }
+                if (n > 0) {
+                    recordBusy(stats, n);
                 }
             }
         } catch (const std::exception& e) {
             SWIRLY_ERROR << "exception: "sv << e.what();
-            kill(getpid(), SIGTERM);
+            notifyThreadFailure();
         }
         SWIRLY_NOTICE << "stopping "sv << config.name << " thread"sv;
     }
@@ -99,6 +163,19 @@ class AgentThread {
 class SWIRLY_API ReactorThread {
   public:
     ReactorThread(Reactor& r, ThreadConfig config);
+    /**
+     * Run an agent between polls of the reactor. The reactor is polled without blocking while
+     * either the agent or the reactor reports work, so that the agent is serviced with the latency
+     * of a dedicated thread. Otherwise, the reactor blocks for up to the idle timeout, which bounds
+     * the time to notice work for the agent that arrives from another thread. A zero idle timeout
+     * gives a pure busy-poll topology.
+     */
+    template <typename AgentT>
+    ReactorThread(Reactor& r, AgentT& agent, Millis idleTimeout, ThreadConfig config)
+    : ReactorThread{r, &agent, [](void* obj) { return (*static_cast<AgentT*>(obj))(); },
+                    idleTimeout, config}
+    {
+    }
     ~ReactorThread();
 
     // Copy.
@@ -110,6 +187,9 @@ class SWIRLY_API ReactorThread {
     ReactorThread& operator=(ReactorThread&&) noexcept = delete;
 
   private:
+    using AgentFn = int (*)(void*);
+    ReactorThread(Reactor& r, void* agent, AgentFn fn, Millis idleTimeout, ThreadConfig config);
+
     Reactor& reactor_;
     std::atomic<bool> stop_{false};
     std::thread thread_;
@@ -0,0 +1,88 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Thread.hpp"
+
+#include <swirly/sys/EpollReactor.hpp>
+
+#include <swirly/util/Exception.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sched.h>
+
+using namespace std;
+using namespace swirly;
+
+BOOST_AUTO_TEST_SUITE(ThreadSuite)
+
+BOOST_AUTO_TEST_CASE(ParseCpuListCase)
+{
+    BOOST_TEST(parseCpuList(""sv).empty());
+    BOOST_TEST(parseCpuList("3"sv) == vector<int>({3}));
+    BOOST_TEST(parseCpuList("0-3,6\n"sv) == vector<int>({0, 1, 2, 3, 6}));
+    BOOST_CHECK_THROW(parseCpuList("3-1"sv), Exception);
+    BOOST_CHECK_THROW(parseCpuList("a"sv), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(AgentThreadCase)
+{
+    // Pin to the last cpu that this process may run on, which need not be cpu zero under a
+    // restricted cpuset or taskset.
+    cpu_set_t cs;
+    CPU_ZERO(&cs);
+    BOOST_REQUIRE(sched_getaffinity(0, sizeof(cs), &cs) == 0);
+    int expected{CPU_SETSIZE - 1};
+    while (expected > 0 && !CPU_ISSET(expected, &cs)) {
+        --expected;
+    }
+    int cpu{-1};
+    auto agent = [&cpu]() {
+        __atomic_store_n(&cpu, sched_getcpu(), __ATOMIC_RELAXED);
+        return 0;
+    };
+    {
+        AgentThread thread{agent, ThreadConfig{"test"s, {expected}}};
+        while (__atomic_load_n(&cpu, __ATOMIC_RELAXED) < 0) {
+            this_thread::yield();
+        }
+    }
+    BOOST_TEST(cpu == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ReactorAgentCase)
+{
+    EpollReactor r{64};
+    // Work posted from this thread is picked up by the agent without any reactor events.
+    int posted{0}, done{0};
+    auto agent = [&posted, &done]() {
+        const auto n = __atomic_load_n(&posted, __ATOMIC_ACQUIRE) - done;
+        __atomic_store_n(&done, done + n, __ATOMIC_RELEASE);
+        return n;
+    };
+    {
+        ReactorThread thread{r, agent, 1ms, ThreadConfig{"test"s}};
+        for (int i{1}; i <= 3; ++i) {
+            __atomic_store_n(&posted, i, __ATOMIC_RELEASE);
+            while (__atomic_load_n(&done, __ATOMIC_ACQUIRE) < i) {
+                this_thread::yield();
+            }
+        }
+    }
+    BOOST_TEST(done == 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,9 @@
 
 #include <swirly/Config.h>
 
+#include <cstddef>
+#include <cstdint>
+
 namespace swirly {
 inline namespace fin {
 struct Msg;
@@ -36,10 +39,36 @@ class SWIRLY_API Journ {
     constexpr Journ(Journ&&) noexcept = default;
     Journ& operator=(Journ&&) noexcept = default;
 
+    /**
+     * Returns the sequence number of the last message written, or zero if the journal is empty.
+     * Sequence numbers are contiguous and start from one.
+     */
+    std::uint64_t seq() const noexcept { return doSeq(); }
+    /**
+     * Copy the message with the specified sequence number to buf.
+     *
+     * @return the size of the message, or zero if the message is not retained. Nothing is copied if
+     * the message is larger than size.
+     */
+    std::size_t read(std::uint64_t seq, void* buf, std::size_t size)
+    {
+        return doRead(seq, buf, size);
+    }
     void write(const Msg& msg) { doWrite(msg); }
+    /**
+     * Discard retained messages up to and including the specified sequence number. The last
+     * message written is always retained, and the journal's sequence number is not affected.
+     */
+    void truncate(std::uint64_t seq) { doTruncate(seq); }
 
   protected:
+    virtual std::uint64_t doSeq() const noexcept = 0;
+
+    virtual std::size_t doRead(std::uint64_t seq, void* buf, std::size_t size) = 0;
+
     virtual void doWrite(const Msg& msg) = 0;
+
+    virtual void doTruncate(std::uint64_t seq) = 0;
 };
 
 } // namespace fin
@@ -18,11 +18,14 @@
 
 #include <swirly/fin/Order.hpp>
 
+#include <utility>
+
 namespace swirly {
 inline namespace fin {
 using namespace std;
 
 static_assert(sizeof(Level) <= 2 * 64, "no greater than specified cache-lines");
+static_assert(sizeof(Level) >= sizeof(void*), "room for free-list link");
 
 Level::Level(const Order& firstOrder) noexcept
 : firstOrder_{&firstOrder}
@@ -52,11 +55,25 @@ void Level::subOrder(const Order& order) noexcept
 LevelSet::~LevelSet()
 {
     set_.clear_and_dispose([](Level* ptr) { delete ptr; });
+    clearFree();
 }
 
-LevelSet::LevelSet(LevelSet&&) = default;
+LevelSet::LevelSet(LevelSet&& rhs) noexcept
+: set_{move(rhs.set_)}
+, free_{exchange(rhs.free_, nullptr)}
+, stats_{rhs.stats_}
+{
+}
 
-LevelSet& LevelSet::operator=(LevelSet&&) = default;
+LevelSet& LevelSet::operator=(LevelSet&& rhs) noexcept
+{
+    set_.clear_and_dispose([](Level* ptr) { delete ptr; });
+    clearFree();
+    set_ = move(rhs.set_);
+    free_ = exchange(rhs.free_, nullptr);
+    stats_ = rhs.stats_;
+    return *this;
+}
 
 LevelSet::Iterator LevelSet::insert(ValuePtr value) noexcept
 {
@@ -96,7 +113,25 @@ LevelSet::Iterator LevelSet::insertOrReplace(ValuePtr value) noexcept
 
 void LevelSet::remove(const Level& level) noexcept
 {
-    set_.erase_and_dispose(Set::s_iterator_to(level), [](Level* ptr) { delete ptr; });
+    set_.erase_and_dispose(Set::s_iterator_to(level), [this](Level* ptr) { dispose(ptr); });
+}
+
+void LevelSet::dispose(Level* level) noexcept
+{
+    level->~Level();
+    // Push onto the front of the free-list, so that storage is reused in LIFO order.
+    auto* const node = reinterpret_cast<FreeNode*>(level);
+    node->next = free_;
+    free_ = node;
+}
+
+void LevelSet::clearFree() noexcept
+{
+    while (free_) {
+        auto* const node = free_;
+        free_ = node->next;
+        Level::operator delete(node, sizeof(Level));
+    }
 }
 
 } // namespace fin
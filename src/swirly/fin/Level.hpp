@@ -21,6 +21,8 @@
 
 #include <swirly/app/MemAlloc.hpp>
 
+#include <swirly/sys/Memory.hpp>
+
 #include <boost/intrusive/set.hpp>
 
 namespace swirly {
@@ -74,7 +76,8 @@ class SWIRLY_API Level
 
     void subOrder(const Order& order) noexcept;
 
-    boost::intrusive::set_member_hook<> keyHook;
+    // Align the level to a cache-line, so that it never straddles more cache-lines than necessary.
+    alignas(CacheLineSize) boost::intrusive::set_member_hook<> keyHook;
 
   private:
     const Order* firstOrder_;
@@ -108,11 +111,28 @@ class SWIRLY_API LevelSet {
     using Set
         = boost::intrusive::set<Level, ConstantTimeSizeOption, CompareOption, MemberHookOption>;
     using ValuePtr = std::unique_ptr<Level>;
+    /**
+     * Storage of a recycled level.
+     */
+    struct FreeNode {
+        FreeNode* next;
+    };
 
   public:
     using Iterator = typename Set::iterator;
     using ConstIterator = typename Set::const_iterator;
 
+    struct Stats {
+        /**
+         * Number of levels created.
+         */
+        std::uint64_t allocs;
+        /**
+         * Number of levels created from recycled storage.
+         */
+        std::uint64_t recycled;
+    };
+
     LevelSet() = default;
     ~LevelSet();
 
@@ -121,8 +141,10 @@ class SWIRLY_API LevelSet {
     LevelSet& operator=(const LevelSet&) = delete;
 
     // Move.
-    LevelSet(LevelSet&&);
-    LevelSet& operator=(LevelSet&&);
+    LevelSet(LevelSet&&) noexcept;
+    LevelSet& operator=(LevelSet&&) noexcept;
+
+    const Stats& stats() const noexcept { return stats_; }
 
     // Begin.
     ConstIterator begin() const noexcept { return set_.begin(); }
@@ -168,21 +190,47 @@ class SWIRLY_API LevelSet {
     template <typename... ArgsT>
     Iterator emplace(ArgsT&&... args)
     {
-        return insert(std::make_unique<Level>(std::forward<ArgsT>(args)...));
+        return insert(make(std::forward<ArgsT>(args)...));
     }
     template <typename... ArgsT>
     Iterator emplaceHint(ConstIterator hint, ArgsT&&... args)
     {
-        return insertHint(hint, std::make_unique<Level>(std::forward<ArgsT>(args)...));
+        return insertHint(hint, make(std::forward<ArgsT>(args)...));
     }
     template <typename... ArgsT>
     Iterator emplaceOrReplace(ArgsT&&... args)
     {
-        return insertOrReplace(std::make_unique<Level>(std::forward<ArgsT>(args)...));
+        return insertOrReplace(make(std::forward<ArgsT>(args)...));
     }
 
   private:
+    /**
+     * Create a level, preferring the most recently freed storage, which is likely to still be in
+     * cache.
+     */
+    template <typename... ArgsT>
+    ValuePtr make(ArgsT&&... args)
+    {
+        static_assert(std::is_nothrow_constructible_v<Level, ArgsT...>);
+        ++stats_.allocs;
+        if (free_) {
+            auto* const node = free_;
+            free_ = node->next;
+            ++stats_.recycled;
+            return ValuePtr{::new (node) Level{std::forward<ArgsT>(args)...}};
+        }
+        return std::make_unique<Level>(std::forward<ArgsT>(args)...);
+    }
+    /**
+     * Destroy a level and retain its storage. The free-list is bounded by the maximum number of
+     * levels ever held by the set, and its storage is only released when the set is destroyed.
+     */
+    void dispose(Level* level) noexcept;
+    void clearFree() noexcept;
+
     Set set_;
+    FreeNode* free_{nullptr};
+    Stats stats_{};
 };
 
 } // namespace fin
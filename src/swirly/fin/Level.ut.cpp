@@ -47,4 +47,31 @@ BOOST_AUTO_TEST_CASE(LevelSetCase)
     BOOST_TEST(level3.key() == -12345);
 }
 
+BOOST_AUTO_TEST_CASE(LevelSetRecycleCase)
+{
+    const Order order1{"MARAYL"sv, 1_id64,    "EURUSD"sv, 0_jd,      0_id64, ""sv,
+                       State::New, Side::Buy, 10_lts,     12345_tks, 0_lts,  0_lts,
+                       0_cst,      0_lts,     0_tks,      0_lts,     {},     {}};
+    const Order order2{"MARAYL"sv, 2_id64,    "EURUSD"sv, 0_jd,      0_id64, ""sv,
+                       State::New, Side::Buy, 10_lts,     12346_tks, 0_lts,  0_lts,
+                       0_cst,      0_lts,     0_tks,      0_lts,     {},     {}};
+
+    LevelSet s;
+
+    Level* const level1{&*s.emplace(order1)};
+    BOOST_TEST(reinterpret_cast<uintptr_t>(level1) % CacheLineSize == 0U);
+    Level* const level2{&*s.emplace(order2)};
+    s.remove(*level1);
+    s.remove(*level2);
+
+    // Most recently freed first.
+    BOOST_TEST(&*s.emplace(order1) == level2);
+    BOOST_TEST(&*s.emplace(order2) == level1);
+    BOOST_TEST(s.find(Side::Buy, 12345_tks)->ticks() == 12345_tks);
+    BOOST_TEST(s.find(Side::Buy, 12346_tks)->ticks() == 12346_tks);
+
+    BOOST_TEST(s.stats().allocs == 4U);
+    BOOST_TEST(s.stats().recycled == 2U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
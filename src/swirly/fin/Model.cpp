@@ -21,5 +21,7 @@ inline namespace fin {
 
 Model::~Model() = default;
 
+void Model::doPrefetch(Time since, JDay busDay) const {}
+
 } // namespace fin
 } // namespace swirly
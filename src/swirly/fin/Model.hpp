@@ -52,6 +52,11 @@ class SWIRLY_API Model {
     void readExec(Time since, const ModelCallback<ExecPtr>& cb) const { doReadExec(since, cb); }
     void readTrade(const ModelCallback<ExecPtr>& cb) const { doReadTrade(cb); }
     void readPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const { doReadPosn(busDay, cb); }
+    /**
+     * Hint that the order, exec, trade and posn reads will follow with the same arguments, so that
+     * an implementation may begin fetching them concurrently.
+     */
+    void prefetch(Time since, JDay busDay) const { doPrefetch(since, busDay); }
 
   protected:
     virtual void doReadAsset(const ModelCallback<AssetPtr>& cb) const = 0;
@@ -67,6 +72,8 @@ class SWIRLY_API Model {
     virtual void doReadTrade(const ModelCallback<ExecPtr>& cb) const = 0;
 
     virtual void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const = 0;
+
+    virtual void doPrefetch(Time since, JDay busDay) const;
 };
 
 } // namespace fin
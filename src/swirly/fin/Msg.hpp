@@ -72,12 +72,13 @@ struct SWIRLY_PACKED CreateExec {
 };
 static_assert(std::is_pod_v<CreateExec>);
 
-constexpr std::size_t MaxIds{(sizeof(CreateExec) - sizeof(Id64) - sizeof(int64_t)) / sizeof(Id64)};
 struct SWIRLY_PACKED ArchiveTrade {
     Id64 marketId;
-    Id64 ids[MaxIds];
     // std::chrono::time_point is not pod.
     int64_t modified;
+    std::uint32_t count;
+    // Variable-length array of count ids.
+    Id64 ids[];
 };
 static_assert(std::is_pod_v<ArchiveTrade>);
 
@@ -91,7 +92,33 @@ struct SWIRLY_PACKED Msg {
     };
 };
 static_assert(std::is_pod_v<Msg>);
-static_assert(sizeof(Msg) == 252, "must be specific size");
+
+/**
+ * Returns the encoded size of a message, which is only as large as its body.
+ */
+constexpr std::size_t msgSize(MsgType type, std::size_t ids = 0) noexcept
+{
+    constexpr auto HeaderSize = offsetof(Msg, createMarket);
+    switch (type) {
+    case MsgType::CreateMarket:
+        return HeaderSize + sizeof(CreateMarket);
+    case MsgType::UpdateMarket:
+        return HeaderSize + sizeof(UpdateMarket);
+    case MsgType::CreateExec:
+        return HeaderSize + sizeof(CreateExec);
+    case MsgType::ArchiveTrade:
+        break;
+    }
+    return HeaderSize + sizeof(ArchiveTrade) + ids * sizeof(Id64);
+}
+
+/**
+ * Returns the encoded size of an existing message.
+ */
+constexpr std::size_t msgSize(const Msg& msg) noexcept
+{
+    return msgSize(msg.type, msg.type == MsgType::ArchiveTrade ? msg.archiveTrade.count : 0);
+}
 
 } // namespace fin
 } // namespace swirly
@@ -31,19 +31,15 @@ MsgQueue::~MsgQueue() = default;
 
 void MsgQueue::archiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified)
 {
-    detail::Range<MaxIds> r{ids.size()};
-    if (mq_.reserve() < r.steps()) {
-        throw std::runtime_error{"insufficient queue capacity"};
-    }
-    do {
-        doArchiveTrade(marketId, makeArrayView(&ids[r.stepOffset()], r.stepSize()), modified);
-    } while (r.next());
+    // All ids are encoded in a single variable-length message.
+    doArchiveTrade(marketId, ids, modified);
 }
 
 void MsgQueue::doCreateMarket(Id64 id, Symbol instr, JDay settlDay, MarketState state)
 {
-    const auto fn = [ id, &instr, settlDay, state ](Msg & msg) noexcept
+    const auto fn = [ id, &instr, settlDay, state ](char* data) noexcept
     {
+        auto& msg = *reinterpret_cast<Msg*>(data);
         msg.type = MsgType::CreateMarket;
         auto& body = msg.createMarket;
         body.id = id;
@@ -51,29 +47,33 @@ void MsgQueue::doCreateMarket(Id64 id, Symbol instr, JDay settlDay, MarketState
         body.settlDay = settlDay;
         body.state = state;
     };
-    if (!mq_.post(fn)) {
+    if (!mq_.post(static_cast<int32_t>(MsgType::CreateMarket), msgSize(MsgType::CreateMarket),
+                  fn)) {
         throw std::runtime_error{"insufficient queue capacity"};
     }
 }
 
 void MsgQueue::doUpdateMarket(Id64 id, MarketState state)
 {
-    const auto fn = [&id, state ](Msg & msg) noexcept
+    const auto fn = [&id, state ](char* data) noexcept
     {
+        auto& msg = *reinterpret_cast<Msg*>(data);
         msg.type = MsgType::UpdateMarket;
         auto& body = msg.updateMarket;
         body.id = id;
         body.state = state;
     };
-    if (!mq_.post(fn)) {
+    if (!mq_.post(static_cast<int32_t>(MsgType::UpdateMarket), msgSize(MsgType::UpdateMarket),
+                  fn)) {
         throw std::runtime_error{"insufficient queue capacity"};
     }
 }
 
 void MsgQueue::doCreateExec(const Exec& exec)
 {
-    const auto fn = [&exec](Msg & msg) noexcept
+    const auto fn = [&exec](char* data) noexcept
     {
+        auto& msg = *reinterpret_cast<Msg*>(data);
         msg.type = MsgType::CreateExec;
         auto& body = msg.createExec;
         pstrcpy<'\0'>(body.accnt, exec.accnt());
@@ -100,14 +100,15 @@ void MsgQueue::doCreateExec(const Exec& exec)
         pstrcpy<'\0'>(body.cpty, exec.cpty());
         body.created = msSinceEpoch(exec.created());
     };
-    if (!mq_.post(fn)) {
+    if (!mq_.post(static_cast<int32_t>(MsgType::CreateExec), msgSize(MsgType::CreateExec), fn)) {
         throw std::runtime_error{"insufficient queue capacity"};
     }
 }
 
 void MsgQueue::createExec(ArrayView<ConstExecPtr> execs)
 {
-    if (mq_.reserve() < execs.size()) {
+    // Allow for padding at the end of the buffer.
+    if (mq_.reserve() < (execs.size() + 1) * FrameQueue::frameSize(msgSize(MsgType::CreateExec))) {
         throw std::runtime_error{"insufficient queue capacity"};
     }
     for (const auto& exec : execs) {
@@ -117,25 +118,21 @@ void MsgQueue::createExec(ArrayView<ConstExecPtr> execs)
 
 void MsgQueue::doArchiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified)
 {
-    assert(ids.size() <= MaxIds);
-    const auto fn = [&marketId, ids, modified ](Msg & msg) noexcept
+    const auto fn = [&marketId, ids, modified ](char* data) noexcept
     {
+        auto& msg = *reinterpret_cast<Msg*>(data);
         msg.type = MsgType::ArchiveTrade;
         auto& body = msg.archiveTrade;
         body.marketId = marketId;
-        // Cannot use copy and fill here because ArchiveBody is a packed struct:
-        // auto it = copy(ids.begin(), ids.end(), begin(body.ids));
-        // fill(it, end(body.ids), 0);
-        size_t i{0};
-        for (; i < ids.size(); ++i) {
+        body.modified = msSinceEpoch(modified);
+        body.count = ids.size();
+        // Cannot use copy here because ArchiveBody is a packed struct.
+        for (size_t i{0}; i < ids.size(); ++i) {
             body.ids[i] = ids[i];
         }
-        for (; i < MaxIds; ++i) {
-            body.ids[i] = 0_id64;
-        }
-        body.modified = msSinceEpoch(modified);
     };
-    if (!mq_.post(fn)) {
+    if (!mq_.post(static_cast<int32_t>(MsgType::ArchiveTrade),
+                  msgSize(MsgType::ArchiveTrade, ids.size()), fn)) {
         throw std::runtime_error{"insufficient queue capacity"};
     }
 }
@@ -19,7 +19,7 @@
 
 #include <swirly/fin/Msg.hpp>
 
-#include <swirly/app/MemQueue.hpp>
+#include <swirly/app/FrameQueue.hpp>
 
 #include <swirly/util/Array.hpp>
 
@@ -28,44 +28,13 @@
 namespace swirly {
 inline namespace fin {
 class Journ;
-namespace detail {
-template <std::size_t StepN>
-class Range {
-  public:
-    constexpr explicit Range(std::size_t size) noexcept
-    : size_{size}
-    {
-    }
-    constexpr Range() noexcept = default;
-    ~Range() = default;
-
-    // Copy.
-    Range(const Range&) = delete;
-    Range& operator=(const Range&) = delete;
-
-    // Move.
-    Range(Range&&) = delete;
-    Range& operator=(Range&&) = delete;
-
-    constexpr std::size_t stepOffset() const noexcept { return offset_; }
-    constexpr std::size_t stepSize() const noexcept { return std::min(size_ - offset_, StepN); }
-    constexpr std::size_t steps() const noexcept { return (size_ + StepN - 1) / StepN; }
-    constexpr bool done() const noexcept { return offset_ >= size_; }
-    bool next() noexcept
-    {
-        offset_ += StepN;
-        return !done();
-    }
-
-  private:
-    const std::size_t size_{0};
-    std::size_t offset_{0};
-};
-} // namespace detail
 
 class SWIRLY_API MsgQueue {
   public:
     MsgQueue(std::nullptr_t = nullptr) noexcept {}
+    /**
+     * @param capacity Capacity in bytes.
+     */
     explicit MsgQueue(std::size_t capacity)
     : mq_{capacity}
     {
@@ -84,6 +53,10 @@ class SWIRLY_API MsgQueue {
     MsgQueue(MsgQueue&&) = default;
     MsgQueue& operator=(MsgQueue&&) = default;
 
+    /**
+     * Returns true if the queue is empty.
+     */
+    bool empty() const noexcept { return mq_.empty(); }
     /**
      * Create Market.
      */
@@ -115,9 +88,18 @@ class SWIRLY_API MsgQueue {
      */
     void archiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified);
     /**
+     * Invoke function with the next message. The message is only consumed if the function returns
+     * normally.
+     *
      * Returns false if queue is empty.
      */
-    bool pop(Msg& msg) noexcept { return mq_.pop(msg); }
+    template <typename FnT>
+    bool fetch(FnT fn)
+    {
+        return mq_.fetch([&fn](std::int32_t type, const char* data, std::size_t size) {
+            fn(*reinterpret_cast<const Msg*>(data));
+        });
+    }
 
   private:
     void doCreateMarket(Id64 id, Symbol instr, JDay settlDay, MarketState state);
@@ -128,7 +110,7 @@ class SWIRLY_API MsgQueue {
 
     void doArchiveTrade(Id64 marketId, ArrayView<Id64> ids, Time modified);
 
-    MemQueue<Msg> mq_{nullptr};
+    FrameQueue mq_{nullptr};
 };
 
 } // namespace fin
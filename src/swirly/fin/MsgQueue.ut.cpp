@@ -74,124 +74,39 @@ struct JournState {
 };
 
 struct MsgQueueFixture {
-    MsgQueue mq{1 << 10};
+    MsgQueue mq{1 << 12};
 };
 
 } // namespace
 
 BOOST_AUTO_TEST_SUITE(MsgQueueSuite)
 
-BOOST_AUTO_TEST_CASE(RangeCase)
-{
-    BOOST_TEST(fin::detail::Range<8>{}.steps() == 0U);
-    {
-        fin::detail::Range<1> c{3};
-        BOOST_TEST(c.steps() == 3U);
-        // 1.
-        BOOST_TEST(c.stepOffset() == 0U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 2.
-        BOOST_TEST(c.stepOffset() == 1U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 3.
-        BOOST_TEST(c.stepOffset() == 2U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(!c.next());
-        BOOST_TEST(c.done());
-    }
-    {
-        fin::detail::Range<1> c{3};
-        BOOST_TEST(c.steps() == 3U);
-        // 1.
-        BOOST_TEST(c.stepOffset() == 0U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 2.
-        BOOST_TEST(c.stepOffset() == 1U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 3.
-        BOOST_TEST(c.stepOffset() == 2U);
-        BOOST_TEST(c.stepSize() == 1U);
-        BOOST_TEST(!c.next());
-        BOOST_TEST(c.done());
-    }
-    {
-        fin::detail::Range<8> c{4};
-        BOOST_TEST(c.steps() == 1U);
-        // 0-3.
-        BOOST_TEST(c.stepOffset() == 0U);
-        BOOST_TEST(c.stepSize() == 4U);
-        BOOST_TEST(!c.next());
-        BOOST_TEST(c.done());
-    }
-    {
-        fin::detail::Range<8> c{16};
-        BOOST_TEST(c.steps() == 2U);
-        // 0-7.
-        BOOST_TEST(c.stepOffset() == 0U);
-        BOOST_TEST(c.stepSize() == 8U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 8-15
-        BOOST_TEST(c.stepOffset() == 8U);
-        BOOST_TEST(c.stepSize() == 8U);
-        BOOST_TEST(!c.next());
-        BOOST_TEST(c.done());
-    }
-    {
-        fin::detail::Range<8> c{20};
-        BOOST_TEST(c.steps() == 3U);
-        // 0-7.
-        BOOST_TEST(c.stepOffset() == 0U);
-        BOOST_TEST(c.stepSize() == 8U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 8-15
-        BOOST_TEST(c.stepOffset() == 8U);
-        BOOST_TEST(c.stepSize() == 8U);
-        BOOST_TEST(c.next());
-        BOOST_TEST(!c.done());
-        // 16-19.
-        BOOST_TEST(c.stepOffset() == 16U);
-        BOOST_TEST(c.stepSize() == 4U);
-        BOOST_TEST(!c.next());
-        BOOST_TEST(c.done());
-    }
-}
-
 BOOST_FIXTURE_TEST_CASE(MsgQueueCreateMarket, MsgQueueFixture)
 {
     mq.createMarket(MarketId, "EURUSD"sv, SettlDay, 0x1);
 
-    Msg msg;
-    BOOST_TEST(mq.pop(msg));
-    BOOST_CHECK_EQUAL(msg.type, MsgType::CreateMarket);
-    const auto& body = msg.createMarket;
+    BOOST_TEST(mq.fetch([](const Msg& msg) {
+        BOOST_CHECK_EQUAL(msg.type, MsgType::CreateMarket);
+        const auto& body = msg.createMarket;
 
-    BOOST_CHECK_EQUAL(body.id, MarketId);
-    BOOST_CHECK_EQUAL(strncmp(body.instr, "EURUSD", sizeof(body.instr)), 0);
-    BOOST_CHECK_EQUAL(body.settlDay, SettlDay);
-    BOOST_CHECK_EQUAL(body.state, 0x1U);
+        BOOST_CHECK_EQUAL(body.id, MarketId);
+        BOOST_CHECK_EQUAL(strncmp(body.instr, "EURUSD", sizeof(body.instr)), 0);
+        BOOST_CHECK_EQUAL(body.settlDay, SettlDay);
+        BOOST_CHECK_EQUAL(body.state, 0x1U);
+    }));
 }
 
 BOOST_FIXTURE_TEST_CASE(MsgQueueUpdateMarket, MsgQueueFixture)
 {
     mq.updateMarket(MarketId, 0x1);
 
-    Msg msg;
-    BOOST_TEST(mq.pop(msg));
-    BOOST_CHECK_EQUAL(msg.type, MsgType::UpdateMarket);
-    const auto& body = msg.updateMarket;
+    BOOST_TEST(mq.fetch([](const Msg& msg) {
+        BOOST_CHECK_EQUAL(msg.type, MsgType::UpdateMarket);
+        const auto& body = msg.updateMarket;
 
-    BOOST_CHECK_EQUAL(body.id, MarketId);
-    BOOST_CHECK_EQUAL(body.state, 0x1U);
+        BOOST_CHECK_EQUAL(body.id, MarketId);
+        BOOST_CHECK_EQUAL(body.state, 0x1U);
+    }));
 }
 
 BOOST_FIXTURE_TEST_CASE(MsgQueueCreateExec, MsgQueueFixture)
@@ -206,9 +121,7 @@ BOOST_FIXTURE_TEST_CASE(MsgQueueCreateExec, MsgQueueFixture)
                                    5_lts, 61725_cst, 5_lts, 12345_tks, 1_lts, 4_id64, 0_lts, 0_cst,
                                    LiqInd::Maker, "GOSAYL"sv, Now + 1ms);
     mq.createExec(execs);
-    {
-        Msg msg;
-        BOOST_TEST(mq.pop(msg));
+    BOOST_TEST(mq.fetch([](const Msg& msg) {
         BOOST_CHECK_EQUAL(msg.type, MsgType::CreateExec);
         const auto& body = msg.createExec;
 
@@ -235,10 +148,8 @@ BOOST_FIXTURE_TEST_CASE(MsgQueueCreateExec, MsgQueueFixture)
         BOOST_CHECK_EQUAL(body.liqInd, LiqInd::None);
         BOOST_CHECK_EQUAL(strncmp(body.cpty, "", sizeof(body.cpty)), 0);
         BOOST_CHECK_EQUAL(body.created, msSinceEpoch(Now));
-    }
-    {
-        Msg msg;
-        BOOST_TEST(mq.pop(msg));
+    }));
+    BOOST_TEST(mq.fetch([](const Msg& msg) {
         BOOST_CHECK_EQUAL(msg.type, MsgType::CreateExec);
         const auto& body = msg.createExec;
 
@@ -265,7 +176,7 @@ BOOST_FIXTURE_TEST_CASE(MsgQueueCreateExec, MsgQueueFixture)
         BOOST_CHECK_EQUAL(body.liqInd, LiqInd::Maker);
         BOOST_CHECK_EQUAL(strncmp(body.cpty, "GOSAYL", sizeof(body.cpty)), 0);
         BOOST_CHECK_EQUAL(body.created, msSinceEpoch(Now + 1ms));
-    }
+    }));
 }
 
 BOOST_FIXTURE_TEST_CASE(MsgQueueArchiveTrade, MsgQueueFixture)
@@ -277,22 +188,18 @@ BOOST_FIXTURE_TEST_CASE(MsgQueueArchiveTrade, MsgQueueFixture)
     generate_n(back_insert_iterator<decltype(ids)>(ids), ids.capacity(), [&id]() { return ++id; });
     mq.archiveTrade(MarketId, ids, Now);
 
-    auto it = ids.begin();
-    while (it != ids.end()) {
-        Msg msg;
-        BOOST_TEST(mq.pop(msg));
+    // All ids are encoded in a single message.
+    BOOST_TEST(mq.fetch([&ids](const Msg& msg) {
         BOOST_CHECK_EQUAL(msg.type, MsgType::ArchiveTrade);
         const auto& body = msg.archiveTrade;
         BOOST_CHECK_EQUAL(body.marketId, MarketId);
         BOOST_CHECK_EQUAL(body.modified, msSinceEpoch(Now));
-        for (const auto id : body.ids) {
-            if (it != ids.end()) {
-                BOOST_CHECK_EQUAL(id, *it++);
-            } else {
-                BOOST_CHECK_EQUAL(id, 0_id64);
-            }
+        BOOST_CHECK_EQUAL(body.count, ids.size());
+        for (size_t i{0}; i < body.count; ++i) {
+            BOOST_CHECK_EQUAL(body.ids[i], ids[i]);
         }
-    }
+    }));
+    BOOST_TEST(mq.empty());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MarketData.hpp"
+
+#include <swirly/fin/Market.hpp>
+
+namespace swirly {
+inline namespace lob {
+using namespace std;
+namespace {
+
+void toMdLevels(const LevelSet& levels, MdLevel* out) noexcept
+{
+    auto it = levels.begin();
+    for (size_t i{0}; i < MaxLevels; ++i) {
+        if (it != levels.end()) {
+            out[i] = {it->ticks(), it->lots(), it->count()};
+            ++it;
+        } else {
+            out[i] = {0_tks, 0_lts, 0};
+        }
+    }
+}
+
+size_t diffMdLevels(Side side, const MdLevel* prev, const MdLevel* next, MdDelta* out) noexcept
+{
+    size_t n{0};
+    for (size_t i{0}; i < MaxLevels; ++i) {
+        if (prev[i] != next[i]) {
+            out[n++] = {side, static_cast<uint8_t>(i), next[i]};
+        }
+    }
+    return n;
+}
+
+} // namespace
+
+void toMdBook(const Market& market, MdBook& book) noexcept
+{
+    book.marketId = market.id();
+    book.state = market.state();
+    book.lastLots = market.lastLots();
+    book.lastTicks = market.lastTicks();
+    book.lastTime = msSinceEpoch(market.lastTime());
+    toMdLevels(market.bidSide().levels(), book.bids);
+    toMdLevels(market.offerSide().levels(), book.offers);
+}
+
+MdTop toMdTop(const MdBook& book) noexcept
+{
+    return {book.marketId, book.state,   book.lastLots,  book.lastTicks,
+            book.lastTime, book.bids[0], book.offers[0]};
+}
+
+size_t diffMdBooks(const MdBook& prev, const MdBook& next, MdDelta* deltas) noexcept
+{
+    auto n = diffMdLevels(Side::Buy, prev.bids, next.bids, deltas);
+    n += diffMdLevels(Side::Sell, prev.offers, next.offers, deltas + n);
+    return n;
+}
+
+void applyMdUpdate(const MdTop& top, const MdDelta* deltas, size_t count, MdBook& book) noexcept
+{
+    book.marketId = top.marketId;
+    book.state = top.state;
+    book.lastLots = top.lastLots;
+    book.lastTicks = top.lastTicks;
+    book.lastTime = top.lastTime;
+    for (size_t i{0}; i < count; ++i) {
+        const auto& delta = deltas[i];
+        if (delta.depth < MaxLevels) {
+            auto* const levels = delta.side == Side::Buy ? book.bids : book.offers;
+            levels[delta.depth] = delta.level;
+        }
+    }
+}
+
+} // namespace lob
+} // namespace swirly
@@ -0,0 +1,132 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_LOB_MARKETDATA_HPP
+#define SWIRLY_LOB_MARKETDATA_HPP
+
+#include <swirly/fin/Limits.hpp>
+#include <swirly/fin/Types.hpp>
+
+#include <swirly/util/BasicTypes.hpp>
+
+namespace swirly {
+inline namespace fin {
+class Market;
+} // namespace fin
+inline namespace lob {
+
+/**
+ * Market-data wire format. Integers are in host byte order, as with the journal and replication
+ * streams.
+ *
+ * Each update packet comprises a header, the top of book, and a delta for each depth level that
+ * has changed. A snapshot comprises a header followed by the full book for each market. Sequence
+ * numbers are contiguous and start from one. A snapshot carries the sequence number of the last
+ * update that it includes.
+ */
+enum class MdType : std::uint16_t { Update = 1, Snapshot = 2 };
+
+struct SWIRLY_PACKED MdHeader {
+    std::uint64_t seq;
+    MdType type;
+    // Number of deltas or books that follow.
+    std::uint32_t count;
+};
+static_assert(std::is_pod_v<MdHeader>);
+
+/**
+ * Aggregated price level. An empty level has zero lots.
+ */
+struct SWIRLY_PACKED MdLevel {
+    Ticks ticks;
+    Lots lots;
+    int count;
+};
+static_assert(std::is_pod_v<MdLevel>);
+
+inline bool operator==(const MdLevel& lhs, const MdLevel& rhs) noexcept
+{
+    return lhs.ticks == rhs.ticks && lhs.lots == rhs.lots && lhs.count == rhs.count;
+}
+
+inline bool operator!=(const MdLevel& lhs, const MdLevel& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+struct SWIRLY_PACKED MdBook {
+    Id64 marketId;
+    MarketState state;
+    Lots lastLots;
+    Ticks lastTicks;
+    // std::chrono::time_point is not pod.
+    int64_t lastTime;
+    MdLevel bids[MaxLevels];
+    MdLevel offers[MaxLevels];
+};
+static_assert(std::is_pod_v<MdBook>);
+
+struct SWIRLY_PACKED MdTop {
+    Id64 marketId;
+    MarketState state;
+    Lots lastLots;
+    Ticks lastTicks;
+    int64_t lastTime;
+    MdLevel bid;
+    MdLevel offer;
+};
+static_assert(std::is_pod_v<MdTop>);
+
+struct SWIRLY_PACKED MdDelta {
+    Side side;
+    std::uint8_t depth;
+    MdLevel level;
+};
+static_assert(std::is_pod_v<MdDelta>);
+
+enum : std::size_t {
+    /**
+     * Maximum number of deltas in an update.
+     */
+    MaxMdDeltas = 2 * MaxLevels,
+    /**
+     * Maximum size of an update packet.
+     */
+    MaxMdUpdate = sizeof(MdHeader) + sizeof(MdTop) + MaxMdDeltas * sizeof(MdDelta)
+};
+
+SWIRLY_API void toMdBook(const Market& market, MdBook& book) noexcept;
+
+SWIRLY_API MdTop toMdTop(const MdBook& book) noexcept;
+
+/**
+ * Write a delta for each level that differs between the two books.
+ *
+ * @return the number of deltas, which is at most MaxMdDeltas.
+ */
+SWIRLY_API std::size_t diffMdBooks(const MdBook& prev, const MdBook& next,
+                                   MdDelta* deltas) noexcept;
+
+/**
+ * Apply an update to a book.
+ */
+SWIRLY_API void applyMdUpdate(const MdTop& top, const MdDelta* deltas, std::size_t count,
+                              MdBook& book) noexcept;
+
+} // namespace lob
+} // namespace swirly
+
+#endif // SWIRLY_LOB_MARKETDATA_HPP
@@ -0,0 +1,130 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MarketData.hpp"
+
+#include <swirly/lob/Response.hpp>
+#include <swirly/lob/Serv.hpp>
+#include <swirly/lob/Test.hpp>
+
+#include <swirly/fin/MarketId.hpp>
+#include <swirly/fin/MsgQueue.hpp>
+
+#include <swirly/util/Date.hpp>
+#include <swirly/util/Time.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+constexpr auto Today = ymdToJd(2014, 3, 11);
+constexpr auto SettlDay = Today + 2_jd;
+constexpr auto MarketId = toMarketId(1_id32, SettlDay);
+
+constexpr auto Now = jdToTime(Today);
+
+class SWIRLY_API TestModel : public swirly::TestModel {
+  protected:
+    void doReadMarket(const ModelCallback<MarketPtr>& cb) const override
+    {
+        cb(Market::make(MarketId, "EURUSD"sv, SettlDay, 0x1U));
+    }
+};
+
+struct MarketDataFixture {
+    MarketDataFixture()
+    {
+        serv.load(TestModel{}, Now);
+        serv.setMarketSlot(bind<&MarketDataFixture::onMarket>(this));
+    }
+    void onMarket(const Market& market, Time now)
+    {
+        ++updates;
+        toMdBook(market, book);
+    }
+    MsgQueue mq{1 << 18};
+    Serv serv{mq, 1 << 4};
+    int updates{0};
+    MdBook book{};
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MarketDataSuite)
+
+BOOST_FIXTURE_TEST_CASE(MarketDataBookCase, MarketDataFixture)
+{
+    auto& accnt = serv.accnt("MARAYL"sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 5_lts, 12344_tks, 1_lts, Now, resp);
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 3_lts, 12344_tks, 1_lts, Now, resp);
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 2_lts, 12343_tks, 1_lts, Now, resp);
+    serv.createOrder(accnt, market, ""sv, Side::Sell, 7_lts, 12346_tks, 1_lts, Now, resp);
+    BOOST_TEST(updates == 4);
+
+    BOOST_TEST((book.marketId == MarketId));
+    BOOST_TEST((book.state == 0x1U));
+    BOOST_TEST((book.bids[0] == MdLevel{12344_tks, 8_lts, 2}));
+    BOOST_TEST((book.bids[1] == MdLevel{12343_tks, 2_lts, 1}));
+    BOOST_TEST((book.offers[0] == MdLevel{12346_tks, 7_lts, 1}));
+    BOOST_TEST((book.offers[1].lots == 0_lts));
+
+    const auto top = toMdTop(book);
+    BOOST_TEST((top.marketId == MarketId));
+    BOOST_TEST((top.bid == book.bids[0]));
+    BOOST_TEST((top.offer == book.offers[0]));
+
+    // Failed requests do not notify.
+    BOOST_CHECK_THROW(
+        serv.createOrder(accnt, market, ""sv, Side::Buy, 0_lts, 12344_tks, 1_lts, Now, resp),
+        exception);
+    BOOST_TEST(updates == 4);
+}
+
+BOOST_FIXTURE_TEST_CASE(MarketDataDiffCase, MarketDataFixture)
+{
+    auto& accnt = serv.accnt("MARAYL"sv);
+    auto& market = serv.market(MarketId);
+
+    Response resp;
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 5_lts, 12344_tks, 1_lts, Now, resp);
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 2_lts, 12343_tks, 1_lts, Now, resp);
+    const auto prev = book;
+
+    // Improve the bid, which shifts both existing levels down.
+    serv.createOrder(accnt, market, ""sv, Side::Buy, 1_lts, 12345_tks, 1_lts, Now, resp);
+
+    MdDelta deltas[MaxMdDeltas];
+    const auto n = diffMdBooks(prev, book, deltas);
+    BOOST_TEST(n == min<size_t>(3, MaxLevels));
+    BOOST_TEST((deltas[0].side == Side::Buy));
+    BOOST_TEST((deltas[0].depth == 0));
+    BOOST_TEST((deltas[0].level == MdLevel{12345_tks, 1_lts, 1}));
+
+    // Apply the update to a copy of the previous book.
+    auto copy = prev;
+    applyMdUpdate(toMdTop(book), deltas, n, copy);
+    BOOST_TEST(memcmp(&copy, &book, sizeof(MdBook)) == 0);
+
+    BOOST_TEST(diffMdBooks(book, book, deltas) == 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,507 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MemModel.hpp"
+
+#include <swirly/lob/Accnt.hpp>
+#include <swirly/lob/Serv.hpp>
+
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/app/MemCtx.hpp>
+
+#include <swirly/util/Exception.hpp>
+
+namespace swirly {
+inline namespace lob {
+using namespace std;
+namespace {
+
+// Incremented whenever the layout of the image changes.
+enum : uint32_t { ImageVersion = 2 };
+
+enum : size_t {
+    AssetTable,
+    InstrTable,
+    MarketTable,
+    OrderTable,
+    ExecTable,
+    TradeTable,
+    PosnTable,
+    TableCount
+};
+
+struct ImageTable {
+    // Offset from the start of the image.
+    uint32_t offset;
+    uint32_t count;
+};
+
+struct ImageHeader {
+    // These two fields must not move, so that an image of any version can be freed.
+    uint64_t size;
+    uint32_t version;
+    // std::chrono::time_point is not pod.
+    int64_t created;
+    ImageTable tables[TableCount];
+};
+static_assert(is_pod_v<ImageHeader>);
+
+struct SWIRLY_PACKED AssetRec {
+    Id32 id;
+    char symbol[MaxSymbol];
+    char display[MaxDisplay];
+    AssetType type;
+};
+static_assert(is_pod_v<AssetRec>);
+
+struct SWIRLY_PACKED InstrRec {
+    Id32 id;
+    char symbol[MaxSymbol];
+    char display[MaxDisplay];
+    char baseAsset[MaxSymbol];
+    char termCcy[MaxSymbol];
+    int lotNumer;
+    int lotDenom;
+    int tickNumer;
+    int tickDenom;
+    int pipDp;
+    Lots minLots;
+    Lots maxLots;
+};
+static_assert(is_pod_v<InstrRec>);
+
+struct SWIRLY_PACKED MarketRec {
+    Id64 id;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    MarketState state;
+    Lots lastLots;
+    Ticks lastTicks;
+    int64_t lastTime;
+    Id64 maxId;
+};
+static_assert(is_pod_v<MarketRec>);
+
+struct SWIRLY_PACKED OrderRec {
+    char accnt[MaxSymbol];
+    Id64 marketId;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    Id64 id;
+    char ref[MaxRef];
+    State state;
+    Side side;
+    Lots lots;
+    Ticks ticks;
+    Lots resdLots;
+    Lots execLots;
+    Cost execCost;
+    Lots lastLots;
+    Ticks lastTicks;
+    Lots minLots;
+    int64_t created;
+    int64_t modified;
+};
+static_assert(is_pod_v<OrderRec>);
+
+// Executions and trades share the journal's encoding.
+using ExecRec = CreateExec;
+
+struct SWIRLY_PACKED PosnRec {
+    char accnt[MaxSymbol];
+    Id64 marketId;
+    char instr[MaxSymbol];
+    JDay settlDay;
+    Lots buyLots;
+    Cost buyCost;
+    Lots sellLots;
+    Cost sellCost;
+};
+static_assert(is_pod_v<PosnRec>);
+
+constexpr size_t RecSizes[] = {sizeof(AssetRec), sizeof(InstrRec), sizeof(MarketRec),
+                               sizeof(OrderRec), sizeof(ExecRec),  sizeof(ExecRec),
+                               sizeof(PosnRec)};
+static_assert(size(RecSizes) == TableCount);
+
+// Times are stored in milliseconds since the epoch, as they are in the journal and the database, so
+// that a model loaded from an image matches one loaded from the database.
+Time toTime(int64_t ms) noexcept
+{
+    return swirly::toTime(Millis{ms});
+}
+
+void put(AssetRec& rec, const Asset& asset) noexcept
+{
+    rec.id = asset.id();
+    pstrcpy<'\0'>(rec.symbol, asset.symbol());
+    pstrcpy<'\0'>(rec.display, asset.display());
+    rec.type = asset.type();
+}
+
+void put(InstrRec& rec, const Instr& instr) noexcept
+{
+    rec.id = instr.id();
+    pstrcpy<'\0'>(rec.symbol, instr.symbol());
+    pstrcpy<'\0'>(rec.display, instr.display());
+    pstrcpy<'\0'>(rec.baseAsset, instr.baseAsset());
+    pstrcpy<'\0'>(rec.termCcy, instr.termCcy());
+    rec.lotNumer = instr.lotNumer();
+    rec.lotDenom = instr.lotDenom();
+    rec.tickNumer = instr.tickNumer();
+    rec.tickDenom = instr.tickDenom();
+    rec.pipDp = instr.pipDp();
+    rec.minLots = instr.minLots();
+    rec.maxLots = instr.maxLots();
+}
+
+void put(MarketRec& rec, const Market& market) noexcept
+{
+    rec.id = market.id();
+    pstrcpy<'\0'>(rec.instr, market.instr());
+    rec.settlDay = market.settlDay();
+    rec.state = market.state();
+    rec.lastLots = market.lastLots();
+    rec.lastTicks = market.lastTicks();
+    rec.lastTime = msSinceEpoch(market.lastTime());
+    rec.maxId = market.maxId();
+}
+
+void put(OrderRec& rec, const Order& order) noexcept
+{
+    pstrcpy<'\0'>(rec.accnt, order.accnt());
+    rec.marketId = order.marketId();
+    pstrcpy<'\0'>(rec.instr, order.instr());
+    rec.settlDay = order.settlDay();
+    rec.id = order.id();
+    pstrcpy<'\0'>(rec.ref, order.ref());
+    rec.state = order.state();
+    rec.side = order.side();
+    rec.lots = order.lots();
+    rec.ticks = order.ticks();
+    rec.resdLots = order.resdLots();
+    rec.execLots = order.execLots();
+    rec.execCost = order.execCost();
+    rec.lastLots = order.lastLots();
+    rec.lastTicks = order.lastTicks();
+    rec.minLots = order.minLots();
+    rec.created = msSinceEpoch(order.created());
+    rec.modified = msSinceEpoch(order.modified());
+}
+
+void put(ExecRec& rec, const Exec& exec) noexcept
+{
+    pstrcpy<'\0'>(rec.accnt, exec.accnt());
+    rec.marketId = exec.marketId();
+    pstrcpy<'\0'>(rec.instr, exec.instr());
+    rec.settlDay = exec.settlDay();
+    rec.id = exec.id();
+    rec.orderId = exec.orderId();
+    pstrcpy<'\0'>(rec.ref, exec.ref());
+    rec.state = exec.state();
+    rec.side = exec.side();
+    rec.lots = exec.lots();
+    rec.ticks = exec.ticks();
+    rec.resdLots = exec.resdLots();
+    rec.execLots = exec.execLots();
+    rec.execCost = exec.execCost();
+    rec.lastLots = exec.lastLots();
+    rec.lastTicks = exec.lastTicks();
+    rec.minLots = exec.minLots();
+    rec.matchId = exec.matchId();
+    rec.posnLots = exec.posnLots();
+    rec.posnCost = exec.posnCost();
+    rec.liqInd = exec.liqInd();
+    pstrcpy<'\0'>(rec.cpty, exec.cpty());
+    rec.created = msSinceEpoch(exec.created());
+}
+
+void put(PosnRec& rec, const Posn& posn) noexcept
+{
+    pstrcpy<'\0'>(rec.accnt, posn.accnt());
+    rec.marketId = posn.marketId();
+    pstrcpy<'\0'>(rec.instr, posn.instr());
+    rec.settlDay = posn.settlDay();
+    rec.buyLots = posn.buyLots();
+    rec.buyCost = posn.buyCost();
+    rec.sellLots = posn.sellLots();
+    rec.sellCost = posn.sellCost();
+}
+
+ExecPtr makeExec(const ExecRec& rec)
+{
+    return Exec::make(toStringView(rec.accnt), rec.marketId, toStringView(rec.instr),
+                      rec.settlDay, rec.id, rec.orderId, toStringView(rec.ref), rec.state,
+                      rec.side, rec.lots, rec.ticks, rec.resdLots, rec.execLots, rec.execCost,
+                      rec.lastLots, rec.lastTicks, rec.minLots, rec.matchId, rec.posnLots,
+                      rec.posnCost, rec.liqInd, toStringView(rec.cpty), toTime(rec.created));
+}
+
+/**
+ * Invokes the function for each order in the book, in price-time priority, so that priority is
+ * preserved when the orders are reinserted.
+ */
+template <typename FnT>
+void forEachOrder(const Serv& serv, FnT fn)
+{
+    for (const auto& market : serv.markets()) {
+        for (const auto& order : market.bidSide().orders()) {
+            fn(order);
+        }
+        for (const auto& order : market.offerSide().orders()) {
+            fn(order);
+        }
+    }
+}
+
+template <typename RecT>
+const RecT* table(const char* image, size_t t) noexcept
+{
+    const auto& tbl = reinterpret_cast<const ImageHeader*>(image)->tables[t];
+    return reinterpret_cast<const RecT*>(image + tbl.offset);
+}
+
+template <typename RecT>
+RecT* table(char* image, size_t t) noexcept
+{
+    const auto& tbl = reinterpret_cast<const ImageHeader*>(image)->tables[t];
+    return reinterpret_cast<RecT*>(image + tbl.offset);
+}
+
+} // namespace
+
+MemModel::MemModel(const void* image, size_t extent)
+: image_{static_cast<const char*>(image)}
+{
+    if (extent < sizeof(ImageHeader)) {
+        throw Exception{errMsg() << "image truncated to "sv << extent << " bytes"sv};
+    }
+    const auto* const hdr = reinterpret_cast<const ImageHeader*>(image_);
+    if (hdr->version != ImageVersion) {
+        throw Exception{errMsg() << "unsupported image version: "sv << hdr->version};
+    }
+    if (hdr->size < sizeof(ImageHeader) || hdr->size > extent) {
+        throw Exception{errMsg() << "invalid image size: "sv << hdr->size};
+    }
+    // The pool may have been left corrupt, so every table is checked before any is read.
+    for (size_t t{0}; t < TableCount; ++t) {
+        const auto& tbl = hdr->tables[t];
+        if (tbl.offset < sizeof(ImageHeader) || tbl.offset > hdr->size
+            || uint64_t{tbl.count} * RecSizes[t] > hdr->size - tbl.offset) {
+            throw Exception{errMsg() << "invalid image table "sv << t << ": offset="sv
+                                     << tbl.offset << ", count="sv << tbl.count};
+        }
+    }
+}
+
+MemModel::~MemModel() = default;
+
+// Copy.
+MemModel::MemModel(const MemModel&) noexcept = default;
+MemModel& MemModel::operator=(const MemModel&) noexcept = default;
+
+// Move.
+MemModel::MemModel(MemModel&&) noexcept = default;
+MemModel& MemModel::operator=(MemModel&&) noexcept = default;
+
+Time MemModel::created() const noexcept
+{
+    return toTime(reinterpret_cast<const ImageHeader*>(image_)->created);
+}
+
+void MemModel::doReadAsset(const ModelCallback<AssetPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[AssetTable].count;
+    const auto* const recs = table<AssetRec>(image_, AssetTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        cb(Asset::make(rec.id, toStringView(rec.symbol), toStringView(rec.display), rec.type));
+    }
+}
+
+void MemModel::doReadInstr(const ModelCallback<InstrPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[InstrTable].count;
+    const auto* const recs = table<InstrRec>(image_, InstrTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        cb(Instr::make(rec.id, toStringView(rec.symbol), toStringView(rec.display),
+                       toStringView(rec.baseAsset), toStringView(rec.termCcy), rec.lotNumer,
+                       rec.lotDenom, rec.tickNumer, rec.tickDenom, rec.pipDp, rec.minLots,
+                       rec.maxLots));
+    }
+}
+
+void MemModel::doReadMarket(const ModelCallback<MarketPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[MarketTable].count;
+    const auto* const recs = table<MarketRec>(image_, MarketTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        cb(Market::make(rec.id, toStringView(rec.instr), rec.settlDay, rec.state, rec.lastLots,
+                        rec.lastTicks, toTime(rec.lastTime), rec.maxId));
+    }
+}
+
+void MemModel::doReadOrder(const ModelCallback<OrderPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[OrderTable].count;
+    const auto* const recs = table<OrderRec>(image_, OrderTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        cb(Order::make(toStringView(rec.accnt), rec.marketId, toStringView(rec.instr),
+                       rec.settlDay, rec.id, toStringView(rec.ref), rec.state, rec.side, rec.lots,
+                       rec.ticks, rec.resdLots, rec.execLots, rec.execCost, rec.lastLots,
+                       rec.lastTicks, rec.minLots, toTime(rec.created), toTime(rec.modified)));
+    }
+}
+
+void MemModel::doReadExec(Time since, const ModelCallback<ExecPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[ExecTable].count;
+    const auto* const recs = table<ExecRec>(image_, ExecTable);
+    const auto ms = msSinceEpoch(since);
+    // Most recent first.
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        if (rec.created > ms) {
+            cb(makeExec(rec));
+        }
+    }
+}
+
+void MemModel::doReadTrade(const ModelCallback<ExecPtr>& cb) const
+{
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[TradeTable].count;
+    const auto* const recs = table<ExecRec>(image_, TradeTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        cb(makeExec(recs[i]));
+    }
+}
+
+void MemModel::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
+{
+    PosnSet ps;
+    PosnSet::Iterator it;
+
+    const auto n = reinterpret_cast<const ImageHeader*>(image_)->tables[PosnTable].count;
+    const auto* const recs = table<PosnRec>(image_, PosnTable);
+    for (uint32_t i{0}; i < n; ++i) {
+        const auto& rec = recs[i];
+        const auto accnt = toStringView(rec.accnt);
+        auto marketId = rec.marketId;
+        auto settlDay = rec.settlDay;
+
+        // As for the database model, positions are rolled once they settle.
+        if (settlDay != 0_jd && settlDay <= busDay) {
+            marketId &= Id64{~0xffff};
+            settlDay = 0_jd;
+        }
+
+        bool found;
+        tie(it, found) = ps.findHint(accnt, marketId);
+        if (!found) {
+            it = ps.insertHint(it, Posn::make(accnt, marketId, toStringView(rec.instr), settlDay));
+        }
+
+        it->addBuy(rec.buyLots, rec.buyCost);
+        it->addSell(rec.sellLots, rec.sellCost);
+    }
+
+    for (it = ps.begin(); it != ps.end();) {
+        cb(ps.remove(it++));
+    }
+}
+
+void* saveImage(const Serv& serv, MemCtx& memCtx, Time now)
+{
+    size_t counts[TableCount]{};
+    counts[AssetTable] = distance(serv.assets().begin(), serv.assets().end());
+    counts[InstrTable] = distance(serv.instrs().begin(), serv.instrs().end());
+    counts[MarketTable] = distance(serv.markets().begin(), serv.markets().end());
+    forEachOrder(serv, [&counts](const Order&) { ++counts[OrderTable]; });
+    for (const auto& accnt : serv.accnts()) {
+        counts[ExecTable] += accnt.execs().size();
+        counts[TradeTable] += distance(accnt.trades().begin(), accnt.trades().end());
+        counts[PosnTable] += distance(accnt.posns().begin(), accnt.posns().end());
+    }
+
+    // Tables follow the header, each aligned to eight bytes.
+    ImageHeader hdr{};
+    size_t size{(sizeof(ImageHeader) + 7) & ~size_t{7}};
+    for (size_t t{0}; t < TableCount; ++t) {
+        hdr.tables[t].offset = size;
+        hdr.tables[t].count = counts[t];
+        size += (counts[t] * RecSizes[t] + 7) & ~size_t{7};
+    }
+    hdr.size = size;
+    hdr.version = ImageVersion;
+    hdr.created = msSinceEpoch(now);
+
+    // Bound the previous image before the new one is reserved.
+    const auto prevExtent = memCtx.rootExtent();
+    auto* const image = static_cast<char*>(memCtx.alloc(size));
+    memcpy(image, &hdr, sizeof(hdr));
+    {
+        auto* rec = table<AssetRec>(image, AssetTable);
+        for (const auto& asset : serv.assets()) {
+            put(*rec++, asset);
+        }
+    }
+    {
+        auto* rec = table<InstrRec>(image, InstrTable);
+        for (const auto& instr : serv.instrs()) {
+            put(*rec++, instr);
+        }
+    }
+    {
+        auto* rec = table<MarketRec>(image, MarketTable);
+        for (const auto& market : serv.markets()) {
+            put(*rec++, market);
+        }
+    }
+    {
+        auto* rec = table<OrderRec>(image, OrderTable);
+        forEachOrder(serv, [&rec](const Order& order) { put(*rec++, order); });
+    }
+    auto* exec = table<ExecRec>(image, ExecTable);
+    auto* trade = table<ExecRec>(image, TradeTable);
+    auto* posn = table<PosnRec>(image, PosnTable);
+    for (const auto& accnt : serv.accnts()) {
+        for (const auto& ptr : accnt.execs()) {
+            put(*exec++, *ptr);
+        }
+        for (const auto& val : accnt.trades()) {
+            put(*trade++, val);
+        }
+        for (const auto& val : accnt.posns()) {
+            put(*posn++, val);
+        }
+    }
+
+    if (auto* const prev = memCtx.root()) {
+        const auto prevSize = static_cast<const ImageHeader*>(prev)->size;
+        // A corrupt image is leaked, rather than freed with the wrong size.
+        if (prevSize >= sizeof(ImageHeader) && prevSize <= prevExtent) {
+            memCtx.dealloc(prev, prevSize);
+        }
+    }
+    return image;
+}
+
+} // namespace lob
+} // namespace swirly
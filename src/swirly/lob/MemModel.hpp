@@ -0,0 +1,93 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_LOB_MEMMODEL_HPP
+#define SWIRLY_LOB_MEMMODEL_HPP
+
+#include <swirly/fin/Model.hpp>
+
+namespace swirly {
+inline namespace app {
+class MemCtx;
+} // namespace app
+
+inline namespace lob {
+
+class Serv;
+
+/**
+ * Model that reads the engine state from an image held in a persistent memory pool.
+ *
+ * The image comprises arrays of flat records that are addressed by their offset from the start of
+ * the image, so that it remains valid when the pool is remapped at a different address.
+ */
+class SWIRLY_API MemModel : public Model {
+  public:
+    /**
+     * @param image Root block of a warm memory pool.
+     * @param extent Number of bytes that may be read from the image, as returned by
+     * MemCtx::rootExtent().
+     *
+     * @throw Exception if the image was written by an incompatible version, or if the image or any
+     * of its tables does not lie within the extent.
+     */
+    MemModel(const void* image, std::size_t extent);
+    ~MemModel() override;
+
+    // Copy.
+    MemModel(const MemModel&) noexcept;
+    MemModel& operator=(const MemModel&) noexcept;
+
+    // Move.
+    MemModel(MemModel&&) noexcept;
+    MemModel& operator=(MemModel&&) noexcept;
+
+    /**
+     * Returns the time at which the image was saved.
+     */
+    Time created() const noexcept;
+
+  protected:
+    void doReadAsset(const ModelCallback<AssetPtr>& cb) const override;
+
+    void doReadInstr(const ModelCallback<InstrPtr>& cb) const override;
+
+    void doReadMarket(const ModelCallback<MarketPtr>& cb) const override;
+
+    void doReadOrder(const ModelCallback<OrderPtr>& cb) const override;
+
+    void doReadExec(Time since, const ModelCallback<ExecPtr>& cb) const override;
+
+    void doReadTrade(const ModelCallback<ExecPtr>& cb) const override;
+
+    void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const override;
+
+  private:
+    const char* image_;
+};
+
+/**
+ * Writes an image of the engine state to the memory pool, and frees the image recorded as the
+ * pool's root, if any.
+ *
+ * @return the new image, which should be recorded as the pool's root.
+ */
+SWIRLY_API void* saveImage(const Serv& serv, MemCtx& memCtx, Time now);
+
+} // namespace lob
+} // namespace swirly
+
+#endif // SWIRLY_LOB_MEMMODEL_HPP
@@ -0,0 +1,167 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MemModel.hpp"
+
+#include <swirly/lob/Accnt.hpp>
+#include <swirly/lob/Response.hpp>
+#include <swirly/lob/Serv.hpp>
+#include <swirly/lob/Test.hpp>
+
+#include <swirly/fin/MsgQueue.hpp>
+
+#include <swirly/app/MemCtx.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+constexpr auto Today = ymdToJd(2014, 3, 11);
+constexpr auto SettlDay = Today + 2_jd;
+constexpr auto MarketId = toMarketId(1_id32, SettlDay);
+
+constexpr auto Now = jdToTime(Today);
+
+class SWIRLY_API MarketModel : public swirly::TestModel {
+  protected:
+    void doReadMarket(const ModelCallback<MarketPtr>& cb) const override
+    {
+        cb(Market::make(MarketId, "EURUSD"sv, SettlDay, 0x1U));
+    }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MemModelSuite)
+
+BOOST_AUTO_TEST_CASE(MemModelCase)
+{
+    MemCtx memCtx{1 << 20};
+    MsgQueue mq{1 << 18};
+
+    void* image{nullptr};
+    Id64 maxId;
+    {
+        Serv serv{mq, 1 << 4};
+        serv.load(MarketModel{}, Now);
+
+        auto& market = serv.market(MarketId);
+        Response resp;
+        serv.createOrder(serv.accnt("MARAYL"sv), market, "first"sv, Side::Buy, 5_lts, 12345_tks,
+                         1_lts, Now, resp);
+        resp.clear();
+        serv.createOrder(serv.accnt("GOSAYL"sv), market, "second"sv, Side::Buy, 5_lts, 12345_tks,
+                         1_lts, Now, resp);
+        resp.clear();
+        serv.createOrder(serv.accnt("EDIAYL"sv), market, ""sv, Side::Sell, 3_lts, 12345_tks, 1_lts,
+                         Now, resp);
+
+        maxId = market.maxId();
+        image = saveImage(serv, memCtx, Now);
+    }
+
+    memCtx.persist(image);
+    BOOST_TEST(memCtx.root() == image);
+    const MemModel model{image, memCtx.rootExtent()};
+    BOOST_TEST(model.created() == Now);
+
+    Serv serv{mq, 1 << 4};
+    serv.load(model, Now);
+
+    BOOST_TEST(distance(serv.assets().begin(), serv.assets().end()) == 24);
+    BOOST_TEST(distance(serv.instrs().begin(), serv.instrs().end()) == 21);
+
+    const auto& market = serv.market(MarketId);
+    BOOST_TEST(market.lastLots() == 3_lts);
+    BOOST_TEST(market.lastTicks() == 12345_tks);
+    BOOST_TEST(market.maxId() == maxId);
+
+    // Time priority is preserved.
+    const auto& bids = market.bidSide().orders();
+    BOOST_TEST(distance(bids.begin(), bids.end()) == 2);
+    auto it = bids.begin();
+    BOOST_TEST(it->ref() == "first"sv);
+    BOOST_TEST(it->resdLots() == 2_lts);
+    ++it;
+    BOOST_TEST(it->ref() == "second"sv);
+    const auto& offers = market.offerSide().orders();
+    BOOST_TEST(distance(offers.begin(), offers.end()) == 0);
+
+    const auto& accnt = serv.accnt("MARAYL"sv);
+    BOOST_TEST(distance(accnt.orders().begin(), accnt.orders().end()) == 1);
+    BOOST_TEST(accnt.exists("first"sv));
+    BOOST_TEST(accnt.execs().size() == 2U);
+    // Most recent first.
+    BOOST_TEST(accnt.execs().front()->state() == State::Trade);
+    BOOST_TEST(distance(accnt.trades().begin(), accnt.trades().end()) == 1);
+
+    const auto& posn = *accnt.posns().begin();
+    BOOST_TEST(posn.buyLots() == 3_lts);
+    BOOST_TEST(posn.sellLots() == 0_lts);
+
+    // Saving a new image frees the old one.
+    memCtx.persist(saveImage(serv, memCtx, Now));
+    uint64_t live{memCtx.largeStats().live};
+    for (size_t sc{0}; sc < MemCtx::SizeClasses; ++sc) {
+        live += memCtx.stats(sc).live;
+    }
+    BOOST_TEST(live == 1U);
+}
+
+BOOST_AUTO_TEST_CASE(MemModelCorruptCase)
+{
+    MemCtx memCtx{1 << 20};
+    MsgQueue mq{1 << 18};
+
+    void* image{nullptr};
+    {
+        Serv serv{mq, 1 << 4};
+        serv.load(MarketModel{}, Now);
+        image = saveImage(serv, memCtx, Now);
+    }
+    memCtx.persist(image);
+    const auto extent = memCtx.rootExtent();
+    BOOST_TEST(extent > 0U);
+
+    // The image size is the first field of the header.
+    auto& size = *static_cast<uint64_t*>(image);
+    const auto prevSize = size;
+    BOOST_CHECK_NO_THROW(MemModel(image, extent));
+
+    // Truncated.
+    BOOST_CHECK_THROW(MemModel(image, 8), Exception);
+    BOOST_CHECK_THROW(MemModel(image, prevSize - 1), Exception);
+
+    // Larger than the pool.
+    size = extent + 1;
+    BOOST_CHECK_THROW(MemModel(image, extent), Exception);
+
+    // Too small for the tables that follow the header.
+    size = 128;
+    BOOST_CHECK_THROW(MemModel(image, extent), Exception);
+
+    // A corrupt image is leaked rather than freed.
+    size = extent + 1;
+    Serv serv{mq, 1 << 4};
+    serv.load(MarketModel{}, Now);
+    memCtx.persist(saveImage(serv, memCtx, Now));
+    BOOST_TEST(memCtx.root() != image);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -66,9 +66,21 @@ struct Serv::Impl {
         execs_.reserve(1 + 16);
     }
 
+    void setMarketSlot(MarketSlot slot) noexcept { marketSlot_ = slot; }
+
+    void notify(const Market& market, Time now)
+    {
+        if (marketSlot_) {
+            marketSlot_(market, now);
+        }
+    }
+
     void load(const Model& model, Time now)
     {
         const auto busDay = busDay_(now);
+        // One week ago.
+        const auto since = now - 604800000ms;
+        model.prefetch(since, busDay);
         model.readAsset([& assets = assets_](auto ptr) { assets.insert(move(ptr)); });
         model.readInstr([& instrs = instrs_](auto ptr) { instrs.insert(move(ptr)); });
         model.readMarket([& markets = markets_](MarketPtr ptr) { markets.insert(ptr); });
@@ -86,8 +98,7 @@ struct Serv::Impl {
             it->insertOrder(ptr);
             success = true;
         });
-        // One week ago.
-        model.readExec(now - 604800000ms, [this](auto ptr) {
+        model.readExec(since, [this](auto ptr) {
             auto& accnt = this->accnt(ptr->accnt());
             accnt.pushExecBack(ptr);
         });
@@ -137,6 +148,8 @@ struct Serv::Impl {
 
     const MarketSet& markets() const noexcept { return markets_; }
 
+    const AccntSet& accnts() const noexcept { return accnts_; }
+
     Accnt& accnt(Symbol symbol)
     {
         AccntSet::Iterator it;
@@ -702,6 +715,7 @@ struct Serv::Impl {
     }
 
     MsgQueue& mq_;
+    MarketSlot marketSlot_;
     const BusinessDay busDay_{MarketZone};
     const size_t maxExecs_;
     AssetSet assets_;
@@ -728,6 +742,11 @@ void Serv::load(const Model& model, Time now)
     impl_->load(model, now);
 }
 
+void Serv::setMarketSlot(MarketSlot slot) noexcept
+{
+    impl_->setMarketSlot(slot);
+}
+
 const AssetSet& Serv::assets() const noexcept
 {
     return impl_->assets();
@@ -758,14 +777,22 @@ const Accnt& Serv::accnt(Symbol symbol) const
     return impl_->accnt(symbol);
 }
 
+const AccntSet& Serv::accnts() const noexcept
+{
+    return impl_->accnts();
+}
+
 const Market& Serv::createMarket(const Instr& instr, JDay settlDay, MarketState state, Time now)
 {
-    return impl_->createMarket(instr, settlDay, state, now);
+    const auto& market = impl_->createMarket(instr, settlDay, state, now);
+    impl_->notify(market, now);
+    return market;
 }
 
 void Serv::updateMarket(const Market& market, MarketState state, Time now)
 {
-    return impl_->updateMarket(constCast(market), state, now);
+    impl_->updateMarket(constCast(market), state, now);
+    impl_->notify(market, now);
 }
 
 void Serv::createOrder(const Accnt& accnt, const Market& market, string_view ref, Side side,
@@ -773,53 +800,62 @@ void Serv::createOrder(const Accnt& accnt, const Market& market, string_view ref
 {
     impl_->createOrder(constCast(accnt), constCast(market), ref, side, lots, ticks, minLots, now,
                        resp);
+    impl_->notify(market, now);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, const Order& order, Lots lots,
                        Time now, Response& resp)
 {
     impl_->reviseOrder(constCast(accnt), constCast(market), constCast(order), lots, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, Id64 id, Lots lots, Time now,
                        Response& resp)
 {
     impl_->reviseOrder(constCast(accnt), constCast(market), id, lots, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, string_view ref, Lots lots,
                        Time now, Response& resp)
 {
     impl_->reviseOrder(constCast(accnt), constCast(market), ref, lots, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::reviseOrder(const Accnt& accnt, const Market& market, ArrayView<Id64> ids, Lots lots,
                        Time now, Response& resp)
 {
     impl_->reviseOrder(constCast(accnt), constCast(market), ids, lots, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, const Order& order, Time now,
                        Response& resp)
 {
     impl_->cancelOrder(constCast(accnt), constCast(market), constCast(order), now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, Id64 id, Time now, Response& resp)
 {
     impl_->cancelOrder(constCast(accnt), constCast(market), id, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, string_view ref, Time now,
                        Response& resp)
 {
     impl_->cancelOrder(constCast(accnt), constCast(market), ref, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, const Market& market, ArrayView<Id64> ids, Time now,
                        Response& resp)
 {
     impl_->cancelOrder(constCast(accnt), constCast(market), ids, now, resp);
+    impl_->notify(market, now);
 }
 
 void Serv::cancelOrder(const Accnt& accnt, Time now)
@@ -22,6 +22,7 @@
 #include <swirly/fin/Market.hpp>
 
 #include <swirly/util/Array.hpp>
+#include <swirly/util/Slot.hpp>
 
 namespace swirly {
 
@@ -44,6 +45,11 @@ class Response;
 
 using TradePair = std::pair<ConstExecPtr, ConstExecPtr>;
 
+/**
+ * Invoked with a market after each change to its state or order book.
+ */
+using MarketSlot = BasicSlot<const Market&, Time>;
+
 class SWIRLY_API Serv {
   public:
     Serv(MsgQueue& mq, std::size_t maxExecs);
@@ -60,6 +66,8 @@ class SWIRLY_API Serv {
 
     void load(const Model& model, Time now);
 
+    void setMarketSlot(MarketSlot slot) noexcept;
+
     const AssetSet& assets() const noexcept;
 
     const Instr& instr(Symbol symbol) const;
@@ -68,6 +76,8 @@ class SWIRLY_API Serv {
 
     const Accnt& accnt(Symbol symbol) const;
 
+    const SymbolSet<Accnt>& accnts() const noexcept;
+
     const Market& market(Id64 id) const;
 
     const MarketSet& markets() const noexcept;
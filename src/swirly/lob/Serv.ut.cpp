@@ -48,7 +48,7 @@ class SWIRLY_API TestModel : public swirly::TestModel {
 
 struct ServFixture {
     ServFixture() { serv.load(TestModel{}, Now); }
-    MsgQueue mq{1 << 10};
+    MsgQueue mq{1 << 18};
     Serv serv{mq, 1 << 4};
 };
 
@@ -19,6 +19,7 @@
 #include "Utility.hxx"
 
 #include <swirly/fin/Exec.hpp>
+#include <swirly/fin/Msg.hpp>
 
 #include <swirly/util/Config.hpp>
 
@@ -50,6 +51,20 @@ constexpr auto UpdateExecSql =       //
     "UPDATE exec_t SET archive = ?3" //
     " WHERE market_id = ?1 AND id = ?2"sv;
 
+constexpr auto SelectSeqSql = "SELECT MAX(seq) FROM journ_t"sv;
+
+constexpr auto InsertJournSql =      //
+    "INSERT INTO journ_t (seq, msg)" //
+    " VALUES (?, ?)"sv;
+
+constexpr auto SelectJournSql = //
+    "SELECT msg FROM journ_t"   //
+    " WHERE seq = ?"sv;
+
+constexpr auto DeleteJournSql = //
+    "DELETE FROM journ_t"       //
+    " WHERE seq <= ?"sv;
+
 } // namespace
 
 SqlJourn::SqlJourn(const Config& config)
@@ -61,7 +76,16 @@ SqlJourn::SqlJourn(const Config& config)
 , updateMarketStmt_{prepare(*db_, UpdateMarketSql)}
 , insertExecStmt_{prepare(*db_, InsertExecSql)}
 , updateExecStmt_{prepare(*db_, UpdateExecSql)}
+, insertJournStmt_{prepare(*db_, InsertJournSql)}
+, selectJournStmt_{prepare(*db_, SelectJournSql)}
+, deleteJournStmt_{prepare(*db_, DeleteJournSql)}
 {
+    auto stmt = prepare(*db_, SelectSeqSql);
+    ScopedStep step{*stmt};
+    if (step()) {
+        // Null if the journal is empty.
+        seq_ = column<int64_t>(*stmt, 0);
+    }
 }
 
 SqlJourn::~SqlJourn() = default;
@@ -70,9 +94,60 @@ SqlJourn::SqlJourn(SqlJourn&&) = default;
 
 SqlJourn& SqlJourn::operator=(SqlJourn&&) = default;
 
+uint64_t SqlJourn::doSeq() const noexcept
+{
+    return seq_;
+}
+
+size_t SqlJourn::doRead(uint64_t seq, void* buf, size_t size)
+{
+    auto& stmt = *selectJournStmt_;
+
+    ScopedBind bind{stmt};
+    bind(seq);
+
+    ScopedStep step{stmt};
+    if (!step()) {
+        return 0;
+    }
+    const size_t len = sqlite3_column_bytes(&stmt, 0);
+    if (len <= size) {
+        memcpy(buf, sqlite3_column_blob(&stmt, 0), len);
+    }
+    return len;
+}
+
 void SqlJourn::doWrite(const Msg& msg)
 {
+    // The message is logged in the same transaction as its effects, so that the sequence number
+    // always identifies the state of the database.
+    Transaction trans{*this};
     dispatch(msg);
+
+    auto& stmt = *insertJournStmt_;
+
+    ScopedBind bind{stmt};
+    bind(seq_ + 1);
+    bind(&msg, msgSize(msg));
+
+    stepOnce(stmt);
+    trans.commit();
+    ++seq_;
+}
+
+void SqlJourn::doTruncate(uint64_t seq)
+{
+    // The last message identifies the journal's sequence number on restart.
+    if (seq_ <= 1) {
+        return;
+    }
+    seq = min(seq, seq_ - 1);
+    auto& stmt = *deleteJournStmt_;
+
+    ScopedBind bind{stmt};
+    bind(seq);
+
+    stepOnce(stmt);
 }
 
 void SqlJourn::begin()
@@ -120,7 +195,6 @@ void SqlJourn::onUpdateMarket(const UpdateMarket& body)
 
 void SqlJourn::onCreateExec(const CreateExec& body)
 {
-    Transaction trans{*this};
     auto& stmt = *insertExecStmt_;
 
     ScopedBind bind{stmt};
@@ -154,19 +228,14 @@ void SqlJourn::onCreateExec(const CreateExec& body)
     bind(body.created); // Created.
 
     stepOnce(stmt);
-    trans.commit();
 }
 
 void SqlJourn::onArchiveTrade(const ArchiveTrade& body)
 {
-    Transaction trans{*this};
     auto& stmt = *updateExecStmt_;
 
-    for (size_t i{0}; i < MaxIds; ++i) {
+    for (size_t i{0}; i < body.count; ++i) {
         const auto id = body.ids[i];
-        if (id == 0_id64) {
-            break;
-        }
         ScopedBind bind{stmt};
         bind(body.marketId);
         bind(id);
@@ -174,7 +243,6 @@ void SqlJourn::onArchiveTrade(const ArchiveTrade& body)
 
         stepOnce(stmt);
     }
-    trans.commit();
 }
 
 } // namespace sqlite
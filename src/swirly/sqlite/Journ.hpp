@@ -50,8 +50,14 @@ class SWIRLY_API SqlJourn
     SqlJourn& operator=(SqlJourn&&);
 
   protected:
+    std::uint64_t doSeq() const noexcept override;
+
+    std::size_t doRead(std::uint64_t seq, void* buf, std::size_t size) override;
+
     void doWrite(const Msg& msg) override;
 
+    void doTruncate(std::uint64_t seq) override;
+
   private:
     void begin();
 
@@ -75,6 +81,10 @@ class SWIRLY_API SqlJourn
     sqlite::StmtPtr updateMarketStmt_;
     sqlite::StmtPtr insertExecStmt_;
     sqlite::StmtPtr updateExecStmt_;
+    sqlite::StmtPtr insertJournStmt_;
+    sqlite::StmtPtr selectJournStmt_;
+    sqlite::StmtPtr deleteJournStmt_;
+    std::uint64_t seq_{0};
 };
 
 } // namespace sqlite
@@ -27,6 +27,10 @@
 #include <swirly/fin/Posn.hpp>
 
 #include <swirly/util/Config.hpp>
+#include <swirly/util/Log.hpp>
+
+#include <array>
+#include <future>
 
 namespace swirly {
 inline namespace sqlite {
@@ -61,14 +65,132 @@ constexpr auto SelectTradeSql =
     " posn_lots, posn_cost, liq_ind_id, cpty, created"                                    //
     " FROM exec_t WHERE state_id = 4 AND archive IS NULL;"sv;
 
-constexpr auto SelectPosnSql = //
-    "SELECT accnt, market_id, instr, settl_day, side_id, lots, cost FROM posn_v;"sv;
+constexpr auto SelectPosnSql =                                                            //
+    "SELECT accnt, market_id, instr, settl_day, buy_lots, buy_cost, sell_lots, sell_cost" //
+    " FROM posn_t;"sv;
+
+enum : size_t { OrderTable, ExecTable, TradeTable, PosnTable, TableCount };
+
+/**
+ * Result rows stored column-wise, so that they can be fetched on one thread and turned into objects
+ * on another. Integer values are widened to 64 bits, and text values are stored as offsets into a
+ * single buffer of null-terminated strings, where offset zero denotes null.
+ */
+class ColumnSet {
+  public:
+    ColumnSet() = default;
+    ~ColumnSet() = default;
+
+    // Copy.
+    ColumnSet(const ColumnSet&) = delete;
+    ColumnSet& operator=(const ColumnSet&) = delete;
+
+    // Move.
+    ColumnSet(ColumnSet&&) = default;
+    ColumnSet& operator=(ColumnSet&&) = default;
+
+    size_t size() const noexcept { return size_; }
+    /**
+     * Returns the time taken to fetch the rows.
+     */
+    Duration elapsed() const noexcept { return elapsed_; }
+
+    template <typename ValueT>
+    ValueT get(size_t row, int col) const noexcept
+    {
+        const auto val = cols_[col][row];
+        if constexpr (is_same_v<ValueT, string_view>) {
+            return text_.data() + val;
+        } else if constexpr (is_same_v<ValueT, Time>) {
+            return toTime(Millis{val});
+        } else if constexpr (isIntWrapper<ValueT>) {
+            return ValueT{static_cast<typename ValueT::ValueType>(val)};
+        } else {
+            return static_cast<ValueT>(val);
+        }
+    }
+
+    void fetch(sqlite3_stmt& stmt)
+    {
+        const auto start = UnixClock::now();
+        const int n{sqlite3_column_count(&stmt)};
+        cols_.resize(n);
+        while (step(stmt)) {
+            for (int i{0}; i < n; ++i) {
+                int64_t val{0};
+                switch (sqlite3_column_type(&stmt, i)) {
+                case SQLITE_NULL:
+                    break;
+                case SQLITE_TEXT: {
+                    // Text must be retrieved before its size.
+                    const auto* const text = sqlite3_column_text(&stmt, i);
+                    val = text_.size();
+                    text_.append(reinterpret_cast<const char*>(text),
+                                 sqlite3_column_bytes(&stmt, i));
+                    text_.push_back('\0');
+                } break;
+                default:
+                    val = sqlite3_column_int64(&stmt, i);
+                    break;
+                }
+                cols_[i].push_back(val);
+            }
+            ++size_;
+        }
+        elapsed_ = UnixClock::now() - start;
+    }
+
+  private:
+    vector<vector<int64_t>> cols_;
+    string text_ = string(1, '\0');
+    size_t size_{0};
+    Duration elapsed_{};
+};
+
+template <typename... ArgsT>
+ColumnSet select(sqlite3& db, string_view sql, ArgsT... args)
+{
+    StmtPtr stmt{prepare(db, sql)};
+    ScopedBind bind{*stmt};
+    (bind(args), ...);
+    ColumnSet cs;
+    cs.fetch(*stmt);
+    return cs;
+}
+
+/**
+ * Returns the prefetched result if one is pending, otherwise calls fn to fetch it synchronously.
+ */
+template <typename FnT>
+ColumnSet take(future<ColumnSet>* fut, FnT fn)
+{
+    return fut && fut->valid() ? fut->get() : fn();
+}
+
+void report(string_view name, const ColumnSet& cs, Duration wait, Duration build)
+{
+    using namespace chrono;
+    SWIRLY_INFO << "loaded "sv << cs.size() << ' ' << name << ": fetch "sv
+                << duration_cast<Millis>(cs.elapsed()).count() << "ms, wait "sv
+                << duration_cast<Millis>(wait).count() << "ms, build "sv
+                << duration_cast<Millis>(build).count() << "ms"sv;
+}
 
 } // namespace
 
+struct SqlModel::Prefetch {
+    Time since;
+    array<future<ColumnSet>, TableCount> results;
+};
+
 SqlModel::SqlModel(const Config& config)
 : db_{openDb(config.get("sqlite_model", "swirly.db"), SQLITE_OPEN_READONLY, config)}
 {
+    loadDbs_.reserve(TableCount);
+    for (size_t i{0}; i < TableCount; ++i) {
+        loadDbs_.push_back(
+            openDb(config.get("sqlite_model", "swirly.db"), SQLITE_OPEN_READONLY, config));
+    }
 }
 
 SqlModel::~SqlModel() = default;
@@ -86,12 +208,12 @@ void SqlModel::doReadAsset(const ModelCallback<AssetPtr>& cb) const
         TypeId   //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectAssetSql)};
-    while (step(*stmt)) {
-        cb(Asset::make(column<Id32>(*stmt, Id),             //
-                       column<string_view>(*stmt, Symbol),  //
-                       column<string_view>(*stmt, Display), //
-                       column<AssetType>(*stmt, TypeId)));
+    const auto cs = select(*db_, SelectAssetSql);
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Asset::make(cs.get<Id32>(i, Id),             //
+                       cs.get<string_view>(i, Symbol),  //
+                       cs.get<string_view>(i, Display), //
+                       cs.get<AssetType>(i, TypeId)));
     }
 }
 
@@ -112,20 +234,20 @@ void SqlModel::doReadInstr(const ModelCallback<InstrPtr>& cb) const
         MaxLots    //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectInstrSql)};
-    while (step(*stmt)) {
-        cb(Instr::make(column<Id32>(*stmt, Id),               //
-                       column<string_view>(*stmt, Symbol),    //
-                       column<string_view>(*stmt, Display),   //
-                       column<string_view>(*stmt, BaseAsset), //
-                       column<string_view>(*stmt, TermCcy),   //
-                       column<int>(*stmt, LotNumer),          //
-                       column<int>(*stmt, LotDenom),          //
-                       column<int>(*stmt, TickNumer),         //
-                       column<int>(*stmt, TickDenom),         //
-                       column<int>(*stmt, PipDp),             //
-                       column<Lots>(*stmt, MinLots),          //
-                       column<Lots>(*stmt, MaxLots)));
+    const auto cs = select(*db_, SelectInstrSql);
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Instr::make(cs.get<Id32>(i, Id),               //
+                       cs.get<string_view>(i, Symbol),    //
+                       cs.get<string_view>(i, Display),   //
+                       cs.get<string_view>(i, BaseAsset), //
+                       cs.get<string_view>(i, TermCcy),   //
+                       cs.get<int>(i, LotNumer),          //
+                       cs.get<int>(i, LotDenom),          //
+                       cs.get<int>(i, TickNumer),         //
+                       cs.get<int>(i, TickDenom),         //
+                       cs.get<int>(i, PipDp),             //
+                       cs.get<Lots>(i, MinLots),          //
+                       cs.get<Lots>(i, MaxLots)));
     }
 }
 
@@ -142,16 +264,16 @@ void SqlModel::doReadMarket(const ModelCallback<MarketPtr>& cb) const
         MaxId      //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectMarketSql)};
-    while (step(*stmt)) {
-        cb(Market::make(column<Id64>(*stmt, Id),           //
-                        column<string_view>(*stmt, Instr), //
-                        column<JDay>(*stmt, SettlDay),     //
-                        column<MarketState>(*stmt, State), //
-                        column<Lots>(*stmt, LastLots),     //
-                        column<Ticks>(*stmt, LastTicks),   //
-                        column<Time>(*stmt, LastTime),     //
-                        column<Id64>(*stmt, MaxId)));
+    const auto cs = select(*db_, SelectMarketSql);
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Market::make(cs.get<Id64>(i, Id),           //
+                        cs.get<string_view>(i, Instr), //
+                        cs.get<JDay>(i, SettlDay),     //
+                        cs.get<MarketState>(i, State), //
+                        cs.get<Lots>(i, LastLots),     //
+                        cs.get<Ticks>(i, LastTicks),   //
+                        cs.get<Time>(i, LastTime),     //
+                        cs.get<Id64>(i, MaxId)));
     }
 }
 
@@ -178,27 +300,31 @@ void SqlModel::doReadOrder(const ModelCallback<OrderPtr>& cb) const
         Modified   //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectOrderSql)};
-    while (step(*stmt)) {
-        cb(Order::make(column<string_view>(*stmt, Accnt),       //
-                       column<Id64>(*stmt, MarketId),           //
-                       column<string_view>(*stmt, Instr),       //
-                       column<JDay>(*stmt, SettlDay),           //
-                       column<Id64>(*stmt, Id),                 //
-                       column<string_view>(*stmt, Ref),         //
-                       column<swirly::State>(*stmt, State),     //
-                       column<swirly::Side>(*stmt, Side),       //
-                       column<swirly::Lots>(*stmt, Lots),       //
-                       column<swirly::Ticks>(*stmt, Ticks),     //
-                       column<swirly::Lots>(*stmt, ResdLots),   //
-                       column<swirly::Lots>(*stmt, ExecLots),   //
-                       column<swirly::Cost>(*stmt, ExecCost),   //
-                       column<swirly::Lots>(*stmt, LastLots),   //
-                       column<swirly::Ticks>(*stmt, LastTicks), //
-                       column<swirly::Lots>(*stmt, MinLots),    //
-                       column<Time>(*stmt, Created),            //
-                       column<Time>(*stmt, Modified)));
+    const auto start = UnixClock::now();
+    const auto cs = take(prefetch_ ? &prefetch_->results[OrderTable] : nullptr,
+                         [this]() { return select(*db_, SelectOrderSql); });
+    const auto ready = UnixClock::now();
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Order::make(cs.get<string_view>(i, Accnt),       //
+                       cs.get<Id64>(i, MarketId),           //
+                       cs.get<string_view>(i, Instr),       //
+                       cs.get<JDay>(i, SettlDay),           //
+                       cs.get<Id64>(i, Id),                 //
+                       cs.get<string_view>(i, Ref),         //
+                       cs.get<swirly::State>(i, State),     //
+                       cs.get<swirly::Side>(i, Side),       //
+                       cs.get<swirly::Lots>(i, Lots),       //
+                       cs.get<swirly::Ticks>(i, Ticks),     //
+                       cs.get<swirly::Lots>(i, ResdLots),   //
+                       cs.get<swirly::Lots>(i, ExecLots),   //
+                       cs.get<swirly::Cost>(i, ExecCost),   //
+                       cs.get<swirly::Lots>(i, LastLots),   //
+                       cs.get<swirly::Ticks>(i, LastTicks), //
+                       cs.get<swirly::Lots>(i, MinLots),    //
+                       cs.get<Time>(i, Created),            //
+                       cs.get<Time>(i, Modified)));
     }
+    report("orders"sv, cs, ready - start, UnixClock::now() - ready);
 }
 
 void SqlModel::doReadExec(Time since, const ModelCallback<ExecPtr>& cb) const
@@ -229,34 +355,37 @@ void SqlModel::doReadExec(Time since, const ModelCallback<ExecPtr>& cb) const
         Created    //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectExecSql)};
-    ScopedBind bind{*stmt};
-    bind(since);
-    while (step(*stmt)) {
-        cb(Exec::make(column<string_view>(*stmt, Accnt),       //
-                      column<Id64>(*stmt, MarketId),           //
-                      column<string_view>(*stmt, Instr),       //
-                      column<JDay>(*stmt, SettlDay),           //
-                      column<Id64>(*stmt, Id),                 //
-                      column<Id64>(*stmt, OrderId),            //
-                      column<string_view>(*stmt, Ref),         //
-                      column<swirly::State>(*stmt, State),     //
-                      column<swirly::Side>(*stmt, Side),       //
-                      column<swirly::Lots>(*stmt, Lots),       //
-                      column<swirly::Ticks>(*stmt, Ticks),     //
-                      column<swirly::Lots>(*stmt, ResdLots),   //
-                      column<swirly::Lots>(*stmt, ExecLots),   //
-                      column<swirly::Cost>(*stmt, ExecCost),   //
-                      column<swirly::Lots>(*stmt, LastLots),   //
-                      column<swirly::Ticks>(*stmt, LastTicks), //
-                      column<swirly::Lots>(*stmt, MinLots),    //
-                      column<Id64>(*stmt, MatchId),            //
-                      column<swirly::Lots>(*stmt, PosnLots),   //
-                      column<swirly::Cost>(*stmt, PosnCost),   //
-                      column<swirly::LiqInd>(*stmt, LiqInd),   //
-                      column<string_view>(*stmt, Cpty),        //
-                      column<Time>(*stmt, Created)));
+    const auto start = UnixClock::now();
+    const auto cs = take(prefetch_ && prefetch_->since == since ? &prefetch_->results[ExecTable]
+                                                               : nullptr,
+                         [this, since]() { return select(*db_, SelectExecSql, since); });
+    const auto ready = UnixClock::now();
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Exec::make(cs.get<string_view>(i, Accnt),       //
+                      cs.get<Id64>(i, MarketId),           //
+                      cs.get<string_view>(i, Instr),       //
+                      cs.get<JDay>(i, SettlDay),           //
+                      cs.get<Id64>(i, Id),                 //
+                      cs.get<Id64>(i, OrderId),            //
+                      cs.get<string_view>(i, Ref),         //
+                      cs.get<swirly::State>(i, State),     //
+                      cs.get<swirly::Side>(i, Side),       //
+                      cs.get<swirly::Lots>(i, Lots),       //
+                      cs.get<swirly::Ticks>(i, Ticks),     //
+                      cs.get<swirly::Lots>(i, ResdLots),   //
+                      cs.get<swirly::Lots>(i, ExecLots),   //
+                      cs.get<swirly::Cost>(i, ExecCost),   //
+                      cs.get<swirly::Lots>(i, LastLots),   //
+                      cs.get<swirly::Ticks>(i, LastTicks), //
+                      cs.get<swirly::Lots>(i, MinLots),    //
+                      cs.get<Id64>(i, MatchId),            //
+                      cs.get<swirly::Lots>(i, PosnLots),   //
+                      cs.get<swirly::Cost>(i, PosnCost),   //
+                      cs.get<swirly::LiqInd>(i, LiqInd),   //
+                      cs.get<string_view>(i, Cpty),        //
+                      cs.get<Time>(i, Created)));
     }
+    report("execs"sv, cs, ready - start, UnixClock::now() - ready);
 }
 
 void SqlModel::doReadTrade(const ModelCallback<ExecPtr>& cb) const
@@ -286,32 +415,36 @@ void SqlModel::doReadTrade(const ModelCallback<ExecPtr>& cb) const
         Created    //
     };
 
-    StmtPtr stmt{prepare(*db_, SelectTradeSql)};
-    while (step(*stmt)) {
-        cb(Exec::make(column<string_view>(*stmt, Accnt),       //
-                      column<Id64>(*stmt, MarketId),           //
-                      column<string_view>(*stmt, Instr),       //
-                      column<JDay>(*stmt, SettlDay),           //
-                      column<Id64>(*stmt, Id),                 //
-                      column<Id64>(*stmt, OrderId),            //
-                      column<string_view>(*stmt, Ref),         //
-                      State::Trade,                            //
-                      column<swirly::Side>(*stmt, Side),       //
-                      column<swirly::Lots>(*stmt, Lots),       //
-                      column<swirly::Ticks>(*stmt, Ticks),     //
-                      column<swirly::Lots>(*stmt, ResdLots),   //
-                      column<swirly::Lots>(*stmt, ExecLots),   //
-                      column<swirly::Cost>(*stmt, ExecCost),   //
-                      column<swirly::Lots>(*stmt, LastLots),   //
-                      column<swirly::Ticks>(*stmt, LastTicks), //
-                      column<swirly::Lots>(*stmt, MinLots),    //
-                      column<Id64>(*stmt, MatchId),            //
-                      column<swirly::Lots>(*stmt, PosnLots),   //
-                      column<swirly::Cost>(*stmt, PosnCost),   //
-                      column<swirly::LiqInd>(*stmt, LiqInd),   //
-                      column<string_view>(*stmt, Cpty),        //
-                      column<Time>(*stmt, Created)));
+    const auto start = UnixClock::now();
+    const auto cs = take(prefetch_ ? &prefetch_->results[TradeTable] : nullptr,
+                         [this]() { return select(*db_, SelectTradeSql); });
+    const auto ready = UnixClock::now();
+    for (size_t i{0}; i < cs.size(); ++i) {
+        cb(Exec::make(cs.get<string_view>(i, Accnt),       //
+                      cs.get<Id64>(i, MarketId),           //
+                      cs.get<string_view>(i, Instr),       //
+                      cs.get<JDay>(i, SettlDay),           //
+                      cs.get<Id64>(i, Id),                 //
+                      cs.get<Id64>(i, OrderId),            //
+                      cs.get<string_view>(i, Ref),         //
+                      State::Trade,                        //
+                      cs.get<swirly::Side>(i, Side),       //
+                      cs.get<swirly::Lots>(i, Lots),       //
+                      cs.get<swirly::Ticks>(i, Ticks),     //
+                      cs.get<swirly::Lots>(i, ResdLots),   //
+                      cs.get<swirly::Lots>(i, ExecLots),   //
+                      cs.get<swirly::Cost>(i, ExecCost),   //
+                      cs.get<swirly::Lots>(i, LastLots),   //
+                      cs.get<swirly::Ticks>(i, LastTicks), //
+                      cs.get<swirly::Lots>(i, MinLots),    //
+                      cs.get<Id64>(i, MatchId),            //
+                      cs.get<swirly::Lots>(i, PosnLots),   //
+                      cs.get<swirly::Cost>(i, PosnCost),   //
+                      cs.get<swirly::LiqInd>(i, LiqInd),   //
+                      cs.get<string_view>(i, Cpty),        //
+                      cs.get<Time>(i, Created)));
     }
+    report("trades"sv, cs, ready - start, UnixClock::now() - ready);
 }
 
 void SqlModel::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
@@ -321,20 +454,24 @@ void SqlModel::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
         MarketId, //
         Instr,    //
         SettlDay, //
-        Side,     //
-        Lots,     //
-        Cost      //
+        BuyLots,  //
+        BuyCost,  //
+        SellLots, //
+        SellCost  //
     };
 
     PosnSet ps;
     PosnSet::Iterator it;
 
-    StmtPtr stmt{prepare(*db_, SelectPosnSql)};
-    while (step(*stmt)) {
-        const auto accnt = column<string_view>(*stmt, Accnt);
-        auto marketId = column<Id64>(*stmt, MarketId);
-        const auto instr = column<string_view>(*stmt, Instr);
-        auto settlDay = column<JDay>(*stmt, SettlDay);
+    const auto start = UnixClock::now();
+    const auto cs = take(prefetch_ ? &prefetch_->results[PosnTable] : nullptr,
+                         [this]() { return select(*db_, SelectPosnSql); });
+    const auto ready = UnixClock::now();
+    for (size_t i{0}; i < cs.size(); ++i) {
+        const auto accnt = cs.get<string_view>(i, Accnt);
+        auto marketId = cs.get<Id64>(i, MarketId);
+        const auto instr = cs.get<string_view>(i, Instr);
+        auto settlDay = cs.get<JDay>(i, SettlDay);
 
         // FIXME: review when end of day is implemented.
         if (settlDay != 0_jd && settlDay <= busDay) {
@@ -348,19 +485,35 @@ void SqlModel::doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const
             it = ps.insertHint(it, Posn::make(accnt, marketId, instr, settlDay));
         }
 
-        const auto side = column<swirly::Side>(*stmt, Side);
-        const auto lots = column<swirly::Lots>(*stmt, Lots);
-        const auto cost = column<swirly::Cost>(*stmt, Cost);
-        if (side == swirly::Side::Buy) {
-            it->addBuy(lots, cost);
-        } else {
-            it->addSell(lots, cost);
-        }
+        it->addBuy(cs.get<Lots>(i, BuyLots), cs.get<Cost>(i, BuyCost));
+        it->addSell(cs.get<Lots>(i, SellLots), cs.get<Cost>(i, SellCost));
     }
 
     for (it = ps.begin(); it != ps.end();) {
         cb(ps.remove(it++));
     }
+    report("posns"sv, cs, ready - start, UnixClock::now() - ready);
+}
+
+void SqlModel::doPrefetch(Time since, JDay busDay) const
+{
+    // Wait for any outstanding fetches before the connections are reused.
+    prefetch_.reset();
+    auto pf = make_unique<Prefetch>();
+    pf->since = since;
+    pf->results[OrderTable] = async(launch::async, [&db = *loadDbs_[OrderTable]]() {
+        return select(db, SelectOrderSql);
+    });
+    pf->results[ExecTable] = async(launch::async, [&db = *loadDbs_[ExecTable], since]() {
+        return select(db, SelectExecSql, since);
+    });
+    pf->results[TradeTable] = async(launch::async, [&db = *loadDbs_[TradeTable]]() {
+        return select(db, SelectTradeSql);
+    });
+    pf->results[PosnTable] = async(launch::async, [&db = *loadDbs_[PosnTable]]() {
+        return select(db, SelectPosnSql);
+    });
+    prefetch_ = move(pf);
 }
 
 } // namespace sqlite
@@ -21,6 +21,8 @@
 
 #include <swirly/fin/Model.hpp>
 
+#include <vector>
+
 namespace swirly {
 inline namespace sqlite {
 
@@ -52,8 +54,14 @@ class SWIRLY_API SqlModel : public Model {
 
     void doReadPosn(JDay busDay, const ModelCallback<PosnPtr>& cb) const override;
 
+    void doPrefetch(Time since, JDay busDay) const override;
+
   private:
+    struct Prefetch;
     sqlite::DbPtr db_;
+    // Separate connections allow the larger tables to be fetched concurrently.
+    std::vector<sqlite::DbPtr> loadDbs_;
+    mutable std::unique_ptr<Prefetch> prefetch_;
 };
 
 } // namespace sqlite
@@ -143,5 +143,13 @@ void bind(sqlite3_stmt& stmt, int col, nullptr_t)
     }
 }
 
+void bind(sqlite3_stmt& stmt, int col, const void* data, size_t size)
+{
+    int rc{sqlite3_bind_blob(&stmt, col, data, size, SQLITE_STATIC)};
+    if (rc != SQLITE_OK) {
+        throw SqlException{errMsg() << "sqlite3_bind_blob failed: "sv << lastError(stmt)};
+    }
+}
+
 } // namespace sqlite
 } // namespace swirly
@@ -165,6 +165,11 @@ constexpr struct MaybeNullTag {
 
 void bind(sqlite3_stmt& stmt, int col, std::nullptr_t);
 
+/**
+ * Bind blob. The data must remain valid until the bindings are cleared.
+ */
+void bind(sqlite3_stmt& stmt, int col, const void* data, std::size_t size);
+
 template <typename ValueT>
 void bind(sqlite3_stmt& stmt, int col, ValueT val)
 {
@@ -209,6 +214,7 @@ class ScopedBind {
     {
         bind(stmt_, ++col_, val, MaybeNull);
     }
+    void operator()(const void* data, std::size_t size) { bind(stmt_, ++col_, data, size); }
 
   private:
     sqlite3_stmt& stmt_;
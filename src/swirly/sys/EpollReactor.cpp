@@ -115,7 +115,7 @@ int EpollReactor::doPoll(Time now, Millis timeout)
     for (const auto& tq : tqs_) {
         if (!tq.empty()) {
             // Millis until next expiry.
-            const auto expiry = duration_cast<Millis>(tq.front().expiry() - now);
+            const auto expiry = duration_cast<Millis>(tq.nextExpiry() - now);
             if (expiry < timeout) {
                 timeout = max(expiry, 0ms);
             }
@@ -20,6 +20,7 @@
 #include "Reactor.hpp"
 
 #include <swirly/sys/Muxer.hpp>
+#include <swirly/sys/TimerWheel.hpp>
 
 namespace swirly {
 inline namespace sys {
@@ -69,7 +70,7 @@ class SWIRLY_API EpollReactor : public Reactor {
     EventFd efd_{0, EFD_NONBLOCK};
     static_assert(static_cast<int>(Priority::High) == 0);
     static_assert(static_cast<int>(Priority::Low) == 1);
-    std::array<TimerQueue, 2> tqs_;
+    std::array<TimerWheel, 2> tqs_;
 };
 
 } // namespace sys
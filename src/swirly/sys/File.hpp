@@ -24,8 +24,10 @@
 #include <fcntl.h>
 
 #include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 namespace swirly {
 inline namespace sys {
@@ -80,6 +82,30 @@ inline FileHandle open(const char* path, int flags)
     return fd;
 }
 
+/**
+ * Create an anonymous file.
+ */
+inline FileHandle memfd_create(const char* name, unsigned flags, std::error_code& ec) noexcept
+{
+    const auto fd = ::memfd_create(name, flags);
+    if (fd < 0) {
+        ec = makeError(errno);
+    }
+    return fd;
+}
+
+/**
+ * Create an anonymous file.
+ */
+inline FileHandle memfd_create(const char* name, unsigned flags)
+{
+    const auto fd = ::memfd_create(name, flags);
+    if (fd < 0) {
+        throw std::system_error{makeError(errno), "memfd_create"};
+    }
+    return fd;
+}
+
 /**
  * Create a file descriptor for event notification.
  */
@@ -252,6 +278,30 @@ inline std::size_t write(int fd, ConstBuffer buf)
     return write(fd, buffer_cast<const void*>(buf), buffer_size(buf));
 }
 
+/**
+ * Write data from multiple buffers to a file descriptor.
+ */
+inline ssize_t writev(int fd, const iovec* iov, int iovcnt, std::error_code& ec) noexcept
+{
+    const auto ret = ::writev(fd, iov, iovcnt);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+/**
+ * Write data from multiple buffers to a file descriptor.
+ */
+inline std::size_t writev(int fd, const iovec* iov, int iovcnt)
+{
+    const auto ret = ::writev(fd, iov, iovcnt);
+    if (ret < 0) {
+        throw std::system_error{makeError(errno), "writev"};
+    }
+    return ret;
+}
+
 /**
  * File control.
  */
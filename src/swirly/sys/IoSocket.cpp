@@ -15,3 +15,109 @@
  * 02110-1301, USA.
  */
 #include "IoSocket.hpp"
+
+#include <linux/errqueue.h>
+
+namespace swirly {
+inline namespace sys {
+namespace {
+
+// Room for the timestamps and the extended error that accompanies a transmit timestamp.
+enum { ControlSize = 256 };
+
+Time getTimestamp(msghdr& msg) noexcept
+{
+    for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPING) {
+            scm_timestamping tss;
+            std::memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+            // The software timestamp is the first of the three.
+            return toTime(tss.ts[0]);
+        }
+    }
+    return {};
+}
+
+std::uint32_t getTimestampId(msghdr& msg) noexcept
+{
+    for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+            || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+            sock_extended_err err;
+            std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_errno == ENOMSG && err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                return err.ee_data;
+            }
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+ssize_t recvTimestamped(int sockfd, MutableBuffer buf, int flags, Time& ts,
+                        std::error_code& ec) noexcept
+{
+    iovec iov{buffer_cast<void*>(buf), buffer_size(buf)};
+    alignas(cmsghdr) char control[ControlSize];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    const auto ret = os::recvmsg(sockfd, msg, flags, ec);
+    ts = ret < 0 ? Time{} : getTimestamp(msg);
+    return ret;
+}
+
+std::size_t recvTimestamped(int sockfd, MutableBuffer buf, int flags, Time& ts)
+{
+    std::error_code ec;
+    const auto ret = recvTimestamped(sockfd, buf, flags, ts, ec);
+    if (ec) {
+        throw std::system_error{ec, "recvmsg"};
+    }
+    return ret;
+}
+
+bool recvTxTimestamp(int sockfd, Time& ts, std::uint32_t& id, std::error_code& ec) noexcept
+{
+    alignas(cmsghdr) char control[ControlSize];
+    for (;;) {
+        // Timestamps requested with SOF_TIMESTAMPING_OPT_TSONLY carry no payload.
+        char data[1];
+        iovec iov{data, sizeof(data)};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        std::error_code err;
+        os::recvmsg(sockfd, msg, MSG_ERRQUEUE | MSG_DONTWAIT, err);
+        if (err) {
+            if (err.value() != EAGAIN) {
+                ec = err;
+            }
+            return false;
+        }
+        ts = getTimestamp(msg);
+        if (!isZero(ts)) {
+            id = getTimestampId(msg);
+            return true;
+        }
+        // Skip errors that do not carry a timestamp.
+    }
+}
+
+bool recvTxTimestamp(int sockfd, Time& ts, std::uint32_t& id)
+{
+    std::error_code ec;
+    const auto ret = recvTxTimestamp(sockfd, ts, id, ec);
+    if (ec) {
+        throw std::system_error{ec, "recvmsg"};
+    }
+    return ret;
+}
+
+} // namespace sys
+} // namespace swirly
@@ -19,9 +19,43 @@
 
 #include <swirly/sys/Socket.hpp>
 
+#include <swirly/util/Time.hpp>
+
 namespace swirly {
 inline namespace sys {
 
+/**
+ * Receive data along with the kernel's software receive timestamp, which is zero unless the socket
+ * has SOF_TIMESTAMPING_RX_SOFTWARE and SOF_TIMESTAMPING_SOFTWARE enabled.
+ */
+SWIRLY_API ssize_t recvTimestamped(int sockfd, MutableBuffer buf, int flags, Time& ts,
+                                   std::error_code& ec) noexcept;
+
+/**
+ * Receive data along with the kernel's software receive timestamp, which is zero unless the socket
+ * has SOF_TIMESTAMPING_RX_SOFTWARE and SOF_TIMESTAMPING_SOFTWARE enabled.
+ */
+SWIRLY_API std::size_t recvTimestamped(int sockfd, MutableBuffer buf, int flags, Time& ts);
+
+/**
+ * Read the next software transmit timestamp from the socket's error queue. With
+ * SOF_TIMESTAMPING_OPT_ID, the id is the index of the datagram, or the byte offset of the last byte
+ * sent on a stream socket.
+ *
+ * Returns false if the error queue is empty.
+ */
+SWIRLY_API bool recvTxTimestamp(int sockfd, Time& ts, std::uint32_t& id,
+                                std::error_code& ec) noexcept;
+
+/**
+ * Read the next software transmit timestamp from the socket's error queue. With
+ * SOF_TIMESTAMPING_OPT_ID, the id is the index of the datagram, or the byte offset of the last byte
+ * sent on a stream socket.
+ *
+ * Returns false if the error queue is empty.
+ */
+SWIRLY_API bool recvTxTimestamp(int sockfd, Time& ts, std::uint32_t& id);
+
 /**
  * Socket with IO operations. I.e. not a passive listener. All state is in base class, so object can
  * be sliced.
@@ -48,6 +82,24 @@ struct IoSocket : Socket {
     }
     std::size_t recv(MutableBuffer buf, int flags) { return os::recv(*sock_, buf, flags); }
 
+    ssize_t recv(MutableBuffer buf, int flags, Time& ts, std::error_code& ec) noexcept
+    {
+        return recvTimestamped(*sock_, buf, flags, ts, ec);
+    }
+    std::size_t recv(MutableBuffer buf, int flags, Time& ts)
+    {
+        return recvTimestamped(*sock_, buf, flags, ts);
+    }
+
+    bool recvTxTimestamp(Time& ts, std::uint32_t& id, std::error_code& ec) noexcept
+    {
+        return swirly::recvTxTimestamp(*sock_, ts, id, ec);
+    }
+    bool recvTxTimestamp(Time& ts, std::uint32_t& id)
+    {
+        return swirly::recvTxTimestamp(*sock_, ts, id);
+    }
+
     ssize_t send(const void* buf, std::size_t len, int flags, std::error_code& ec) noexcept
     {
         return os::send(*sock_, buf, len, flags, ec);
@@ -0,0 +1,93 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "IoUring.hpp"
+
+#include <cstring>
+
+namespace swirly {
+inline namespace sys {
+using namespace std;
+namespace {
+
+template <typename ValueT>
+ValueT* offsetPtr(const MMap& map, unsigned offset) noexcept
+{
+    return reinterpret_cast<ValueT*>(static_cast<char*>(map.get().data()) + offset);
+}
+
+} // namespace
+
+IoUring::IoUring(unsigned entries)
+{
+    io_uring_params params{};
+    fh_ = os::io_uring_setup(entries, params);
+
+    const auto& sq = params.sq_off;
+    sqMap_ = os::mmap(nullptr, sq.array + params.sq_entries * sizeof(unsigned),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fh_.get(),
+                      IORING_OFF_SQ_RING);
+    sqHead_ = offsetPtr<unsigned>(sqMap_, sq.head);
+    sqTail_ = offsetPtr<unsigned>(sqMap_, sq.tail);
+    sqMask_ = *offsetPtr<unsigned>(sqMap_, sq.ring_mask);
+    sqEntries_ = *offsetPtr<unsigned>(sqMap_, sq.ring_entries);
+    sqArray_ = offsetPtr<unsigned>(sqMap_, sq.array);
+    tail_ = *sqTail_;
+
+    sqeMap_ = os::mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fh_.get(), IORING_OFF_SQES);
+    sqes_ = static_cast<io_uring_sqe*>(sqeMap_.get().data());
+
+    const auto& cq = params.cq_off;
+    cqMap_ = os::mmap(nullptr, cq.cqes + params.cq_entries * sizeof(io_uring_cqe),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fh_.get(),
+                      IORING_OFF_CQ_RING);
+    cqHead_ = offsetPtr<unsigned>(cqMap_, cq.head);
+    cqTail_ = offsetPtr<unsigned>(cqMap_, cq.tail);
+    cqMask_ = *offsetPtr<unsigned>(cqMap_, cq.ring_mask);
+    cqes_ = offsetPtr<io_uring_cqe>(cqMap_, cq.cqes);
+}
+
+IoUring::~IoUring() = default;
+
+io_uring_sqe& IoUring::sqe()
+{
+    if (tail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) == sqEntries_) {
+        // Make room without waiting.
+        __atomic_store_n(sqTail_, tail_, __ATOMIC_RELEASE);
+        pending_ -= os::io_uring_enter(fh_.get(), pending_, 0, 0);
+    }
+    const auto idx = tail_++ & sqMask_;
+    sqArray_[idx] = idx;
+    ++pending_;
+    auto& sqe = sqes_[idx];
+    memset(&sqe, 0, sizeof(sqe));
+    return sqe;
+}
+
+int IoUring::submit(unsigned minComplete, std::error_code& ec) noexcept
+{
+    __atomic_store_n(sqTail_, tail_, __ATOMIC_RELEASE);
+    const auto ret = os::io_uring_enter(fh_.get(), pending_, minComplete,
+                                        minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, ec);
+    if (ret > 0) {
+        pending_ -= ret;
+    }
+    return ret;
+}
+
+} // namespace sys
+} // namespace swirly
@@ -0,0 +1,154 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_IOURING_HPP
+#define SWIRLY_SYS_IOURING_HPP
+
+#include <swirly/sys/Error.hpp>
+#include <swirly/sys/Handle.hpp>
+#include <swirly/sys/MMap.hpp>
+
+#include <linux/io_uring.h>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace swirly {
+inline namespace sys {
+namespace os {
+
+inline FileHandle io_uring_setup(unsigned entries, io_uring_params& params,
+                                 std::error_code& ec) noexcept
+{
+    const auto ret = ::syscall(__NR_io_uring_setup, entries, &params);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+inline FileHandle io_uring_setup(unsigned entries, io_uring_params& params)
+{
+    const auto fd = ::syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        throw std::system_error{makeError(errno), "io_uring_setup"};
+    }
+    return fd;
+}
+
+inline int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+                          std::error_code& ec) noexcept
+{
+    const auto ret = ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+inline int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    const auto ret = ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0);
+    if (ret < 0) {
+        throw std::system_error{makeError(errno), "io_uring_enter"};
+    }
+    return ret;
+}
+
+} // namespace os
+
+/**
+ * Submission and completion queues shared with the kernel.
+ *
+ * Submission entries are prepared with sqe(), and passed to the kernel by the next call to
+ * submit(). The rings are not thread-safe.
+ */
+class SWIRLY_API IoUring {
+  public:
+    /**
+     * @throw std::system_error if the kernel does not support io_uring.
+     */
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+
+    // Copy.
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Move.
+    IoUring(IoUring&&) = delete;
+    IoUring& operator=(IoUring&&) = delete;
+
+    int fd() const noexcept { return fh_.get(); }
+    /**
+     * Returns true if there are completions waiting to be reaped.
+     */
+    bool ready() const noexcept
+    {
+        return *cqHead_ != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    }
+    /**
+     * Returns a zeroed submission entry, submitting pending entries first if the queue is full.
+     */
+    io_uring_sqe& sqe();
+    /**
+     * Submit pending entries, and wait for at least minComplete completions.
+     *
+     * @return the number of entries submitted, or -1 on error.
+     */
+    int submit(unsigned minComplete, std::error_code& ec) noexcept;
+    /**
+     * Invoke function with each available completion.
+     *
+     * @return the number of completions.
+     */
+    template <typename FnT>
+    int reap(FnT fn)
+    {
+        int n{0};
+        auto head = *cqHead_;
+        const auto tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            // Copy the entry, so that it can be released before the function is called.
+            const auto cqe = cqes_[head++ & cqMask_];
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            fn(cqe);
+            ++n;
+        }
+        return n;
+    }
+
+  private:
+    FileHandle fh_;
+    MMap sqMap_, cqMap_, sqeMap_;
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned* sqArray_;
+    io_uring_sqe* sqes_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+    // Local tail, and number of entries not yet passed to the kernel.
+    unsigned tail_{0}, pending_{0};
+};
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_IOURING_HPP
@@ -0,0 +1,363 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "IoUringReactor.hpp"
+
+#include <swirly/sys/EpollReactor.hpp>
+
+#include <swirly/util/Log.hpp>
+
+#include <poll.h>
+
+namespace swirly {
+inline namespace sys {
+using namespace std;
+namespace {
+
+constexpr size_t MaxEntries{4096};
+
+// User data of requests whose completions are ignored.
+constexpr uint64_t IgnoreToken{~0ULL};
+
+constexpr uint64_t token(int fd, unsigned gen) noexcept
+{
+    return static_cast<uint64_t>(gen) << 32 | static_cast<uint32_t>(fd);
+}
+
+unsigned pollEvents(unsigned events) noexcept
+{
+    unsigned n{};
+    if (events & EventIn) {
+        n |= POLLIN;
+    }
+    if (events & EventPri) {
+        n |= POLLPRI;
+    }
+    if (events & EventOut) {
+        n |= POLLOUT;
+    }
+    if (events & EventErr) {
+        n |= POLLERR;
+    }
+    if (events & EventHup) {
+        n |= POLLHUP;
+    }
+    return n;
+}
+
+unsigned fromPollEvents(unsigned events) noexcept
+{
+    unsigned n{};
+    if (events & POLLIN) {
+        n |= EventIn;
+    }
+    if (events & POLLPRI) {
+        n |= EventPri;
+    }
+    if (events & POLLOUT) {
+        n |= EventOut;
+    }
+    if (events & POLLERR) {
+        n |= EventErr;
+    }
+    if (events & POLLHUP) {
+        n |= EventHup;
+    }
+    return n;
+}
+
+/**
+ * Returns true if the kernel supports multi-shot poll requests, which were added in Linux 5.13.
+ * Earlier kernels fail the request with EINVAL.
+ */
+bool probeMultiShot(IoUring& ring)
+{
+    // An eventfd is always writable, so the request completes immediately.
+    EventFd efd{0, EFD_NONBLOCK};
+    auto& sqe = ring.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = efd.fd();
+    sqe.poll32_events = POLLOUT;
+    sqe.len = IORING_POLL_ADD_MULTI;
+    sqe.user_data = IgnoreToken;
+
+    error_code ec;
+    if (ring.submit(1, ec) < 0) {
+        throw system_error{ec, "io_uring_enter"};
+    }
+    bool multiShot{false};
+    ring.reap([&multiShot](const io_uring_cqe& cqe) {
+        if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_MORE)) {
+            multiShot = true;
+        }
+    });
+    if (multiShot) {
+        // Cancel the request before the eventfd is closed. Both completions are ignored.
+        auto& sqe = ring.sqe();
+        sqe.opcode = IORING_OP_POLL_REMOVE;
+        sqe.fd = -1;
+        sqe.addr = IgnoreToken;
+        sqe.user_data = IgnoreToken;
+        if (ring.submit(0, ec) < 0) {
+            throw system_error{ec, "io_uring_enter"};
+        }
+    }
+    return multiShot;
+}
+
+} // namespace
+
+IoUringReactor::IoUringReactor(size_t sizeHint)
+: ring_{static_cast<unsigned>(min(sizeHint, MaxEntries))}
+{
+    // Edge-triggered subscriptions cannot be emulated with one-shot requests, which would fire
+    // again on every cycle until the socket was drained.
+    if (!probeMultiShot(ring_)) {
+        throw system_error{os::makeError(EINVAL), "io_uring multi-shot poll not supported"};
+    }
+    const auto fd = efd_.fd();
+    data_.resize(max<size_t>(fd + 1, sizeHint));
+
+    auto& ref = data_[fd];
+    ref.sid = 0;
+    ref.events = EventIn;
+    ref.slot = {};
+    arm(fd, ref);
+}
+
+IoUringReactor::~IoUringReactor() = default;
+
+void IoUringReactor::doInterrupt() noexcept
+{
+    // Best effort.
+    std::error_code ec;
+    efd_.write(1, ec);
+}
+
+Reactor::Handle IoUringReactor::doSubscribe(int fd, unsigned events, IoSlot slot)
+{
+    assert(fd >= 0);
+    assert(slot);
+    if (fd >= static_cast<int>(data_.size())) {
+        data_.resize(fd + 1);
+    }
+    auto& ref = data_[fd];
+    disarm(fd, ref);
+    ++ref.sid;
+    ref.events = events;
+    ref.slot = slot;
+    arm(fd, ref);
+    return {*this, fd, ref.sid};
+}
+
+void IoUringReactor::doUnsubscribe(int fd, int sid) noexcept
+{
+    auto& ref = data_[fd];
+    if (ref.sid == sid) {
+        disarm(fd, ref);
+        ref.events = 0;
+        ref.slot.reset();
+    }
+}
+
+void IoUringReactor::doSetEvents(int fd, int sid, unsigned events, IoSlot slot)
+{
+    auto& ref = data_[fd];
+    if (ref.sid == sid) {
+        doSetEvents(fd, sid, events);
+        ref.slot = slot;
+    }
+}
+
+void IoUringReactor::doSetEvents(int fd, int sid, unsigned events)
+{
+    auto& ref = data_[fd];
+    if (ref.sid == sid && ref.events != events) {
+        ref.events = events;
+        // A one-shot request that has fired is re-armed with the new events after dispatch.
+        if (ref.armed) {
+            disarm(fd, ref);
+            arm(fd, ref);
+        }
+    }
+}
+
+Timer IoUringReactor::doTimer(Time expiry, Duration interval, Priority priority, TimerSlot slot)
+{
+    return tqs_[static_cast<size_t>(priority)].insert(expiry, interval, slot);
+}
+
+Timer IoUringReactor::doTimer(Time expiry, Priority priority, TimerSlot slot)
+{
+    return tqs_[static_cast<size_t>(priority)].insert(expiry, slot);
+}
+
+int IoUringReactor::doPoll(Time now, Millis timeout)
+{
+    enum { High = 0, Low = 1 };
+    using namespace chrono;
+
+    for (const auto& tq : tqs_) {
+        if (!tq.empty()) {
+            // Millis until next expiry.
+            const auto expiry = duration_cast<Millis>(tq.nextExpiry() - now);
+            if (expiry < timeout) {
+                timeout = max(expiry, 0ms);
+            }
+        }
+    }
+    unsigned minComplete{0};
+    if (timeout != 0ms && !ring_.ready()) {
+        minComplete = 1;
+        if (timeout != Millis::max()) {
+            // The timeout completes on expiry, or as soon as any other request completes.
+            ts_.tv_sec = timeout.count() / 1000;
+            ts_.tv_nsec = (timeout.count() % 1000) * 1000000;
+            auto& sqe = ring_.sqe();
+            sqe.opcode = IORING_OP_TIMEOUT;
+            sqe.fd = -1;
+            sqe.addr = reinterpret_cast<uintptr_t>(&ts_);
+            sqe.len = 1;
+            sqe.off = 1;
+            sqe.user_data = IgnoreToken;
+        }
+    }
+    error_code ec;
+    if (ring_.submit(minComplete, ec) < 0) {
+        // The completion queue may be full, in which case it must be drained before submitting.
+        if (ec.value() != EINTR && ec.value() != EBUSY && ec.value() != EAGAIN) {
+            throw system_error{ec};
+        }
+        if (ec.value() == EINTR) {
+            return 0;
+        }
+    }
+    now = UnixClock::now();
+    const auto n = tqs_[High].dispatch(now) + dispatch(now);
+    // Low priority timers are only dispatched during empty cycles.
+    return n == 0 ? tqs_[Low].dispatch(now) : n;
+}
+
+void IoUringReactor::arm(int fd, Data& ref)
+{
+    auto& sqe = ring_.sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd;
+    sqe.poll32_events = pollEvents(ref.events);
+    if (ref.events & EventEt) {
+        sqe.len = IORING_POLL_ADD_MULTI;
+    }
+    sqe.user_data = token(fd, ++ref.gen);
+    ref.armed = true;
+}
+
+void IoUringReactor::disarm(int fd, Data& ref) noexcept
+{
+    if (!ref.armed) {
+        return;
+    }
+    ref.armed = false;
+    try {
+        auto& sqe = ring_.sqe();
+        sqe.opcode = IORING_OP_POLL_REMOVE;
+        sqe.fd = -1;
+        sqe.addr = token(fd, ref.gen);
+        sqe.user_data = IgnoreToken;
+    } catch (const std::exception& e) {
+        // Any completion of the request will be discarded as stale.
+        SWIRLY_ERROR << "error cancelling poll request: "sv << e.what();
+    }
+}
+
+int IoUringReactor::dispatch(Time now)
+{
+    ++cycle_;
+    // All completions are reaped before any are dispatched, so that a multi-shot request that
+    // completes more than once in a batch is delivered as a single call with the union of events.
+    ready_.clear();
+    ring_.reap([this](const io_uring_cqe& cqe) {
+        if (cqe.user_data == IgnoreToken) {
+            return;
+        }
+        const auto fd = static_cast<int>(cqe.user_data & 0xffffffff);
+        auto& ref = data_[fd];
+        // Skip completions of requests that have since been cancelled or replaced.
+        if (!ref.armed || ref.gen != cqe.user_data >> 32) {
+            return;
+        }
+        ref.armed = (cqe.flags & IORING_CQE_F_MORE) != 0;
+        if (cqe.res > 0) {
+            ref.pending |= fromPollEvents(cqe.res);
+        } else if (cqe.res < 0 && cqe.res != -ECANCELED) {
+            SWIRLY_ERROR << "error polling fd "sv << fd << ": "sv
+                         << os::makeError(-cqe.res).message();
+            ref.failed = true;
+        }
+        if (ref.cycle != cycle_) {
+            ref.cycle = cycle_;
+            ready_.push_back({fd, ref.sid});
+        }
+    });
+    int n{0};
+    for (const auto [fd, sid] : ready_) {
+        // The handler may have subscribed other sockets, so the reference is re-evaluated.
+        auto* ref = &data_[fd];
+        const auto events = exchange(ref->pending, 0) & ref->events;
+        const auto failed = exchange(ref->failed, false);
+        // Skip subscriptions that were replaced by a handler earlier in the cycle.
+        if (ref->sid != sid) {
+            continue;
+        }
+        if (fd == efd_.fd()) {
+            if (events) {
+                SWIRLY_INFO << "reactor interrupted"sv;
+                efd_.read();
+            }
+        } else if (events) {
+            try {
+                ref->slot(fd, events, now);
+            } catch (const std::exception& e) {
+                SWIRLY_ERROR << "error handling io event: "sv << e.what();
+            }
+            ++n;
+            // The handler may have subscribed other sockets, or modified this one.
+            ref = &data_[fd];
+            if (ref->sid != sid) {
+                continue;
+            }
+        }
+        // After an error, the subscription is left disarmed, because the error would otherwise
+        // repeat.
+        if (!failed && !ref->armed && ref->events) {
+            arm(fd, *ref);
+        }
+    }
+    return n;
+}
+
+unique_ptr<Reactor> makeIoUringReactor(size_t sizeHint)
+{
+    try {
+        return make_unique<IoUringReactor>(sizeHint);
+    } catch (const system_error& e) {
+        // Includes kernels that predate multi-shot poll requests.
+        SWIRLY_WARNING << "io_uring not available, using epoll: "sv << e.what();
+    }
+    return make_unique<EpollReactor>(sizeHint);
+}
+
+} // namespace sys
+} // namespace swirly
@@ -0,0 +1,127 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_IOURINGREACTOR_HPP
+#define SWIRLY_SYS_IOURINGREACTOR_HPP
+
+#include "Reactor.hpp"
+
+#include <swirly/sys/Event.hpp>
+#include <swirly/sys/IoUring.hpp>
+#include <swirly/sys/TimerWheel.hpp>
+
+#include <memory>
+
+namespace swirly {
+inline namespace sys {
+
+/**
+ * Reactor implemented with io_uring poll requests.
+ *
+ * Poll requests are one-shot, and are re-armed after each event, which preserves the
+ * level-triggered semantics of EpollReactor. Edge-triggered subscriptions use multi-shot poll
+ * requests instead. Requests are queued in the submission ring, so re-arming a subscription, and
+ * changes to subscriptions made by handlers, are passed to the kernel by the same system call that
+ * waits for the next events.
+ */
+class SWIRLY_API IoUringReactor : public Reactor {
+  public:
+    /**
+     * @throw std::system_error if the kernel does not support io_uring, or multi-shot poll
+     * requests, which require Linux 5.13.
+     */
+    explicit IoUringReactor(std::size_t sizeHint = 1024);
+    ~IoUringReactor() override;
+
+    // Copy.
+    IoUringReactor(const IoUringReactor&) = delete;
+    IoUringReactor& operator=(const IoUringReactor&) = delete;
+
+    // Move.
+    IoUringReactor(IoUringReactor&&) = delete;
+    IoUringReactor& operator=(IoUringReactor&&) = delete;
+
+  protected:
+    /**
+     * Thread-safe.
+     */
+    void doInterrupt() noexcept override;
+
+    Handle doSubscribe(int fd, unsigned events, IoSlot slot) override;
+    void doUnsubscribe(int fd, int sid) noexcept override;
+
+    void doSetEvents(int fd, int sid, unsigned events, IoSlot slot) override;
+    void doSetEvents(int fd, int sid, unsigned events) override;
+
+    Timer doTimer(Time expiry, Duration interval, Priority priority, TimerSlot slot) override;
+    Timer doTimer(Time expiry, Priority priority, TimerSlot slot) override;
+
+    int doPoll(Time now, Millis timeout) override;
+
+  private:
+    struct Data {
+        int sid{};
+        unsigned events{};
+        IoSlot slot;
+        /**
+         * Generation of the latest poll request, which is used to discard stale completions.
+         */
+        unsigned gen{};
+        bool armed{false};
+        /**
+         * Last dispatch cycle in which the subscription was queued for dispatch.
+         */
+        int cycle{-1};
+        /**
+         * Events gathered from the completions reaped in the current cycle.
+         */
+        unsigned pending{};
+        /**
+         * True if a poll request failed in the current cycle.
+         */
+        bool failed{false};
+    };
+    struct Ready {
+        int fd;
+        int sid;
+    };
+    void arm(int fd, Data& ref);
+    void disarm(int fd, Data& ref) noexcept;
+    int dispatch(Time now);
+
+    IoUring ring_;
+    std::vector<Data> data_;
+    EventFd efd_{0, EFD_NONBLOCK};
+    // Must remain valid until the timeout request has been submitted.
+    __kernel_timespec ts_{};
+    int cycle_{0};
+    // Subscriptions with completions in the current cycle.
+    std::vector<Ready> ready_;
+    static_assert(static_cast<int>(Priority::High) == 0);
+    static_assert(static_cast<int>(Priority::Low) == 1);
+    std::array<TimerWheel, 2> tqs_;
+};
+
+/**
+ * Returns an IoUringReactor, or an EpollReactor if the kernel does not support io_uring or
+ * multi-shot poll requests.
+ */
+SWIRLY_API std::unique_ptr<Reactor> makeIoUringReactor(std::size_t sizeHint = 1024);
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_IOURINGREACTOR_HPP
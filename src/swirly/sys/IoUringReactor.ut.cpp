@@ -0,0 +1,196 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "IoUringReactor.hpp"
+#include "IoSocket.hpp"
+#include "LocalAddress.hpp"
+
+#include <swirly/util/RefCount.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+struct TestHandler : RefCount<TestHandler, ThreadUnsafePolicy> {
+    void onInput(int fd, unsigned events, Time now)
+    {
+        char buf[4];
+        os::recv(fd, buf, 4, 0);
+        if (strcmp(buf, "foo") == 0) {
+            ++matches;
+        }
+    }
+    int matches{};
+};
+
+struct EventsHandler : RefCount<EventsHandler, ThreadUnsafePolicy> {
+    void onEvents(int fd, unsigned events, Time now)
+    {
+        ++calls;
+        last = events;
+    }
+    int calls{};
+    unsigned last{};
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(IoUringReactorSuite)
+
+BOOST_AUTO_TEST_CASE(IoUringReactorLevelCase)
+{
+    using namespace literals::chrono_literals;
+
+    IoUringReactor r{1024};
+    auto h = makeIntrusive<TestHandler>();
+
+    auto socks = socketpair(LocalStream{});
+    const auto sub = r.subscribe(*socks.second, EventIn, bind<&TestHandler::onInput>(h.get()));
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 0);
+
+    socks.first.send("foo", 4, 0);
+    socks.first.send("foo", 4, 0);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 1);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 2);
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 2);
+
+    socks.first.send("foo", 4, 0);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 3);
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 3);
+}
+
+BOOST_AUTO_TEST_CASE(IoUringReactorEdgeCase)
+{
+    using namespace literals::chrono_literals;
+
+    IoUringReactor r{1024};
+    auto h = makeIntrusive<TestHandler>();
+
+    auto socks = socketpair(LocalStream{});
+    auto sub = r.subscribe(*socks.second, EventIn | EventEt, bind<&TestHandler::onInput>(h.get()));
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 0);
+
+    socks.first.send("foo", 4, 0);
+    socks.first.send("foo", 4, 0);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 1);
+
+    // No notification for second message.
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 1);
+
+    // Revert to level-triggered.
+    sub.setEvents(EventIn);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 2);
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 2);
+
+    socks.first.send("foo", 4, 0);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 3);
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 3);
+}
+
+BOOST_AUTO_TEST_CASE(IoUringReactorEdgeBatchCase)
+{
+    using namespace literals::chrono_literals;
+
+    IoUringReactor r{1024};
+    auto h = makeIntrusive<EventsHandler>();
+
+    auto socks = socketpair(LocalStream{});
+    const auto sub = r.subscribe(*socks.second, EventIn | EventOut | EventEt,
+                                 bind<&EventsHandler::onEvents>(h.get()));
+
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->calls == 1);
+    BOOST_TEST(h->last == EventOut);
+
+    socks.second.send("foo", 4, 0);
+    BOOST_TEST(r.poll(0ms) == 0);
+
+    // Receiving a message, and the peer draining the one sent, complete the multi-shot request
+    // once with EventIn and once with EventOut. The handler is called once with both.
+    socks.first.send("foo", 4, 0);
+    char buf[4];
+    socks.first.recv(buf, 4, 0);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->calls == 2);
+    BOOST_TEST(h->last == (EventIn | EventOut));
+
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->calls == 2);
+}
+
+BOOST_AUTO_TEST_CASE(IoUringReactorUnsubscribeCase)
+{
+    using namespace literals::chrono_literals;
+
+    IoUringReactor r{1024};
+    auto h = makeIntrusive<TestHandler>();
+
+    auto socks = socketpair(LocalStream{});
+    auto sub = r.subscribe(*socks.second, EventIn, bind<&TestHandler::onInput>(h.get()));
+
+    socks.first.send("foo", 4, 0);
+    sub.reset();
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(h->matches == 0);
+
+    // Subscribe again to the same descriptor.
+    sub = r.subscribe(*socks.second, EventIn, bind<&TestHandler::onInput>(h.get()));
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(h->matches == 1);
+}
+
+BOOST_AUTO_TEST_CASE(IoUringReactorTimerCase)
+{
+    using namespace literals::chrono_literals;
+
+    IoUringReactor r{1024};
+    int fired{0};
+    auto fn = [&fired](Timer& tmr, Time now) { ++fired; };
+
+    const auto start = UnixClock::now();
+    auto tmr = r.timer(start + 20ms, Priority::High, bind(&fn));
+    // Wait until the timer expires.
+    while (fired == 0) {
+        r.poll(1s);
+    }
+    const auto elapsed = UnixClock::now() - start;
+    BOOST_CHECK(elapsed >= 20ms);
+    BOOST_CHECK(elapsed < 1s);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "LocalAcceptor.hpp"
+
+#include <swirly/util/Log.hpp>
+
+#include <sys/un.h>
+
+namespace swirly {
+inline namespace sys {
+using namespace std;
+
+void unlinkStale(const LocalStreamEndpoint& ep)
+{
+    const auto path = ep.path();
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+        // Any other file is left for bind to reject.
+        return;
+    }
+    error_code ec;
+    LocalSocketClnt sock{LocalStream{}};
+    sock.connect(ep, ec);
+    if (!ec) {
+        throw system_error{os::makeError(EADDRINUSE), "another process is listening on " + path};
+    }
+    if (ec.value() == ECONNREFUSED) {
+        SWIRLY_NOTICE << "removing stale socket file "sv << path;
+        ::unlink(path.c_str());
+    }
+}
+
+void unlinkOwned(const LocalStreamEndpoint& ep, const struct stat& st) noexcept
+{
+    // The path is taken from the address, because path() allocates.
+    const auto* const path = reinterpret_cast<const sockaddr_un*>(ep.data())->sun_path;
+    struct stat cur;
+    if (::stat(path, &cur) == 0 && cur.st_dev == st.st_dev && cur.st_ino == st.st_ino) {
+        ::unlink(path);
+    }
+}
+
+} // namespace sys
+} // namespace swirly
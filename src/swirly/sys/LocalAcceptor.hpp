@@ -0,0 +1,100 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_LOCALACCEPTOR_HPP
+#define SWIRLY_SYS_LOCALACCEPTOR_HPP
+
+#include <swirly/sys/Event.hpp>
+#include <swirly/sys/LocalSocket.hpp>
+#include <swirly/sys/Reactor.hpp>
+
+#include <sys/stat.h>
+
+namespace swirly {
+inline namespace sys {
+
+/**
+ * Remove a socket file left at the endpoint's path by a process that has exited, which is detected
+ * by a refused connection.
+ *
+ * @throw std::system_error if another process is listening on the path.
+ */
+SWIRLY_API void unlinkStale(const LocalStreamEndpoint& ep);
+
+/**
+ * Remove the file at the endpoint's path, if it is still the one described by st, and has not
+ * since been replaced by another process.
+ */
+SWIRLY_API void unlinkOwned(const LocalStreamEndpoint& ep, const struct stat& st) noexcept;
+
+/**
+ * Acceptor for Unix domain stream sockets, which avoid the TCP/IP stack for clients on the same
+ * host.
+ */
+template <typename DerivedT>
+class LocalAcceptor {
+  public:
+    using Transport = LocalStream;
+    using Endpoint = LocalStreamEndpoint;
+
+    /**
+     * A socket file left at the endpoint's path by a previous process is replaced, but one that
+     * another process is listening on is not. The file is removed when the acceptor is destroyed.
+     *
+     * @throw std::system_error if the path is in use.
+     */
+    LocalAcceptor(Reactor& r, const Endpoint& ep)
+    : serv_{Transport{}}
+    , ep_{ep}
+    {
+        unlinkStale(ep_);
+        serv_.bind(ep_);
+        // Identify the file, so that a file bound by another process is not removed.
+        if (::stat(ep_.path().c_str(), &st_) != 0) {
+            throw std::system_error{os::makeError(errno), "stat"};
+        }
+        serv_.listen(SOMAXCONN);
+        sub_ = r.subscribe(*serv_, EventIn, bind<&LocalAcceptor::onInput>(this));
+    }
+
+    // Copy.
+    LocalAcceptor(const LocalAcceptor&) = delete;
+    LocalAcceptor& operator=(const LocalAcceptor&) = delete;
+
+    // Move.
+    LocalAcceptor(LocalAcceptor&&) = delete;
+    LocalAcceptor& operator=(LocalAcceptor&&) = delete;
+
+  protected:
+    ~LocalAcceptor() { unlinkOwned(ep_, st_); }
+
+  private:
+    void onInput(int fd, unsigned events, Time now)
+    {
+        // The peer is usually unnamed, so the session is identified by the listening endpoint.
+        static_cast<DerivedT*>(this)->doAccept(serv_.accept(), ep_, now);
+    }
+
+    LocalSocketServ serv_;
+    const Endpoint ep_;
+    struct stat st_{};
+    Reactor::Handle sub_;
+};
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_LOCALACCEPTOR_HPP
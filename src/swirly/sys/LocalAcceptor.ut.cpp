@@ -0,0 +1,142 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "LocalAcceptor.hpp"
+#include "EpollReactor.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+struct TestAcceptor : LocalAcceptor<TestAcceptor> {
+    using LocalAcceptor::LocalAcceptor;
+    void doAccept(IoSocket&& sock, const Endpoint& ep, Time now)
+    {
+        socks.push_back(move(sock));
+    }
+    vector<IoSocket> socks;
+};
+
+bool exists(const char* path) noexcept
+{
+    struct stat st;
+    return ::stat(path, &st) == 0;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LocalAcceptorSuite)
+
+BOOST_AUTO_TEST_CASE(LocalAcceptorAcceptCase)
+{
+    using namespace literals::chrono_literals;
+
+    constexpr auto Path = "LocalAcceptorAcceptCase.sock";
+    const LocalStreamEndpoint ep{Path};
+    {
+        EpollReactor r{1024};
+        TestAcceptor acceptor{r, ep};
+        BOOST_TEST(exists(Path));
+
+        LocalSocketClnt clnt{LocalStream{}};
+        clnt.connect(ep);
+        BOOST_TEST(r.poll(0ms) == 1);
+        BOOST_TEST(acceptor.socks.size() == 1U);
+
+        acceptor.socks.front().send("foo", 4, 0);
+        char buf[4];
+        BOOST_TEST(clnt.recv(buf, 4, 0) == 4U);
+        BOOST_TEST(strcmp(buf, "foo") == 0);
+    }
+    // The socket file is removed by the acceptor.
+    BOOST_TEST(!exists(Path));
+}
+
+BOOST_AUTO_TEST_CASE(LocalAcceptorStaleCase)
+{
+    using namespace literals::chrono_literals;
+
+    constexpr auto Path = "LocalAcceptorStaleCase.sock";
+    const LocalStreamEndpoint ep{Path};
+    {
+        // Leave a socket file that nothing is listening on.
+        LocalSocketServ serv{LocalStream{}};
+        serv.bind(ep);
+    }
+    BOOST_TEST(exists(Path));
+    {
+        EpollReactor r{1024};
+        TestAcceptor acceptor{r, ep};
+
+        LocalSocketClnt clnt{LocalStream{}};
+        clnt.connect(ep);
+        BOOST_TEST(r.poll(0ms) == 1);
+        BOOST_TEST(acceptor.socks.size() == 1U);
+    }
+    BOOST_TEST(!exists(Path));
+}
+
+BOOST_AUTO_TEST_CASE(LocalAcceptorInUseCase)
+{
+    using namespace literals::chrono_literals;
+
+    constexpr auto Path = "LocalAcceptorInUseCase.sock";
+    const LocalStreamEndpoint ep{Path};
+    {
+        EpollReactor r{1024};
+        TestAcceptor acceptor{r, ep};
+
+        // The path of a live acceptor is not replaced.
+        BOOST_CHECK_THROW(TestAcceptor(r, ep), system_error);
+        BOOST_TEST(exists(Path));
+
+        // The probe connection made by the failed acceptor is also accepted.
+        BOOST_TEST(r.poll(0ms) == 1);
+        acceptor.socks.clear();
+
+        LocalSocketClnt clnt{LocalStream{}};
+        clnt.connect(ep);
+        BOOST_TEST(r.poll(0ms) == 1);
+        BOOST_TEST(acceptor.socks.size() == 1U);
+    }
+    BOOST_TEST(!exists(Path));
+}
+
+BOOST_AUTO_TEST_CASE(LocalAcceptorReboundCase)
+{
+    constexpr auto Path = "LocalAcceptorReboundCase.sock";
+    const LocalStreamEndpoint ep{Path};
+    LocalSocketServ serv;
+    {
+        EpollReactor r{1024};
+        TestAcceptor acceptor{r, ep};
+
+        // Another process removes the file and binds its own socket to the path.
+        ::unlink(Path);
+        serv = LocalSocketServ{LocalStream{}};
+        serv.bind(ep);
+    }
+    // The file that the acceptor did not create is left in place.
+    BOOST_TEST(exists(Path));
+    ::unlink(Path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
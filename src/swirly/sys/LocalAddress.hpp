@@ -29,6 +29,12 @@ inline namespace sys {
 using LocalDgram = boost::asio::local::datagram_protocol;
 using LocalStream = boost::asio::local::stream_protocol;
 
+template <typename TransportT>
+using LocalEndpoint = boost::asio::local::basic_endpoint<TransportT>;
+
+using LocalDgramEndpoint = LocalEndpoint<LocalDgram>;
+using LocalStreamEndpoint = LocalEndpoint<LocalStream>;
+
 } // namespace sys
 } // namespace swirly
 
@@ -0,0 +1,90 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_LOCALSOCKET_HPP
+#define SWIRLY_SYS_LOCALSOCKET_HPP
+
+#include <swirly/sys/IoSocket.hpp>
+#include <swirly/sys/LocalAddress.hpp>
+
+namespace swirly {
+inline namespace sys {
+
+/**
+ * Passive Unix domain stream Server Socket. All state is in base class, so object can be sliced.
+ */
+struct LocalSocketServ : Socket {
+    using Transport = LocalStream;
+    using Endpoint = LocalStreamEndpoint;
+
+    using Socket::Socket;
+
+    LocalSocketServ(Transport trans, std::error_code& ec) noexcept
+    : Socket{os::socket(trans, ec), trans.family()}
+    {
+    }
+    explicit LocalSocketServ(Transport trans)
+    : Socket{os::socket(trans), trans.family()}
+    {
+    }
+    LocalSocketServ() noexcept = default;
+
+    void bind(const Endpoint& ep, std::error_code& ec) noexcept { os::bind(*sock_, ep, ec); }
+    void bind(const Endpoint& ep) { os::bind(*sock_, ep); }
+
+    void listen(int backlog, std::error_code& ec) noexcept { os::listen(*sock_, backlog, ec); }
+    void listen(int backlog) { os::listen(*sock_, backlog); }
+
+    /**
+     * The peer is usually unnamed, so its address is not returned.
+     */
+    IoSocket accept(std::error_code& ec) noexcept
+    {
+        return IoSocket{os::accept(*sock_, ec), family_};
+    }
+    IoSocket accept() { return IoSocket{os::accept(*sock_), family_}; }
+};
+
+/**
+ * Active Unix domain stream Client Socket. All state is in base class, so object can be sliced.
+ */
+struct LocalSocketClnt : IoSocket {
+    using Transport = LocalStream;
+    using Endpoint = LocalStreamEndpoint;
+
+    using IoSocket::IoSocket;
+
+    LocalSocketClnt(Transport trans, std::error_code& ec) noexcept
+    : IoSocket{os::socket(trans, ec), trans.family()}
+    {
+    }
+    explicit LocalSocketClnt(Transport trans)
+    : IoSocket{os::socket(trans), trans.family()}
+    {
+    }
+    LocalSocketClnt() noexcept = default;
+
+    void connect(const Endpoint& ep, std::error_code& ec) noexcept
+    {
+        return os::connect(*sock_, ep, ec);
+    }
+    void connect(const Endpoint& ep) { return os::connect(*sock_, ep); }
+};
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_LOCALSOCKET_HPP
@@ -0,0 +1,55 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MirrorBuffer.hpp"
+
+#include <swirly/sys/File.hpp>
+#include <swirly/sys/Memory.hpp>
+
+#include <stdexcept>
+
+namespace swirly {
+inline namespace sys {
+
+MirrorBuffer::MirrorBuffer(std::size_t capacity)
+: capacity_{ceilPage(std::max<std::size_t>(capacity, 1))}
+{
+    const auto fh = os::memfd_create("swirly-mirror", MFD_CLOEXEC);
+    os::ftruncate(fh.get(), capacity_);
+
+    // Reserve address space for both mappings, and then replace each half with a shared mapping of
+    // the file. The reservation owns the whole range, so a single munmap releases both.
+    auto mirror = os::mmap(nullptr, 2 * capacity_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    auto* const addr = static_cast<char*>(mirror.get().data());
+    for (auto* const half : {addr, addr + capacity_}) {
+        os::mmap(half, capacity_, PROT_READ | PROT_WRITE, MAP_FIXED | MAP_SHARED, fh.get(), 0)
+            .release();
+    }
+    mirror_ = std::move(mirror);
+}
+
+MirrorBuffer::~MirrorBuffer() = default;
+
+MutableBuffer MirrorBuffer::prepare(std::size_t size)
+{
+    if (size > available()) {
+        throw std::length_error{"mirror buffer capacity exceeded"};
+    }
+    return {wptr(), size};
+}
+
+} // namespace sys
+} // namespace swirly
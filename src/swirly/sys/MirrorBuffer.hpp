@@ -0,0 +1,121 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_MIRRORBUFFER_HPP
+#define SWIRLY_SYS_MIRRORBUFFER_HPP
+
+#include <swirly/sys/Buffer.hpp>
+#include <swirly/sys/MMap.hpp>
+
+namespace swirly {
+inline namespace sys {
+
+/**
+ * Fixed-capacity buffer backed by a ring of pages that is mapped twice into adjacent regions of
+ * virtual memory. Data that wraps around the end of the ring is therefore contiguous in the second
+ * mapping, so the read and write sequences are always contiguous, and unlike Buffer there is never
+ * any need to move or reallocate the data.
+ */
+class SWIRLY_API MirrorBuffer {
+  public:
+    /**
+     * @param capacity Capacity in bytes, which is rounded up to a whole number of pages.
+     */
+    explicit MirrorBuffer(std::size_t capacity);
+    ~MirrorBuffer();
+
+    // Copy.
+    MirrorBuffer(const MirrorBuffer& rhs) = delete;
+    MirrorBuffer& operator=(const MirrorBuffer& rhs) = delete;
+
+    // Move.
+    MirrorBuffer(MirrorBuffer&& rhs) noexcept = default;
+    MirrorBuffer& operator=(MirrorBuffer&& rhs) noexcept = default;
+
+    /**
+     * Returns read buffer for available data.
+     */
+    ConstBuffer data() const noexcept { return {rptr(), size()}; }
+    /**
+     * Returns read buffer for available data with upper bound.
+     */
+    ConstBuffer data(std::size_t limit) const noexcept { return {rptr(), std::min(limit, size())}; }
+
+    /**
+     * Returns true if read buffer is empty.
+     */
+    bool empty() const noexcept { return size() == 0U; };
+
+    /**
+     * Returns number of bytes available for read.
+     */
+    std::size_t size() const noexcept { return wpos_ - rpos_; }
+
+    /**
+     * Returns the capacity in bytes.
+     */
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * Returns the number of bytes available for write.
+     */
+    std::size_t available() const noexcept { return capacity_ - size(); }
+
+    /**
+     * Clear buffer.
+     */
+    void clear() noexcept { rpos_ = wpos_ = 0; }
+
+    /**
+     * Move characters from the write sequence to the read sequence.
+     */
+    void commit(std::size_t count) noexcept { wpos_ += count; }
+
+    /**
+     * Remove characters from the read sequence.
+     */
+    void consume(std::size_t count) noexcept
+    {
+        rpos_ += count;
+        if (rpos_ >= capacity_) {
+            // Keep the read position within the first mapping.
+            rpos_ -= capacity_;
+            wpos_ -= capacity_;
+        }
+    }
+
+    /**
+     * Returns write buffer of specified size.
+     *
+     * @throw std::length_error if size exceeds the space available.
+     */
+    MutableBuffer prepare(std::size_t size);
+
+  private:
+    const char* rptr() const noexcept { return base() + rpos_; }
+    char* wptr() const noexcept { return base() + wpos_; }
+    char* base() const noexcept { return static_cast<char*>(mirror_.get().data()); }
+
+    std::size_t capacity_;
+    // Two adjacent mappings of the same pages.
+    MMap mirror_;
+    std::size_t rpos_{}, wpos_{};
+};
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_MIRRORBUFFER_HPP
@@ -0,0 +1,87 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MirrorBuffer.hpp"
+
+#include <swirly/sys/Memory.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+void write(MirrorBuffer& buf, const char* data)
+{
+    const auto len = strlen(data);
+    const auto out = buf.prepare(len);
+    memcpy(buffer_cast<char*>(out), data, len);
+    buf.commit(len);
+}
+
+string read(MirrorBuffer& buf, std::size_t limit)
+{
+    const auto in = buf.data(limit);
+    const string s{buffer_cast<const char*>(in), buffer_size(in)};
+    buf.consume(buffer_size(in));
+    return s;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MirrorBufferSuite)
+
+BOOST_AUTO_TEST_CASE(MirrorBufferReadWriteCase)
+{
+    MirrorBuffer buf{1};
+    BOOST_TEST(buf.capacity() == PageSize);
+    BOOST_TEST(buf.empty());
+    BOOST_TEST(buf.available() == PageSize);
+
+    write(buf, "foo");
+    write(buf, "bar");
+    BOOST_TEST(buf.size() == 6U);
+    BOOST_TEST(read(buf, 4) == "foob");
+    BOOST_TEST(buf.size() == 2U);
+    BOOST_TEST(read(buf, 100) == "ar");
+    BOOST_TEST(buf.empty());
+
+    BOOST_CHECK_THROW(buf.prepare(PageSize + 1), length_error);
+}
+
+BOOST_AUTO_TEST_CASE(MirrorBufferWrapCase)
+{
+    MirrorBuffer buf{PageSize};
+
+    // Advance the read and write positions to just before the end of the ring.
+    buf.commit(PageSize - 2);
+    buf.consume(PageSize - 2);
+    BOOST_TEST(buf.empty());
+
+    // Wrapped data is contiguous.
+    write(buf, "foobar");
+    BOOST_TEST(read(buf, 6) == "foobar");
+    BOOST_TEST(buf.empty());
+
+    // Fill to capacity across the boundary.
+    const string data(PageSize, 'x');
+    write(buf, data.c_str());
+    BOOST_TEST(buf.available() == 0U);
+    BOOST_TEST(read(buf, PageSize) == data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
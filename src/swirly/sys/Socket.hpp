@@ -19,6 +19,9 @@
 
 #include <swirly/sys/File.hpp>
 #include <swirly/sys/IpAddress.hpp>
+#include <swirly/sys/LocalAddress.hpp>
+
+#include <linux/net_tstamp.h>
 
 #include <sys/socket.h>
 
@@ -257,6 +260,24 @@ inline void bind(int sockfd, const BasicEndpoint<TransportT>& ep)
     bind(sockfd, *ep.data(), ep.size());
 }
 
+/**
+ * Bind a name to a socket.
+ */
+template <typename TransportT>
+inline void bind(int sockfd, const LocalEndpoint<TransportT>& ep, std::error_code& ec) noexcept
+{
+    bind(sockfd, *ep.data(), ep.size(), ec);
+}
+
+/**
+ * Bind a name to a socket.
+ */
+template <typename TransportT>
+inline void bind(int sockfd, const LocalEndpoint<TransportT>& ep)
+{
+    bind(sockfd, *ep.data(), ep.size());
+}
+
 /**
  * Initiate a connection on a socket.
  */
@@ -296,6 +317,24 @@ inline void connect(int sockfd, const BasicEndpoint<TransportT>& ep)
     connect(sockfd, *ep.data(), ep.size());
 }
 
+/**
+ * Initiate a connection on a socket.
+ */
+template <typename TransportT>
+inline void connect(int sockfd, const LocalEndpoint<TransportT>& ep, std::error_code& ec) noexcept
+{
+    connect(sockfd, *ep.data(), ep.size(), ec);
+}
+
+/**
+ * Initiate a connection on a socket.
+ */
+template <typename TransportT>
+inline void connect(int sockfd, const LocalEndpoint<TransportT>& ep)
+{
+    connect(sockfd, *ep.data(), ep.size());
+}
+
 /**
  * Listen for connections on a socket.
  */
@@ -527,7 +566,7 @@ template <typename TransportT>
 inline ssize_t sendto(int sockfd, const void* buf, std::size_t len, int flags,
                       const BasicEndpoint<TransportT>& ep, std::error_code& ec) noexcept
 {
-    return sendto(sockfd, buf, len, flags, *ep.data(), ep.size());
+    return sendto(sockfd, buf, len, flags, *ep.data(), ep.size(), ec);
 }
 
 /**
@@ -562,6 +601,81 @@ inline std::size_t sendto(int sockfd, ConstBuffer buf, int flags,
                   ep.size());
 }
 
+/**
+ * Receive a message from a socket.
+ */
+inline ssize_t recvmsg(int sockfd, msghdr& msg, int flags, std::error_code& ec) noexcept
+{
+    const auto ret = ::recvmsg(sockfd, &msg, flags);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+/**
+ * Receive a message from a socket.
+ */
+inline std::size_t recvmsg(int sockfd, msghdr& msg, int flags)
+{
+    const auto ret = ::recvmsg(sockfd, &msg, flags);
+    if (ret < 0) {
+        throw std::system_error{makeError(errno), "recvmsg"};
+    }
+    return ret;
+}
+
+/**
+ * Receive multiple messages from a socket.
+ */
+inline int recvmmsg(int sockfd, mmsghdr* msgvec, unsigned vlen, int flags, timespec* timeout,
+                    std::error_code& ec) noexcept
+{
+    const auto ret = ::recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+/**
+ * Receive multiple messages from a socket.
+ */
+inline std::size_t recvmmsg(int sockfd, mmsghdr* msgvec, unsigned vlen, int flags,
+                            timespec* timeout)
+{
+    const auto ret = ::recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+    if (ret < 0) {
+        throw std::system_error{makeError(errno), "recvmmsg"};
+    }
+    return ret;
+}
+
+/**
+ * Send multiple messages on a socket.
+ */
+inline int sendmmsg(int sockfd, mmsghdr* msgvec, unsigned vlen, int flags,
+                    std::error_code& ec) noexcept
+{
+    const auto ret = ::sendmmsg(sockfd, msgvec, vlen, flags);
+    if (ret < 0) {
+        ec = makeError(errno);
+    }
+    return ret;
+}
+
+/**
+ * Send multiple messages on a socket.
+ */
+inline std::size_t sendmmsg(int sockfd, mmsghdr* msgvec, unsigned vlen, int flags)
+{
+    const auto ret = ::sendmmsg(sockfd, msgvec, vlen, flags);
+    if (ret < 0) {
+        throw std::system_error{makeError(errno), "sendmmsg"};
+    }
+    return ret;
+}
+
 /**
  * Get the socket name.
  */
@@ -695,6 +809,18 @@ inline void setSoReuseAddr(int sockfd, bool enabled)
     os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
 }
 
+inline void setSoReusePort(int sockfd, bool enabled, std::error_code& ec) noexcept
+{
+    int optval{enabled ? 1 : 0};
+    os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval), ec);
+}
+
+inline void setSoReusePort(int sockfd, bool enabled)
+{
+    int optval{enabled ? 1 : 0};
+    os::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+}
+
 inline void setSoRcvBuf(int sockfd, int size, std::error_code& ec) noexcept
 {
     os::setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size), ec);
@@ -715,6 +841,24 @@ inline void setSoSndBuf(int sockfd, int size)
     os::setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
 }
 
+/**
+ * Enable the kernel timestamps specified by the SOF_TIMESTAMPING flags, or disable them if the flags
+ * are zero.
+ */
+inline void setSoTimestamping(int sockfd, unsigned flags, std::error_code& ec) noexcept
+{
+    os::setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags), ec);
+}
+
+/**
+ * Enable the kernel timestamps specified by the SOF_TIMESTAMPING flags, or disable them if the flags
+ * are zero.
+ */
+inline void setSoTimestamping(int sockfd, unsigned flags)
+{
+    os::setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+}
+
 inline void setTcpNoDelay(int sockfd, bool enabled, std::error_code& ec) noexcept
 {
     int optval{enabled ? 1 : 0};
@@ -761,12 +905,24 @@ struct Socket {
     }
     void setSoReuseAddr(bool enabled) { swirly::setSoReuseAddr(*sock_, enabled); }
 
+    void setSoReusePort(bool enabled, std::error_code& ec) noexcept
+    {
+        swirly::setSoReusePort(*sock_, enabled, ec);
+    }
+    void setSoReusePort(bool enabled) { swirly::setSoReusePort(*sock_, enabled); }
+
     void setSoSndBuf(int size, std::error_code& ec) noexcept
     {
         swirly::setSoSndBuf(*sock_, size, ec);
     }
     void setSoSndBuf(int size) { swirly::setSoSndBuf(*sock_, size); }
 
+    void setSoTimestamping(unsigned flags, std::error_code& ec) noexcept
+    {
+        swirly::setSoTimestamping(*sock_, flags, ec);
+    }
+    void setSoTimestamping(unsigned flags) { swirly::setSoTimestamping(*sock_, flags); }
+
     void setTcpNoDelay(bool enabled, std::error_code& ec) noexcept
     {
         swirly::setTcpNoDelay(*sock_, enabled, ec);
@@ -17,6 +17,7 @@
 #include "IoSocket.hpp"
 #include "LocalAddress.hpp"
 #include "Reactor.hpp"
+#include "UdpSocket.hpp"
 
 #include <boost/test/unit_test.hpp>
 
@@ -35,4 +36,71 @@ BOOST_AUTO_TEST_CASE(SocketPairCase)
     BOOST_TEST(strcmp(buf, "foo") == 0);
 }
 
+BOOST_AUTO_TEST_CASE(SocketLocalStreamCase)
+{
+    const LocalStreamEndpoint ep{"SocketLocalStreamCase.sock"};
+    unlink(ep.path().c_str());
+
+    Socket serv{os::socket(LocalStream{}), AF_UNIX};
+    os::bind(*serv, ep);
+    os::listen(*serv, SOMAXCONN);
+
+    IoSocket clnt{os::socket(LocalStream{}), AF_UNIX};
+    os::connect(*clnt, ep);
+    IoSocket sock{os::accept(*serv), AF_UNIX};
+    unlink(ep.path().c_str());
+
+    clnt.send("foo", 4, 0);
+    char buf[4];
+    sock.recv(buf, 4, 0);
+    BOOST_TEST(strcmp(buf, "foo") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(SocketTimestampingCase)
+{
+    UdpSocket rsock{Udp::v4()};
+    rsock.bind(UdpEndpoint{IpAddress::from_string("127.0.0.1"), 0});
+    rsock.setSoTimestamping(SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE);
+    UdpEndpoint ep;
+    rsock.getSockName(ep);
+    {
+        // The kernel enables receive timestamps asynchronously, so the first datagrams may not
+        // carry one.
+        UdpSocket wsock{Udp::v4()};
+        wsock.connect(ep);
+        char buf[4];
+        Time ts{};
+        for (int i{0}; i < 1000 && isZero(ts); ++i) {
+            wsock.send("foo", 4, 0);
+            rsock.recv({buf, sizeof(buf)}, 0, ts);
+        }
+    }
+
+    UdpSocket ssock{Udp::v4()};
+    ssock.setSoTimestamping(SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE
+                            | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY);
+    ssock.connect(ep);
+
+    const auto start = UnixClock::now();
+    ssock.send("foo", 4, 0);
+    ssock.send("bar", 4, 0);
+
+    char buf[4];
+    Time ts;
+    BOOST_TEST(rsock.recv({buf, sizeof(buf)}, 0, ts) == 4U);
+    BOOST_TEST(strcmp(buf, "foo") == 0);
+    BOOST_TEST(!isZero(ts));
+    BOOST_TEST(ts >= start);
+    BOOST_TEST(ts <= UnixClock::now());
+
+    // Datagrams are numbered from zero.
+    uint32_t id;
+    BOOST_TEST(ssock.recvTxTimestamp(ts, id));
+    BOOST_TEST(ts >= start);
+    BOOST_TEST(id == 0U);
+    BOOST_TEST(ssock.recvTxTimestamp(ts, id));
+    BOOST_TEST(id == 1U);
+    BOOST_TEST(!ssock.recvTxTimestamp(ts, id));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
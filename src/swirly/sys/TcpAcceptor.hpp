@@ -30,10 +30,17 @@ class TcpAcceptor {
     using Transport = Tcp;
     using Endpoint = TcpEndpoint;
 
-    TcpAcceptor(Reactor& r, const Endpoint& ep)
+    /**
+     * @param reusePort If true, several acceptors, typically on different threads, may listen on
+     * the same port, and the kernel will balance incoming connections between them.
+     */
+    TcpAcceptor(Reactor& r, const Endpoint& ep, bool reusePort = false)
     : serv_{ep.protocol()}
     {
         serv_.setSoReuseAddr(true);
+        if (reusePort) {
+            serv_.setSoReusePort(true);
+        }
         serv_.bind(ep);
         serv_.listen(SOMAXCONN);
         sub_ = r.subscribe(*serv_, EventIn, bind<&TcpAcceptor::onInput>(this));
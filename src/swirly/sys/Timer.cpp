@@ -41,7 +41,10 @@ Timer TimerQueue::insert(Time expiry, Duration interval, TimerSlot slot)
 {
     assert(slot);
 
-    heap_.reserve(heap_.size() + 1);
+    // Grow geometrically, because reserve() may allocate exactly the requested capacity.
+    if (heap_.size() == heap_.capacity()) {
+        heap_.reserve(max<size_t>(heap_.size() * 2, 64));
+    }
     const auto tmr = alloc(expiry, interval, slot);
 
     // Cannot fail.
@@ -72,7 +75,7 @@ int TimerQueue::dispatch(Time now)
     return n;
 }
 
-Timer TimerQueue::alloc(Time expiry, Duration interval, TimerSlot slot)
+Timer TimerPool::alloc(Time expiry, Duration interval, TimerSlot slot)
 {
     Timer::Impl* impl;
 
@@ -95,7 +98,9 @@ Timer TimerQueue::alloc(Time expiry, Duration interval, TimerSlot slot)
         slabs_.push_back(move(slab));
     }
 
-    impl->tq = this;
+    impl->next = nullptr;
+    impl->pprev = nullptr;
+    impl->pool = this;
     impl->refCount = 1;
     impl->id = ++maxId_;
     impl->expiry = expiry;
@@ -105,7 +110,7 @@ Timer TimerQueue::alloc(Time expiry, Duration interval, TimerSlot slot)
     return Timer{impl};
 }
 
-void TimerQueue::cancel() noexcept
+void TimerQueue::cancel(Timer::Impl* impl) noexcept
 {
     ++cancelled_;
 
@@ -183,12 +188,12 @@ void intrusive_ptr_release(Timer::Impl* impl) noexcept
         // outside of the timer queue.
         if (impl->slot) {
             impl->slot.reset();
-            impl->tq->cancel();
+            impl->pool->cancel(impl);
         }
     } else if (impl->refCount == 0) {
-        auto& tq = *impl->tq;
-        impl->next = tq.free_;
-        tq.free_ = impl;
+        auto& pool = *impl->pool;
+        impl->next = pool.free_;
+        pool.free_ = impl;
     }
 }
 
@@ -31,24 +31,28 @@ namespace swirly {
 inline namespace sys {
 
 class Timer;
+class TimerPool;
 class TimerQueue;
+class TimerWheel;
 using TimerSlot = BasicSlot<Timer&, Time>;
 
 class SWIRLY_API Timer {
 
     struct Impl {
-        union {
-            // Singly-linked free-list.
-            Impl* next;
-            TimerQueue* tq;
-        };
+        // Singly-linked free-list, or list of timers sharing a wheel slot.
+        Impl* next;
+        // Address of the link that points to this timer in a wheel slot, or null if unlinked.
+        Impl** pprev;
+        TimerPool* pool;
         int refCount;
         long id;
         Time expiry;
         Duration interval;
         TimerSlot slot;
     };
+    friend class TimerPool;
     friend class TimerQueue;
+    friend class TimerWheel;
     friend void intrusive_ptr_add_ref(Impl* impl) noexcept;
     friend void intrusive_ptr_release(Impl* impl) noexcept;
 
@@ -142,15 +146,50 @@ inline bool operator>=(const Timer& lhs, const Timer& rhs) noexcept
     return lhs.id() >= rhs.id();
 }
 
-class SWIRLY_API TimerQueue {
+/**
+ * Slab allocator for timers, which is shared by the queue implementations.
+ */
+class SWIRLY_API TimerPool {
     friend class Timer;
     friend void intrusive_ptr_add_ref(Timer::Impl*) noexcept;
     friend void intrusive_ptr_release(Timer::Impl*) noexcept;
 
     using SlabPtr = std::unique_ptr<Timer::Impl[]>;
 
+  public:
+    TimerPool() = default;
+
+    // Copy.
+    TimerPool(const TimerPool&) = delete;
+    TimerPool& operator=(const TimerPool&) = delete;
+
+    // Move.
+    TimerPool(TimerPool&&) = delete;
+    TimerPool& operator=(TimerPool&&) = delete;
+
+  protected:
+    ~TimerPool() = default;
+
+    Timer alloc(Time expiry, Duration interval, TimerSlot slot);
+    /**
+     * Called when a pending timer is cancelled.
+     */
+    virtual void cancel(Timer::Impl* impl) noexcept = 0;
+
+  private:
+    long maxId_{};
+    std::vector<SlabPtr> slabs_;
+    // Head of free-list.
+    Timer::Impl* free_{nullptr};
+};
+
+/**
+ * Binary heap of timers ordered by expiry time. Cancelled timers are removed lazily.
+ */
+class SWIRLY_API TimerQueue : public TimerPool {
   public:
     TimerQueue() = default;
+    ~TimerQueue() = default;
 
     // Copy.
     TimerQueue(const TimerQueue&) = delete;
@@ -175,17 +214,12 @@ class SWIRLY_API TimerQueue {
     int dispatch(Time now);
 
   private:
-    Timer alloc(Time expiry, Duration interval, TimerSlot slot);
-    void cancel() noexcept;
+    void cancel(Timer::Impl* impl) noexcept override;
     void expire(Time now);
     void gc() noexcept;
     Timer pop() noexcept;
 
-    long maxId_{};
     int cancelled_{};
-    std::vector<SlabPtr> slabs_;
-    // Head of free-list.
-    Timer::Impl* free_{nullptr};
     // Heap of timers ordered by expiry time.
     std::vector<Timer> heap_;
 };
@@ -202,7 +236,7 @@ inline void Timer::cancel() noexcept
     // If pending, then reset the slot and inform the queue that the timer has been cancelled.
     if (impl_->slot) {
         impl_->slot.reset();
-        impl_->tq->cancel();
+        impl_->pool->cancel(impl_.get());
     }
 }
 } // namespace sys
@@ -0,0 +1,261 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "TimerWheel.hpp"
+
+#include <swirly/util/Log.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace swirly {
+inline namespace sys {
+using namespace std;
+namespace {
+
+constexpr int64_t MaxTick{numeric_limits<int64_t>::max()};
+// Number of ticks spanned by the top level.
+constexpr int64_t Horizon{int64_t{1} << (TimerWheel::LevelBits * TimerWheel::Levels)};
+constexpr int64_t SlotMask{TimerWheel::LevelSize - 1};
+
+// Expiry times are rounded up, so that timers never fire early.
+int64_t ceilTick(Time t) noexcept
+{
+    const auto ns = chrono::duration_cast<Nanos>(t.time_since_epoch()).count();
+    return ns / 1000000 + (ns % 1000000 > 0 ? 1 : 0);
+}
+
+int64_t floorTick(Time t) noexcept
+{
+    return chrono::duration_cast<Millis>(t.time_since_epoch()).count();
+}
+
+uint64_t rotr(uint64_t x, int n) noexcept
+{
+    return (x >> n) | (x << ((64 - n) & 63));
+}
+
+} // namespace
+
+TimerWheel::TimerWheel(Time now) noexcept
+: now_{floorTick(now)}
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    // Release the references held by the wheel before the slabs are freed.
+    const auto drain = [this](Timer::Impl*& head) {
+        while (head) {
+            auto* const impl = head;
+            unlink(impl);
+            impl->slot.reset();
+            intrusive_ptr_release(impl);
+        }
+    };
+    for (auto& level : slots_) {
+        for (auto& head : level) {
+            drain(head);
+        }
+    }
+    drain(due_);
+}
+
+Time TimerWheel::nextExpiry() const noexcept
+{
+    return Time{Millis{nextTick()}};
+}
+
+Timer TimerWheel::insert(Time expiry, Duration interval, TimerSlot slot)
+{
+    assert(slot);
+
+    auto tmr = alloc(expiry, interval, slot);
+    auto* const impl = tmr.impl_.get();
+
+    // The wheel holds a reference while the timer is linked.
+    intrusive_ptr_add_ref(impl);
+    push(impl);
+    ++size_;
+
+    return tmr;
+}
+
+int TimerWheel::dispatch(Time now)
+{
+    const auto target = floorTick(now);
+    int n{};
+    for (;;) {
+        if (due_) {
+            n += expire(now);
+            continue;
+        }
+        const auto tick = nextTick();
+        if (tick > target) {
+            break;
+        }
+        // Skip directly to the next tick with work to do.
+        now_ = tick;
+        for (int level{Levels - 1}; level > 0; --level) {
+            if ((now_ & ((int64_t{1} << (level * LevelBits)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+        // Timers in the current slot of the lowest level are due.
+        cascade(0);
+    }
+    now_ = max(now_, target);
+    return n;
+}
+
+void TimerWheel::cancel(Timer::Impl* impl) noexcept
+{
+    // Timers are unlinked while they are being expired.
+    if (impl->pprev) {
+        unlink(impl);
+        --size_;
+        intrusive_ptr_release(impl);
+    }
+}
+
+int64_t TimerWheel::nextTick() const noexcept
+{
+    if (due_) {
+        return now_;
+    }
+    auto tick = MaxTick;
+    for (int level{0}; level < Levels; ++level) {
+        if (used_[level]) {
+            const auto shift = level * LevelBits;
+            const auto pos = now_ >> shift;
+            // Distance to the next non-empty slot, starting after the current one.
+            const auto n = __builtin_ctzll(rotr(used_[level], (pos + 1) & SlotMask));
+            tick = min(tick, (pos + 1 + n) << shift);
+        }
+    }
+    return tick;
+}
+
+void TimerWheel::push(Timer::Impl* impl) noexcept
+{
+    const auto tick = min(ceilTick(impl->expiry), now_ + Horizon - 1);
+    if (tick <= now_) {
+        pushFront(due_, impl);
+        return;
+    }
+    // The level is chosen by the distance to the expiry, and the slot by its absolute time.
+    const auto level = (63 - __builtin_clzll(tick - now_)) / LevelBits;
+    const auto slot = (tick >> (level * LevelBits)) & SlotMask;
+    pushFront(slots_[level][slot], impl);
+    used_[level] |= uint64_t{1} << slot;
+}
+
+void TimerWheel::pushFront(Timer::Impl*& head, Timer::Impl* impl) noexcept
+{
+    impl->next = head;
+    if (head) {
+        head->pprev = &impl->next;
+    }
+    impl->pprev = &head;
+    head = impl;
+}
+
+void TimerWheel::unlink(Timer::Impl* impl) noexcept
+{
+    auto** const pprev = impl->pprev;
+    *pprev = impl->next;
+    if (impl->next) {
+        impl->next->pprev = pprev;
+    } else {
+        // If the link was the head of a wheel slot, then the slot is now empty.
+        const auto offset
+            = reinterpret_cast<uintptr_t>(pprev) - reinterpret_cast<uintptr_t>(&slots_[0][0]);
+        if (offset < sizeof(slots_)) {
+            const auto i = offset / sizeof(Timer::Impl*);
+            used_[i / LevelSize] &= ~(uint64_t{1} << (i % LevelSize));
+        }
+    }
+    impl->next = nullptr;
+    impl->pprev = nullptr;
+}
+
+void TimerWheel::cascade(int level) noexcept
+{
+    auto& head = slots_[level][(now_ >> (level * LevelBits)) & SlotMask];
+    if (!head) {
+        return;
+    }
+    // Detach the list, so that timers in the list may still be cancelled while it is re-hashed.
+    Timer::Impl* list{head};
+    head = nullptr;
+    list->pprev = &list;
+    used_[level] &= ~(uint64_t{1} << ((now_ >> (level * LevelBits)) & SlotMask));
+    while (list) {
+        auto* const impl = list;
+        unlink(impl);
+        push(impl);
+    }
+}
+
+int TimerWheel::expire(Time now)
+{
+    // Detach the due list, so that timers scheduled during callbacks are deferred to the next pass.
+    Timer::Impl* list{due_};
+    due_ = nullptr;
+    list->pprev = &list;
+
+    int n{};
+    while (list) {
+        auto* const impl = list;
+        unlink(impl);
+        --size_;
+
+        // Adopt the reference held by the wheel.
+        Timer tmr{impl};
+        try {
+            // Notify user.
+            tmr.slot().invoke(tmr, now);
+        } catch (const std::exception& e) {
+            SWIRLY_ERROR << "error handling timer event: "sv << e.what();
+        }
+        ++n;
+
+        // If timer was not cancelled during the callback.
+        if (tmr.pending()) {
+
+            // If periodic timer.
+            if (tmr.interval().count() > 0) {
+
+                // Add interval to expiry, while ensuring that next expiry is always in the future.
+                tmr.setExpiry(max(tmr.expiry() + tmr.interval(), now + 1ns));
+
+                // Reschedule expired timer.
+                intrusive_ptr_add_ref(impl);
+                push(impl);
+                ++size_;
+
+            } else {
+
+                // Free handler for non-repeating timer.
+                tmr.slot().reset();
+            }
+        }
+    }
+    return n;
+}
+
+} // namespace sys
+} // namespace swirly
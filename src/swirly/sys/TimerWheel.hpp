@@ -0,0 +1,94 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLY_SYS_TIMERWHEEL_HPP
+#define SWIRLY_SYS_TIMERWHEEL_HPP
+
+#include <swirly/sys/Timer.hpp>
+
+#include <cstdint>
+
+namespace swirly {
+inline namespace sys {
+
+/**
+ * Hashed hierarchical timing wheel, with constant-time insert and cancel.
+ *
+ * Expiry times are rounded up to whole milliseconds, so timers may fire up to one millisecond late,
+ * but never early. Each level has 64 slots, and each slot of a level spans a full turn of the level
+ * below. Timers are cascaded down to the level below as each slot comes due. Timers beyond the
+ * horizon of the top level, more than two years, are parked in its furthest slot and re-hashed
+ * when that slot comes due.
+ */
+class SWIRLY_API TimerWheel : public TimerPool {
+  public:
+    enum : int { LevelBits = 6, LevelSize = 1 << LevelBits, Levels = 6 };
+
+    explicit TimerWheel(Time now = UnixClock::now()) noexcept;
+    ~TimerWheel();
+
+    // Copy.
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Move.
+    TimerWheel(TimerWheel&&) = delete;
+    TimerWheel& operator=(TimerWheel&&) = delete;
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    /**
+     * Returns the time at which the wheel should next be dispatched. This may be earlier than the
+     * earliest expiry, because higher levels must be cascaded before their timers are due.
+     */
+    Time nextExpiry() const noexcept;
+
+    // clang-format off
+    [[nodiscard]] Timer insert(Time expiry, Duration interval, TimerSlot slot);
+    [[nodiscard]] Timer insert(Time expiry, TimerSlot slot)
+    {
+        return insert(expiry, Duration::zero(), slot);
+    }
+    // clang-format on
+
+    int dispatch(Time now);
+
+  private:
+    static void pushFront(Timer::Impl*& head, Timer::Impl* impl) noexcept;
+    void cancel(Timer::Impl* impl) noexcept override;
+    /**
+     * Returns the next tick at which there is work to do, or the maximum tick if there is none.
+     */
+    std::int64_t nextTick() const noexcept;
+    void push(Timer::Impl* impl) noexcept;
+    void unlink(Timer::Impl* impl) noexcept;
+    void cascade(int level) noexcept;
+    int expire(Time now);
+
+    // Current time in milliseconds since epoch.
+    std::int64_t now_;
+    std::size_t size_{};
+    // Bitmap of non-empty slots for each level.
+    std::uint64_t used_[Levels]{};
+    Timer::Impl* slots_[Levels][LevelSize]{};
+    // Timers that are due at the current tick.
+    Timer::Impl* due_{nullptr};
+};
+
+} // namespace sys
+} // namespace swirly
+
+#endif // SWIRLY_SYS_TIMERWHEEL_HPP
@@ -0,0 +1,135 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "TimerWheel.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+struct TimerLog {
+    void onTimer(Timer& tmr, Time now) { ids.push_back(tmr.id()); }
+    vector<long> ids;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TimerWheelSuite)
+
+BOOST_AUTO_TEST_CASE(TimerWheelInsertCase)
+{
+    const Time now{Millis{1000000}};
+    TimerWheel tw{now};
+    TimerLog log;
+
+    auto t = tw.insert(now + 2s, bind<&TimerLog::onTimer>(&log));
+    BOOST_TEST(t.pending());
+    BOOST_TEST(tw.size() == 1U);
+    BOOST_CHECK(tw.nextExpiry() > now);
+    BOOST_CHECK(tw.nextExpiry() <= now + 2s);
+
+    // Never early.
+    BOOST_TEST(tw.dispatch(now + 1999ms) == 0);
+    BOOST_TEST(t.pending());
+    BOOST_TEST(tw.dispatch(now + 2s) == 1);
+    BOOST_TEST(!t.pending());
+    BOOST_TEST(tw.empty());
+    BOOST_TEST(log.ids == vector<long>{t.id()});
+}
+
+BOOST_AUTO_TEST_CASE(TimerWheelRoundUpCase)
+{
+    const Time now{Millis{1000000}};
+    TimerWheel tw{now};
+    TimerLog log;
+
+    // Sub-millisecond expiry is rounded up to the next tick.
+    auto t = tw.insert(now + 1500us, bind<&TimerLog::onTimer>(&log));
+    BOOST_TEST(tw.dispatch(now + 1600us) == 0);
+    BOOST_TEST(tw.dispatch(now + 2ms) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(TimerWheelCascadeCase)
+{
+    const Time now{Millis{1000000} + 17ms};
+    TimerWheel tw{now};
+    TimerLog log;
+
+    const Duration expiries[] = {5ms, 63ms, 64ms, 4095ms, 4096ms, 10min, 3h, 9 * 24h};
+    vector<Timer> ts;
+    for (const auto expiry : expiries) {
+        ts.push_back(tw.insert(now + expiry, bind<&TimerLog::onTimer>(&log)));
+    }
+    BOOST_TEST(tw.size() == ts.size());
+
+    // Step through each expiry, checking that nothing fires a tick early.
+    for (size_t i{0}; i < ts.size(); ++i) {
+        BOOST_TEST(tw.dispatch(now + expiries[i] - 1ms) == 0);
+        BOOST_TEST(tw.dispatch(now + expiries[i]) == 1);
+        BOOST_TEST(log.ids.back() == ts[i].id());
+    }
+    BOOST_TEST(tw.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TimerWheelCancelCase)
+{
+    const Time now{Millis{1000000}};
+    TimerWheel tw{now};
+    TimerLog log;
+
+    auto t1 = tw.insert(now + 10ms, bind<&TimerLog::onTimer>(&log));
+    auto t2 = tw.insert(now + 10ms, bind<&TimerLog::onTimer>(&log));
+    auto t3 = tw.insert(now + 10s, bind<&TimerLog::onTimer>(&log));
+    BOOST_TEST(tw.size() == 3U);
+
+    t1.cancel();
+    BOOST_TEST(!t1.pending());
+    BOOST_TEST(tw.size() == 2U);
+
+    // Releasing the last reference cancels the timer.
+    t3.reset();
+    BOOST_TEST(tw.size() == 1U);
+    BOOST_CHECK(tw.nextExpiry() == now + 10ms);
+
+    BOOST_TEST(tw.dispatch(now + 1min) == 1);
+    BOOST_TEST(log.ids == vector<long>{t2.id()});
+    BOOST_TEST(tw.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TimerWheelPeriodicCase)
+{
+    const Time now{Millis{1000000}};
+    TimerWheel tw{now};
+    TimerLog log;
+
+    auto t = tw.insert(now + 100ms, 100ms, bind<&TimerLog::onTimer>(&log));
+    for (int i{1}; i <= 3; ++i) {
+        BOOST_TEST(tw.dispatch(now + i * 100ms) == 1);
+        BOOST_TEST(t.pending());
+        BOOST_CHECK(t.expiry() == now + (i + 1) * 100ms);
+    }
+    BOOST_TEST(log.ids.size() == 3U);
+    t.cancel();
+    BOOST_TEST(tw.empty());
+    BOOST_TEST(tw.dispatch(now + 1s) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -35,5 +35,54 @@ IpMcastGroup::IpMcastGroup(const IpAddress& addr, unsigned ifindex) noexcept
     }
 }
 
+UdpMsgVec::UdpMsgVec(std::size_t capacity, std::size_t slotSize)
+: slotSize_{slotSize}
+, buf_(capacity * slotSize)
+, iovs_(capacity)
+, eps_(capacity)
+, msgs_(capacity)
+{
+    for (std::size_t i{0}; i < capacity; ++i) {
+        iovs_[i].iov_base = slot(i);
+        iovs_[i].iov_len = slotSize;
+        auto& hdr = msgs_[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_iov = &iovs_[i];
+        hdr.msg_iovlen = 1;
+        msgs_[i].msg_len = 0;
+    }
+}
+
+UdpMsgVec::~UdpMsgVec() = default;
+
+// The message headers refer to heap storage, which is not relocated by a vector move.
+UdpMsgVec::UdpMsgVec(UdpMsgVec&&) noexcept = default;
+
+UdpMsgVec& UdpMsgVec::operator=(UdpMsgVec&&) noexcept = default;
+
+mmsghdr* UdpMsgVec::recvData() noexcept
+{
+    for (std::size_t i{0}; i < msgs_.size(); ++i) {
+        auto& hdr = msgs_[i].msg_hdr;
+        hdr.msg_name = eps_[i].data();
+        hdr.msg_namelen = eps_[i].capacity();
+        hdr.msg_iov->iov_len = slotSize_;
+        hdr.msg_flags = 0;
+    }
+    clear();
+    return msgs_.data();
+}
+
+void UdpMsgVec::recvCommit(std::size_t count) noexcept
+{
+    assert(count <= msgs_.size());
+    for (std::size_t i{0}; i < count; ++i) {
+        const auto& hdr = msgs_[i].msg_hdr;
+        eps_[i].resize(std::min<std::size_t>(hdr.msg_namelen, eps_[i].capacity()));
+    }
+    begin_ = 0;
+    end_ = count;
+}
+
 } // namespace sys
 } // namespace swirly
@@ -19,6 +19,9 @@
 
 #include <swirly/sys/IoSocket.hpp>
 
+#include <cstring>
+#include <vector>
+
 namespace swirly {
 inline namespace sys {
 
@@ -255,6 +258,149 @@ inline void setIpMcastTtl(int sockfd, int family, int ttl)
     }
 }
 
+/**
+ * Reusable vector of datagrams for batched I/O with sendmmsg(2) and recvmmsg(2).
+ *
+ * Each message owns a fixed-size slot in a single contiguous buffer, so the vector performs no
+ * allocation after construction. The prepare, commit and consume functions follow the Buffer
+ * protocol, but operate on whole messages rather than bytes.
+ */
+class SWIRLY_API UdpMsgVec {
+  public:
+    /**
+     * @param capacity Maximum number of messages.
+     * @param slotSize Maximum payload size of each message.
+     */
+    UdpMsgVec(std::size_t capacity, std::size_t slotSize);
+    ~UdpMsgVec();
+
+    // Copy.
+    UdpMsgVec(const UdpMsgVec&) = delete;
+    UdpMsgVec& operator=(const UdpMsgVec&) = delete;
+
+    // Move.
+    UdpMsgVec(UdpMsgVec&&) noexcept;
+    UdpMsgVec& operator=(UdpMsgVec&&) noexcept;
+
+    /**
+     * Returns the maximum number of messages.
+     */
+    std::size_t capacity() const noexcept { return msgs_.size(); }
+    /**
+     * Returns the maximum payload size of each message.
+     */
+    std::size_t slotSize() const noexcept { return slotSize_; }
+    /**
+     * Returns true if there are no messages.
+     */
+    bool empty() const noexcept { return begin_ == end_; }
+    /**
+     * Returns true if no more messages can be committed.
+     */
+    bool full() const noexcept { return end_ == msgs_.size(); }
+    /**
+     * Returns the number of messages pending send, or received by the last call to recvmmsg.
+     */
+    std::size_t size() const noexcept { return end_ - begin_; }
+
+    /**
+     * Returns the payload of the i'th message.
+     */
+    ConstBuffer data(std::size_t i) const noexcept
+    {
+        const auto& msg = msgs_[begin_ + i];
+        return {msg.msg_hdr.msg_iov->iov_base, msg.msg_len};
+    }
+    /**
+     * Returns the source address of the i'th received message.
+     */
+    const UdpEndpoint& endpoint(std::size_t i) const noexcept { return eps_[begin_ + i]; }
+
+    /**
+     * Remove all messages.
+     */
+    void clear() noexcept { begin_ = end_ = 0; }
+    /**
+     * Returns the payload slot of the next message.
+     */
+    MutableBuffer prepare() noexcept
+    {
+        assert(!full());
+        return {slot(end_), slotSize_};
+    }
+    /**
+     * Append the next message, which will be sent to the socket's peer address.
+     */
+    void commit(std::size_t size) noexcept { commit(size, nullptr, 0); }
+    /**
+     * Append the next message, which will be sent to the specified endpoint.
+     */
+    void commit(std::size_t size, const UdpEndpoint& ep) noexcept
+    {
+        eps_[end_] = ep;
+        commit(size, eps_[end_].data(), ep.size());
+    }
+    /**
+     * Copy a datagram into the next slot and append it.
+     */
+    void push(ConstBuffer buf) noexcept { commit(copy(buf)); }
+    /**
+     * Copy a datagram into the next slot and append it.
+     */
+    void push(ConstBuffer buf, const UdpEndpoint& ep) noexcept { commit(copy(buf), ep); }
+    /**
+     * Remove messages from the front, typically after a partial send.
+     */
+    void consume(std::size_t count) noexcept
+    {
+        assert(count <= size());
+        begin_ += count;
+        if (begin_ == end_) {
+            clear();
+        }
+    }
+
+    /**
+     * Returns the pending messages in the form expected by sendmmsg.
+     */
+    mmsghdr* sendData() noexcept { return &msgs_[begin_]; }
+    /**
+     * Reset every message to receive a full slot and source address, and return them in the form
+     * expected by recvmmsg.
+     */
+    mmsghdr* recvData() noexcept;
+    /**
+     * Record the number of messages filled by recvmmsg.
+     */
+    void recvCommit(std::size_t count) noexcept;
+
+  private:
+    char* slot(std::size_t i) noexcept { return &buf_[i * slotSize_]; }
+    std::size_t copy(ConstBuffer buf) noexcept
+    {
+        const auto size = buffer_size(buf);
+        assert(!full() && size <= slotSize_);
+        std::memcpy(slot(end_), buffer_cast<const void*>(buf), size);
+        return size;
+    }
+    void commit(std::size_t size, sockaddr* addr, socklen_t addrlen) noexcept
+    {
+        assert(size <= slotSize_);
+        auto& msg = msgs_[end_++];
+        msg.msg_hdr.msg_name = addr;
+        msg.msg_hdr.msg_namelen = addrlen;
+        msg.msg_hdr.msg_iov->iov_len = size;
+        msg.msg_len = size;
+    }
+
+    std::size_t slotSize_;
+    std::vector<char> buf_;
+    std::vector<iovec> iovs_;
+    std::vector<UdpEndpoint> eps_;
+    std::vector<mmsghdr> msgs_;
+    std::size_t begin_{0}, end_{0};
+};
+
 /**
  * Connectionless UDP Socket. All state is in base class, so object can be sliced.
  */
@@ -326,6 +472,40 @@ struct UdpSocket : IoSocket {
         return os::sendto(*sock_, buf, flags, ep);
     }
 
+    /**
+     * Receive up to capacity messages into the vector, replacing its contents.
+     */
+    int recvmmsg(UdpMsgVec& vec, int flags, std::error_code& ec) noexcept
+    {
+        const auto ret = os::recvmmsg(*sock_, vec.recvData(), vec.capacity(), flags, nullptr, ec);
+        vec.recvCommit(ret < 0 ? 0 : ret);
+        return ret;
+    }
+    std::size_t recvmmsg(UdpMsgVec& vec, int flags)
+    {
+        const auto ret = os::recvmmsg(*sock_, vec.recvData(), vec.capacity(), flags, nullptr);
+        vec.recvCommit(ret);
+        return ret;
+    }
+
+    /**
+     * Send the pending messages in the vector, and consume those that were sent.
+     */
+    int sendmmsg(UdpMsgVec& vec, int flags, std::error_code& ec) noexcept
+    {
+        const auto ret = os::sendmmsg(*sock_, vec.sendData(), vec.size(), flags, ec);
+        if (ret > 0) {
+            vec.consume(ret);
+        }
+        return ret;
+    }
+    std::size_t sendmmsg(UdpMsgVec& vec, int flags)
+    {
+        const auto ret = os::sendmmsg(*sock_, vec.sendData(), vec.size(), flags);
+        vec.consume(ret);
+        return ret;
+    }
+
     void joinGroup(const IpAddress& addr, unsigned ifindex, std::error_code& ec) noexcept
     {
         return swirly::joinGroup(*sock_, addr, ifindex, ec);
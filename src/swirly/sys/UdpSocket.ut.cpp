@@ -0,0 +1,94 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "UdpSocket.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace swirly;
+
+BOOST_AUTO_TEST_SUITE(UdpSocketSuite)
+
+BOOST_AUTO_TEST_CASE(UdpMsgVecCase)
+{
+    UdpMsgVec vec{4, 16};
+    BOOST_TEST(vec.capacity() == 4U);
+    BOOST_TEST(vec.slotSize() == 16U);
+    BOOST_TEST(vec.empty());
+
+    vec.push({"foo", 3});
+    auto buf = vec.prepare();
+    BOOST_TEST(buffer_size(buf) == 16U);
+    memcpy(buffer_cast<char*>(buf), "barbaz", 6);
+    vec.commit(6);
+    BOOST_TEST(vec.size() == 2U);
+    BOOST_TEST(!vec.full());
+    BOOST_TEST(string(buffer_cast<const char*>(vec.data(1)), buffer_size(vec.data(1))) == "barbaz");
+
+    vec.consume(1);
+    BOOST_TEST(vec.size() == 1U);
+    BOOST_TEST(string(buffer_cast<const char*>(vec.data(0)), buffer_size(vec.data(0))) == "barbaz");
+
+    vec.consume(1);
+    BOOST_TEST(vec.empty());
+    // Consuming the last message resets the vector.
+    for (int i{0}; i < 4; ++i) {
+        vec.push({"x", 1});
+    }
+    BOOST_TEST(vec.full());
+}
+
+BOOST_AUTO_TEST_CASE(UdpMmsgCase)
+{
+    UdpSocket rsock{Udp::v4()};
+    rsock.bind(UdpEndpoint{IpAddress::from_string("127.0.0.1"), 0});
+    UdpEndpoint rep;
+    rsock.getSockName(rep);
+
+    UdpSocket ssock{Udp::v4()};
+    ssock.bind(UdpEndpoint{IpAddress::from_string("127.0.0.1"), 0});
+    UdpEndpoint sep;
+    ssock.getSockName(sep);
+
+    UdpMsgVec out{8, 64};
+    for (int i{0}; i < 5; ++i) {
+        const auto s = "msg"s + to_string(i);
+        out.push({s.data(), s.size()}, rep);
+    }
+    BOOST_TEST(ssock.sendmmsg(out, 0) == 5U);
+    BOOST_TEST(out.empty());
+
+    UdpMsgVec in{8, 64};
+    size_t n{0};
+    while (n < 5) {
+        // Loopback delivery is synchronous, so all messages are already queued.
+        const auto m = rsock.recvmmsg(in, MSG_DONTWAIT);
+        BOOST_TEST(m > 0U);
+        for (size_t i{0}; i < m; ++i, ++n) {
+            const auto data = in.data(i);
+            BOOST_TEST(string(buffer_cast<const char*>(data), buffer_size(data))
+                       == "msg"s + to_string(n));
+            BOOST_TEST(in.endpoint(i) == sep);
+        }
+    }
+    error_code ec;
+    BOOST_TEST(rsock.recvmmsg(in, MSG_DONTWAIT, ec) < 0);
+    BOOST_TEST(ec.value() == EAGAIN);
+    BOOST_TEST(in.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,8 @@
 #include <swirly/web/Types.hpp>
 #include <swirly/web/Url.hpp>
 
+#include <swirly/util/Time.hpp>
+
 namespace swirly {
 inline namespace web {
 
@@ -44,6 +46,11 @@ class SWIRLY_API HttpRequest : public BasicUrl<HttpRequest> {
     auto time() const noexcept { return +time_; }
     const auto& body() const noexcept { return body_; }
     auto partial() const noexcept { return partial_; }
+    /**
+     * Returns the kernel's receive timestamp for the start of the request, or zero if timestamping
+     * is not enabled.
+     */
+    Time recvTime() const noexcept { return recvTime_; }
     void clear() noexcept
     {
         BasicUrl<HttpRequest>::reset();
@@ -57,9 +64,11 @@ class SWIRLY_API HttpRequest : public BasicUrl<HttpRequest> {
         time_.clear();
         body_.reset();
         partial_ = false;
+        recvTime_ = {};
     }
     void flush() { BasicUrl<HttpRequest>::parse(); }
     void setMethod(HttpMethod method) noexcept { method_ = method; }
+    void setRecvTime(Time time) noexcept { recvTime_ = time; }
     void appendUrl(std::string_view sv) { url_ += sv; }
     void appendHeaderField(std::string_view sv, bool first)
     {
@@ -99,6 +108,7 @@ class SWIRLY_API HttpRequest : public BasicUrl<HttpRequest> {
     StringBuf<24> time_;
     RestBody body_;
     bool partial_{false};
+    Time recvTime_{};
 };
 
 } // namespace web
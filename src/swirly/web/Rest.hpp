@@ -43,6 +43,9 @@ class SWIRLY_API Rest {
 
     void load(const Model& model, Time now) { serv_.load(model, now); }
 
+    const Serv& serv() const noexcept { return serv_; }
+    void setMarketSlot(MarketSlot slot) noexcept { serv_.setMarketSlot(slot); }
+
     void getRefData(EntitySet es, Time now, std::ostream& out) const;
 
     void getAsset(Time now, std::ostream& out) const;
@@ -16,6 +16,8 @@
  */
 #include "Stream.hpp"
 
+#include <swirly/sys/File.hpp>
+
 namespace swirly {
 inline namespace web {
 using namespace std;
@@ -28,16 +30,138 @@ constexpr bool withBody(int status) noexcept
     return !((status >= 100 && status < 200) || status == 204 || status == 304);
 }
 
+// Cleared queues retain their capacity, so a segment can always be spliced into an empty queue.
+constexpr size_t InitSegs{16};
+
 } // namespace
 
-void HttpBuf::setContentLength(std::streamsize pos, std::streamsize len) noexcept
+HttpOutQueue::HttpOutQueue()
+{
+    segs_.reserve(InitSegs);
+}
+
+HttpOutQueue::~HttpOutQueue() = default;
+
+void HttpOutQueue::clear() noexcept
+{
+    buf_.clear();
+    segs_.clear();
+    base_ = front_ = skip_ = size_ = 0;
+}
+
+void HttpOutQueue::append(string_view data)
+{
+    const auto offset = this->offset();
+    auto buf = buf_.prepare(data.size());
+    memcpy(buffer_cast<char*>(buf), data.data(), data.size());
+    buf_.commit(data.size());
+    push({nullptr, offset, data.size()});
+}
+
+void HttpOutQueue::splice(string_view data)
+{
+    push({data.data(), 0, data.size()});
+}
+
+void HttpOutQueue::copy(char* dst) const noexcept
+{
+    auto skip = skip_;
+    for (auto i = front_; i < segs_.size(); ++i) {
+        const auto& seg = segs_[i];
+        memcpy(dst, data(seg) + skip, seg.len - skip);
+        dst += seg.len - skip;
+        skip = 0;
+    }
+}
+
+size_t HttpOutQueue::flush(int fd)
+{
+    enum { MaxIov = 64 };
+    iovec iov[MaxIov];
+    int n{0};
+    auto skip = skip_;
+    for (auto i = front_; i < segs_.size() && n < MaxIov; ++i) {
+        const auto& seg = segs_[i];
+        iov[n].iov_base = const_cast<char*>(data(seg) + skip);
+        iov[n].iov_len = seg.len - skip;
+        ++n;
+        skip = 0;
+    }
+    const auto count = os::writev(fd, iov, n);
+    consume(count);
+    return count;
+}
+
+void HttpOutQueue::reserve(size_t count)
 {
-    auto it = pbase_ + pos;
-    do {
-        --it;
-        *it = '0' + len % 10;
-        len /= 10;
-    } while (len > 0);
+    const auto n = segs_.size() + count;
+    if (n > segs_.capacity()) {
+        segs_.reserve(max(n, segs_.capacity() * 2));
+    }
+}
+
+void HttpOutQueue::push(const Segment& seg)
+{
+    if (seg.len == 0) {
+        return;
+    }
+    if (front_ < segs_.size()) {
+        // Merge adjacent runs of owned bytes.
+        auto& back = segs_.back();
+        if (!back.ref && !seg.ref && back.offset + back.len == seg.offset) {
+            back.len += seg.len;
+            size_ += seg.len;
+            return;
+        }
+    }
+    segs_.push_back(seg);
+    size_ += seg.len;
+}
+
+void HttpOutQueue::consume(size_t count) noexcept
+{
+    size_ -= count;
+    if (size_ == 0) {
+        // Release owned bytes.
+        clear();
+        return;
+    }
+    count += skip_;
+    const auto front = front_;
+    while (count >= segs_[front_].len) {
+        count -= segs_[front_].len;
+        ++front_;
+    }
+    skip_ = count;
+    if (front_ != front) {
+        // The queue may never drain under sustained pipelining.
+        release();
+    }
+}
+
+void HttpOutQueue::release() noexcept
+{
+    // Responses are queued in order, but the header of each is rendered after its body. The first
+    // pending byte is therefore either in the first owned segment, or in one of the body segments
+    // that follow it, all of which precede that segment in the buffer.
+    size_t first{offset()};
+    for (auto i = front_; i < segs_.size(); ++i) {
+        const auto& seg = segs_[i];
+        if (!seg.ref) {
+            if (seg.offset > first) {
+                break;
+            }
+            first = seg.offset;
+        }
+    }
+    buf_.consume(first - base_);
+    base_ = first;
+
+    // Erase written segments once they make up half of the list.
+    if (front_ >= segs_.size() / 2) {
+        segs_.erase(segs_.begin(), segs_.begin() + front_);
+        front_ = 0;
+    }
 }
 
 HttpBuf::~HttpBuf() = default;
@@ -45,8 +169,9 @@ HttpBuf::~HttpBuf() = default;
 HttpBuf::int_type HttpBuf::overflow(int_type c) noexcept
 {
     if (c != traits_type::eof()) {
-        auto buf = buf_.prepare(pcount_ + 1);
-        pbase_ = buffer_cast<char*>(buf);
+        if (!prepare(pcount_ + 1)) {
+            return traits_type::eof();
+        }
         pbase_[pcount_++] = c;
     }
     return c;
@@ -54,45 +179,86 @@ HttpBuf::int_type HttpBuf::overflow(int_type c) noexcept
 
 streamsize HttpBuf::xsputn(const char_type* s, streamsize count) noexcept
 {
-    auto buf = buf_.prepare(pcount_ + count);
-    pbase_ = buffer_cast<char*>(buf);
+    if (!prepare(pcount_ + count)) {
+        return 0;
+    }
     memcpy(pbase_ + pcount_, s, count);
     pcount_ += count;
     return count;
 }
 
-HttpStream::~HttpStream() = default;
-
-void HttpStream::commit() noexcept
+bool HttpBuf::prepare(streamsize size) noexcept
 {
-    if (cloff_ > 0) {
-        buf_.setContentLength(cloff_, pcount() - hcount_);
+    try {
+        pbase_ = buffer_cast<char*>(buf_.prepare(size));
+    } catch (const exception&) {
+        // The stream sets badbit when the put fails.
+        return false;
     }
-    buf_.commit();
+    return true;
 }
 
-void HttpStream::reset(int status, const char* reason, bool cache)
-{
-    buf_.reset();
-    swirly::reset(*this);
+HttpStream::~HttpStream() = default;
 
-    *this << "HTTP/1.1 "sv << status << ' ' << reason;
-    if (!cache) {
+void HttpStream::commit()
+{
+    // The body is incomplete if any part of it failed to render.
+    if (bad()) {
+        throw bad_alloc{};
+    }
+    closeRun();
+    // Reserve room for the header, so that nothing below can fail once the response is partly
+    // queued.
+    body_.reserve(body_.size() + 1);
+    out_.reserve(body_.size() + 1);
+    size_t len{0};
+    for (const auto& seg : body_) {
+        len += seg.len;
+    }
+    *this << "HTTP/1.1 "sv << status_ << ' ' << reason_;
+    if (!cache_) {
         *this << "\r\nCache-Control: no-cache"sv;
     }
-    if (withBody(status)) {
-        // Status-Line = HTTP-Version SP Status-Code SP Reason-Phrase CRLF. Use 10 space
-        // place-holder for content length. RFC2616 states that field value MAY be preceded by any
-        // amount of LWS, though a single SP is preferred.
-        *this <<                                 //
-            "\r\nContent-Type: application/json" //
-            "\r\nContent-Length:          0";
-        cloff_ = pcount();
-    } else {
-        cloff_ = 0;
+    if (withBody(status_)) {
+        *this << "\r\nContent-Type: application/json\r\nContent-Length: "sv << len;
     }
     *this << "\r\n\r\n"sv;
-    hcount_ = pcount();
+    if (bad()) {
+        throw bad_alloc{};
+    }
+    closeRun();
+
+    // The header was rendered last, so rotate it to the front.
+    out_.push(body_.back());
+    body_.pop_back();
+    for (const auto& seg : body_) {
+        out_.push(seg);
+    }
+    body_.clear();
+}
+
+void HttpStream::reset(int status, const char* reason, bool cache) noexcept
+{
+    reset();
+    status_ = status;
+    reason_ = reason;
+    cache_ = cache;
+}
+
+void HttpStream::splice(string_view data)
+{
+    closeRun();
+    body_.push_back({data.data(), 0, data.size()});
+}
+
+void HttpStream::closeRun()
+{
+    const auto len = buf_.pcount();
+    if (len > 0) {
+        body_.push_back({nullptr, out_.offset(), static_cast<size_t>(len)});
+        buf_.commit();
+        buf_.reset();
+    }
 }
 
 } // namespace web
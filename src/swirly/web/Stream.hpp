@@ -21,9 +21,95 @@
 
 #include <swirly/util/Stream.hpp>
 
+#include <string_view>
+#include <vector>
+
 namespace swirly {
 inline namespace web {
 
+/**
+ * Queue of pending output for a connection. The queue is a sequence of segments, each of which is
+ * either a run of bytes owned by the queue, or a fragment, such as a pre-rendered body, that is
+ * spliced in by reference. The pending segments are written with a single writev() call.
+ */
+class SWIRLY_API HttpOutQueue {
+    friend class HttpStream;
+
+  public:
+    HttpOutQueue();
+    ~HttpOutQueue();
+
+    // Copy.
+    HttpOutQueue(const HttpOutQueue& rhs) = delete;
+    HttpOutQueue& operator=(const HttpOutQueue& rhs) = delete;
+
+    // Move.
+    HttpOutQueue(HttpOutQueue&&) = delete;
+    HttpOutQueue& operator=(HttpOutQueue&&) = delete;
+
+    bool empty() const noexcept { return size_ == 0; }
+    /**
+     * Returns the number of bytes pending.
+     */
+    std::size_t size() const noexcept { return size_; }
+    void clear() noexcept;
+    /**
+     * Append a copy of the data.
+     */
+    void append(std::string_view data);
+    /**
+     * Append a fragment by reference. The fragment must remain valid until it has been written.
+     * This does not allocate if the queue is empty.
+     */
+    void splice(std::string_view data);
+    /**
+     * Copy the pending output to a buffer with room for size() bytes.
+     */
+    void copy(char* dst) const noexcept;
+    /**
+     * Write as much of the pending output as possible with a single writev() call.
+     *
+     * Returns the number of bytes written.
+     */
+    std::size_t flush(int fd);
+
+  private:
+    struct Segment {
+        // Null if the segment is owned by the queue.
+        const char* ref;
+        // Offset of an owned segment, counted from the first byte appended since the queue was last
+        // empty.
+        std::size_t offset;
+        std::size_t len;
+    };
+    const char* data(const Segment& seg) const noexcept
+    {
+        return seg.ref ? seg.ref : buffer_cast<const char*>(buf_.data()) + (seg.offset - base_);
+    }
+    /**
+     * Returns the offset of the next owned byte.
+     */
+    std::size_t offset() const noexcept { return base_ + buf_.size(); }
+    /**
+     * Reserve room for count more segments.
+     */
+    void reserve(std::size_t count);
+    void push(const Segment& seg);
+    void consume(std::size_t count) noexcept;
+    /**
+     * Release owned bytes and segments that have been written.
+     */
+    void release() noexcept;
+
+    Buffer buf_;
+    // Offset of the first owned byte in the buffer.
+    std::size_t base_{0};
+    std::vector<Segment> segs_;
+    // First segment with pending output, and the number of its bytes already written.
+    std::size_t front_{0}, skip_{0};
+    std::size_t size_{0};
+};
+
 class SWIRLY_API HttpBuf : public std::streambuf {
   public:
     explicit HttpBuf(Buffer& buf) noexcept
@@ -47,23 +133,34 @@ class SWIRLY_API HttpBuf : public std::streambuf {
         pbase_ = nullptr;
         pcount_ = 0;
     }
-    void setContentLength(std::streamsize pos, std::streamsize len) noexcept;
 
   protected:
     int_type overflow(int_type c) noexcept override;
     std::streamsize xsputn(const char_type* s, std::streamsize count) noexcept override;
 
   private:
+    /**
+     * Returns false if the buffer cannot be grown to the specified size, in which case the put
+     * fails and the stream's badbit is set.
+     */
+    bool prepare(std::streamsize size) noexcept;
+
     Buffer& buf_;
     char* pbase_{nullptr};
     std::streamsize pcount_{0};
 };
 
+/**
+ * Response builder. The body is rendered through the stream, and may include fragments that are
+ * spliced in by reference. The header is rendered once the body is complete, so that the
+ * Content-Length is known, and it is queued ahead of the body as a separate segment.
+ */
 class SWIRLY_API HttpStream : public std::ostream {
   public:
-    explicit HttpStream(Buffer& buf) noexcept
+    explicit HttpStream(HttpOutQueue& out) noexcept
     : std::ostream{nullptr}
-    , buf_{buf}
+    , out_(out)
+    , buf_{out.buf_}
     {
         rdbuf(&buf_);
     }
@@ -77,26 +174,37 @@ class SWIRLY_API HttpStream : public std::ostream {
     HttpStream(HttpStream&&) = delete;
     HttpStream& operator=(HttpStream&&) = delete;
 
-    std::streamsize pcount() const noexcept { return buf_.pcount(); }
-    void commit() noexcept;
+    /**
+     * Queue the response.
+     *
+     * @throw std::bad_alloc if there is no room for the response, in which case nothing is queued.
+     */
+    void commit();
     void reset() noexcept
     {
         buf_.reset();
         swirly::reset(*this);
-        cloff_ = hcount_ = 0;
+        body_.clear();
     }
-    void reset(int status, const char* reason, bool cache = false);
-
-  private:
-    HttpBuf buf_;
+    void reset(int status, const char* reason, bool cache = false) noexcept;
     /**
-     * Content-Length offset.
+     * Append a body fragment by reference. The fragment must remain valid until the response has
+     * been written.
      */
-    std::streamsize cloff_{0};
+    void splice(std::string_view data);
+
+  private:
     /**
-     * Header size.
+     * Close the run of bytes rendered since the last segment.
      */
-    std::streamsize hcount_{0};
+    void closeRun();
+
+    HttpOutQueue& out_;
+    HttpBuf buf_;
+    int status_{0};
+    const char* reason_{nullptr};
+    bool cache_{false};
+    std::vector<HttpOutQueue::Segment> body_;
 };
 
 } // namespace web
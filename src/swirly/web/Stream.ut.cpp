@@ -0,0 +1,168 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "Stream.hpp"
+
+#include <swirly/sys/File.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+
+#include <fcntl.h>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+string toString(const HttpOutQueue& out)
+{
+    string s(out.size(), '\0');
+    out.copy(s.data());
+    return s;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(StreamSuite)
+
+BOOST_AUTO_TEST_CASE(HttpStreamCase)
+{
+    HttpOutQueue out;
+    HttpStream os{out};
+
+    os.reset(200, "OK");
+    os << "{\"a\":"sv;
+    os.splice("[1,2,3]"sv);
+    os << '}';
+    os.commit();
+    BOOST_TEST(toString(out)
+               == "HTTP/1.1 200 OK\r\nCache-Control: no-cache\r\nContent-Type: application/json\r\n"
+                  "Content-Length: 13\r\n\r\n{\"a\":[1,2,3]}"s);
+
+    out.clear();
+    BOOST_TEST(out.empty());
+
+    os.reset(204, "No Content", true);
+    os.commit();
+    BOOST_TEST(toString(out) == "HTTP/1.1 204 No Content\r\n\r\n"s);
+}
+
+BOOST_AUTO_TEST_CASE(HttpStreamFailCase)
+{
+    HttpOutQueue out;
+    HttpStream os{out};
+
+    os.reset(200, "OK");
+    os << "{\"a\":"sv;
+    // The buffer cannot grow to this size, so the put fails without reading the source.
+    const char* const data{"x"};
+    os.write(data, numeric_limits<streamsize>::max() / 2);
+    BOOST_TEST(os.bad());
+    BOOST_CHECK_THROW(os.commit(), bad_alloc);
+    BOOST_TEST(out.empty());
+
+    // The stream is usable once reset.
+    os.reset(204, "No Content", true);
+    os.commit();
+    BOOST_TEST(toString(out) == "HTTP/1.1 204 No Content\r\n\r\n"s);
+}
+
+BOOST_AUTO_TEST_CASE(HttpOutQueueCase)
+{
+    HttpOutQueue out;
+    out.append("foo"sv);
+    out.append("bar"sv);
+    out.splice("baz"sv);
+    BOOST_TEST(out.size() == 9U);
+    BOOST_TEST(toString(out) == "foobarbaz"s);
+}
+
+BOOST_AUTO_TEST_CASE(HttpOutQueueFlushCase)
+{
+    auto fds = os::pipe2(O_NONBLOCK);
+    const auto cap = os::fcntl(fds.second.get(), F_GETPIPE_SZ);
+
+    // Larger than the pipe, so that the first flush is partial.
+    const string frag(cap + 100, 'x');
+    HttpOutQueue out;
+    out.append("head"sv);
+    out.splice(frag);
+    out.append("tail"sv);
+
+    string in;
+    char buf[4096];
+    while (!out.empty()) {
+        out.flush(fds.second.get());
+        ssize_t n;
+        while ((n = ::read(fds.first.get(), buf, sizeof(buf))) > 0) {
+            in.append(buf, n);
+        }
+    }
+    BOOST_TEST(in.size() == frag.size() + 8);
+    BOOST_TEST(in.compare(0, 4, "head"s) == 0);
+    BOOST_TEST(in.compare(4, frag.size(), frag) == 0);
+    BOOST_TEST(in.compare(in.size() - 4, 4, "tail"s) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(HttpOutQueuePipelineCase)
+{
+    auto fds = os::pipe2(O_NONBLOCK);
+
+    HttpOutQueue out;
+    HttpStream os{out};
+
+    // The reader is slower than the writer, so the queue does not drain until the end, and written
+    // bytes are released while responses are still pending.
+    const auto flush = [&out, fd = fds.second.get()]() {
+        try {
+            out.flush(fd);
+        } catch (const system_error& e) {
+            // The pipe is full.
+            BOOST_REQUIRE(e.code() == errc::resource_unavailable_try_again);
+        }
+    };
+    const string frag(100, 'x');
+    string expected, in;
+    char buf[100];
+    for (int i{0}; i < 1000; ++i) {
+        os.reset(200, "OK");
+        os << "{\"i\":"sv << i << ",\"x\":\""sv;
+        os.splice(frag);
+        os << "\"}"sv;
+        const auto size = out.size();
+        os.commit();
+        string resp(out.size(), '\0');
+        out.copy(resp.data());
+        expected.append(resp, size, string::npos);
+
+        flush();
+        const auto n = ::read(fds.first.get(), buf, sizeof(buf));
+        if (n > 0) {
+            in.append(buf, n);
+        }
+    }
+    BOOST_TEST(!out.empty());
+    while (!out.empty()) {
+        flush();
+        ssize_t n;
+        while ((n = ::read(fds.first.get(), buf, sizeof(buf))) > 0) {
+            in.append(buf, n);
+        }
+    }
+    BOOST_TEST(in == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,47 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "HttpLatency.hpp"
+
+namespace swirly {
+using namespace std;
+
+namespace {
+enum { ReportInterval = 1000 };
+} // namespace
+
+HttpLatency::HttpLatency() noexcept
+: kernel_{"http_kernel"sv}
+, parse_{"http_parse"sv}
+, engine_{"http_engine"sv}
+, send_{"http_send"sv}
+{
+}
+
+HttpLatency::~HttpLatency() = default;
+
+void HttpLatency::recordSend(Duration d) noexcept
+{
+    record(send_, d);
+    if (send_.size() % ReportInterval == 0) {
+        kernel_.report();
+        parse_.report();
+        engine_.report();
+        send_.report();
+    }
+}
+
+} // namespace swirly
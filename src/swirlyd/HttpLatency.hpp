@@ -0,0 +1,69 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_HTTPLATENCY_HPP
+#define SWIRLYD_HTTPLATENCY_HPP
+
+#include <swirly/util/Profile.hpp>
+#include <swirly/util/Time.hpp>
+
+namespace swirly {
+
+/**
+ * Latency profile of HTTP requests, split into the following phases:
+ *
+ * - kernel: from the kernel's receive timestamp to the read that returned the request;
+ * - parse: from that read to the end of the parsed request;
+ * - engine: from the end of the request until its response is queued, including any hand-off to
+ *   and from the engine thread;
+ * - send: from the response being queued to the kernel's transmit timestamp of its last byte.
+ *
+ * Each thread that serves HTTP has its own profile.
+ */
+class HttpLatency {
+  public:
+    HttpLatency() noexcept;
+    ~HttpLatency();
+
+    // Copy.
+    HttpLatency(const HttpLatency&) = delete;
+    HttpLatency& operator=(const HttpLatency&) = delete;
+
+    // Move.
+    HttpLatency(HttpLatency&&) = delete;
+    HttpLatency& operator=(HttpLatency&&) = delete;
+
+    void recordKernel(Duration d) noexcept { record(kernel_, d); }
+    void recordParse(Duration d) noexcept { record(parse_, d); }
+    void recordEngine(Duration d) noexcept { record(engine_, d); }
+    /**
+     * The send phase completes each request, so the profiles are reported periodically from here.
+     */
+    void recordSend(Duration d) noexcept;
+
+  private:
+    static void record(Profile& profile, Duration d) noexcept
+    {
+        const std::chrono::duration<double, std::micro> usec{d};
+        profile.record(usec.count());
+    }
+
+    Profile kernel_, parse_, engine_, send_;
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_HTTPLATENCY_HPP
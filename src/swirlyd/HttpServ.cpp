@@ -16,15 +16,27 @@
  */
 #include "HttpServ.hpp"
 
+#include "HttpLatency.hpp"
 #include "HttpSess.hpp"
+#include "RestChannel.hpp"
 
 namespace swirly {
 using namespace std;
 
-HttpServ::HttpServ(Reactor& r, const Endpoint& ep, RestServ& rs)
+HttpServ::HttpServ(Reactor& r, const Endpoint& ep, RestServ& rs, bool timestamps)
 : TcpAcceptor{r, ep}
 , reactor_(r)
-, restServ_(rs)
+, restServ_{&rs}
+, latency_{timestamps ? make_unique<HttpLatency>() : nullptr}
+{
+}
+
+HttpServ::HttpServ(Reactor& r, const Endpoint& ep, RestChannel& rc, bool timestamps)
+: TcpAcceptor{r, ep, true}
+, reactor_(r)
+, restChannel_{&rc}
+, latency_{timestamps ? make_unique<HttpLatency>() : nullptr}
+, responseSub_{rc.subscribeResponses(r)}
 {
 }
 
@@ -35,7 +47,36 @@ HttpServ::~HttpServ()
 
 void HttpServ::doAccept(IoSocket&& sock, const Endpoint& ep, Time now)
 {
-    auto* const sess = new HttpSess{reactor_, move(sock), ep, restServ_, now};
+    auto* const sess = restServ_
+        ? new HttpSess{reactor_, move(sock), ep, *restServ_, latency_.get(), now}
+        : new HttpSess{reactor_, move(sock), ep, *restChannel_, latency_.get(), now};
+    list_.push_back(*sess);
+}
+
+int HttpServ::operator()()
+{
+    // The token is the address of the session, which outlives its forwarded requests.
+    return restChannel_->fetchResponses([](uintptr_t token, string_view data) {
+        reinterpret_cast<HttpSess*>(token)->onResponse(data);
+    });
+}
+
+HttpLocalServ::HttpLocalServ(Reactor& r, const Endpoint& ep, RestServ& rs)
+: LocalAcceptor{r, ep}
+, reactor_(r)
+, restServ_(rs)
+{
+}
+
+HttpLocalServ::~HttpLocalServ()
+{
+    list_.clear_and_dispose([](auto* sess) { delete sess; });
+}
+
+void HttpLocalServ::doAccept(IoSocket&& sock, const Endpoint& ep, Time now)
+{
+    // Transmit timestamps are not supported on Unix domain sockets.
+    auto* const sess = new HttpSess{reactor_, move(sock), ep, restServ_, nullptr, now};
     list_.push_back(*sess);
 }
 
@@ -21,8 +21,12 @@
 
 #include <swirly/sys/TcpAcceptor.hpp>
 
+#include <memory>
+
 namespace swirly {
 
+class HttpLatency;
+class RestChannel;
 class RestServ;
 
 class SWIRLY_API HttpServ : public TcpAcceptor<HttpServ> {
@@ -32,7 +36,16 @@ class SWIRLY_API HttpServ : public TcpAcceptor<HttpServ> {
     using List = boost::intrusive::list<HttpSess, ConstantTimeSizeOption, MemberHookOption>;
 
   public:
-    HttpServ(Reactor& r, const Endpoint& ep, RestServ& rs);
+    /**
+     * If timestamps is true, then kernel timestamping is enabled on each session, and the latency
+     * of each request is profiled.
+     */
+    HttpServ(Reactor& r, const Endpoint& ep, RestServ& rs, bool timestamps);
+    /**
+     * Front-end that forwards requests to the engine thread over the channel. The listener uses
+     * SO_REUSEPORT, so that each front-end thread may accept connections on the same port.
+     */
+    HttpServ(Reactor& r, const Endpoint& ep, RestChannel& rc, bool timestamps);
     ~HttpServ();
 
     // Copy.
@@ -45,6 +58,47 @@ class SWIRLY_API HttpServ : public TcpAcceptor<HttpServ> {
 
     void doAccept(IoSocket&& sock, const Endpoint& ep, Time now);
 
+    /**
+     * Deliver responses returned by the engine thread to their sessions. This is the agent of the
+     * front-end's reactor thread.
+     */
+    int operator()();
+
+  private:
+    Reactor& reactor_;
+    RestServ* restServ_{nullptr};
+    RestChannel* restChannel_{nullptr};
+    // Shared by the sessions of this thread.
+    std::unique_ptr<HttpLatency> latency_;
+    // Wakes the reactor when the engine thread returns responses.
+    Reactor::Handle responseSub_;
+    List list_;
+};
+
+/**
+ * HTTP server on a Unix domain stream socket, for clients on the same host. Requests are always
+ * handled directly on the engine thread, whether or not there are front-end threads for TCP.
+ */
+class SWIRLY_API HttpLocalServ : public LocalAcceptor<HttpLocalServ> {
+    using ConstantTimeSizeOption = boost::intrusive::constant_time_size<false>;
+    using MemberHookOption = boost::intrusive::member_hook<HttpSess, decltype(HttpSess::listHook),
+                                                           &HttpSess::listHook>;
+    using List = boost::intrusive::list<HttpSess, ConstantTimeSizeOption, MemberHookOption>;
+
+  public:
+    HttpLocalServ(Reactor& r, const Endpoint& ep, RestServ& rs);
+    ~HttpLocalServ();
+
+    // Copy.
+    HttpLocalServ(const HttpLocalServ&) = delete;
+    HttpLocalServ& operator=(const HttpLocalServ&) = delete;
+
+    // Move.
+    HttpLocalServ(HttpLocalServ&&) = delete;
+    HttpLocalServ& operator=(HttpLocalServ&&) = delete;
+
+    void doAccept(IoSocket&& sock, const Endpoint& ep, Time now);
+
   private:
     Reactor& reactor_;
     RestServ& restServ_;
@@ -16,8 +16,12 @@
  */
 #include "HttpSess.hpp"
 
+#include "HttpLatency.hpp"
+#include "RestChannel.hpp"
 #include "RestServ.hpp"
 
+#include <swirly/fin/Exception.hpp>
+
 namespace swirly {
 using namespace std;
 
@@ -26,18 +30,51 @@ namespace {
 constexpr auto IdleTimeout = 5s;
 enum { MaxData = 2048 };
 
+// Software receive and transmit timestamps. Transmit timestamps carry no payload, and are
+// identified by the stream offset of the last byte sent.
+constexpr unsigned TimestampFlags{SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE
+                                  | SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID
+                                  | SOF_TIMESTAMPING_OPT_TSONLY};
+
 } // namespace
 
-HttpSess::HttpSess(Reactor& r, IoSocket&& sock, const TcpEndpoint& ep, RestServ& rs, Time now)
+HttpSess::HttpSess(Reactor& r, IoSocket&& sock, const HttpEndpoint& ep, RestServ& rs,
+                   HttpLatency* latency, Time now)
+: BasicHttpParser<HttpSess>{HttpType::Request}
+, reactor_(r)
+, sock_{move(sock)}
+, ep_{ep}
+, restServ_{&rs}
+, lastActive_{now}
+, latency_{latency}
+{
+    SWIRLY_INFO << "accept session"sv;
+
+    if (latency_) {
+        sock_.setSoTimestamping(TimestampFlags);
+        errEvents_ = EventErr;
+    }
+    sub_ = r.subscribe(*sock_, EventIn | errEvents_, bind<&HttpSess::onIoEvent>(this));
+    tmr_ = r.timer(now + IdleTimeout, Priority::Low, bind<&HttpSess::onTimer>(this));
+}
+
+HttpSess::HttpSess(Reactor& r, IoSocket&& sock, const HttpEndpoint& ep, RestChannel& rc,
+                   HttpLatency* latency, Time now)
 : BasicHttpParser<HttpSess>{HttpType::Request}
 , reactor_(r)
 , sock_{move(sock)}
 , ep_{ep}
-, restServ_(rs)
+, restChannel_{&rc}
+, lastActive_{now}
+, latency_{latency}
 {
     SWIRLY_INFO << "accept session"sv;
 
-    sub_ = r.subscribe(*sock_, EventIn, bind<&HttpSess::onIoEvent>(this));
+    if (latency_) {
+        sock_.setSoTimestamping(TimestampFlags);
+        errEvents_ = EventErr;
+    }
+    sub_ = r.subscribe(*sock_, EventIn | errEvents_, bind<&HttpSess::onIoEvent>(this));
     tmr_ = r.timer(now + IdleTimeout, Priority::Low, bind<&HttpSess::onTimer>(this));
 }
 
@@ -46,11 +83,51 @@ HttpSess::~HttpSess()
     SWIRLY_INFO << "~HttpSess()"sv;
 }
 
+void HttpSess::onResponse(string_view data) noexcept
+{
+    --inflight_;
+    if (!sock_) {
+        // Closed while awaiting responses.
+        if (inflight_ == 0) {
+            delete this;
+        }
+        return;
+    }
+    try {
+        const auto wasEmpty = out_.empty();
+        out_.append(data);
+        if (latency_) {
+            const auto now = UnixClock::now();
+            latency_->recordEngine(now - posted_.front());
+            posted_.erase(posted_.begin());
+            queueResponse(data.size(), now);
+        }
+        ++returned_;
+        while (!rejected_.empty() && rejected_.front() == returned_) {
+            rejected_.erase(rejected_.begin());
+            reject();
+        }
+        if (wasEmpty) {
+            // May throw.
+            sub_.setEvents(EventIn | EventOut | errEvents_);
+        }
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR << "exception handling response: "sv << e.what();
+        close();
+    }
+}
+
 void HttpSess::close() noexcept
 {
     SWIRLY_INFO << "close session"sv;
     tmr_.cancel();
     sub_.reset();
+    if (inflight_ > 0) {
+        // The session is deleted once the outstanding responses have been returned, because
+        // they refer to it.
+        sock_.close();
+        return;
+    }
     delete this;
 }
 
@@ -101,6 +178,9 @@ bool HttpSess::onBody(string_view sv) noexcept
     bool ret{false};
     try {
         req_.appendBody(sv);
+        if (restChannel_) {
+            body_ += sv;
+        }
         ret = true;
     } catch (const std::exception& e) {
         SWIRLY_ERROR << "exception handling body: "sv << e.what();
@@ -115,30 +195,112 @@ bool HttpSess::onMessageEnd() noexcept
         --pending_;
         req_.flush(); // May throw.
 
-        const auto wasEmpty = buf_.empty();
-        restServ_.handleRequest(req_, os_);
-
-        if (wasEmpty) {
-            // May throw.
-            sub_.setEvents(EventIn | EventOut);
+        const auto start = latency_ ? endRequest() : Time{};
+        if (restServ_) {
+            const auto wasEmpty = out_.empty();
+            const auto size = out_.size();
+            restServ_->handleRequest(req_, os_);
+            if (latency_) {
+                const auto now = UnixClock::now();
+                latency_->recordEngine(now - start);
+                queueResponse(out_.size() - size, now);
+            }
+            if (wasEmpty) {
+                // May throw.
+                sub_.setEvents(EventIn | EventOut | errEvents_);
+            }
+            ret = true;
+        } else if (restChannel_->postRequest(reinterpret_cast<uintptr_t>(this), req_, body_)) {
+            ++inflight_;
+            if (latency_) {
+                posted_.push_back(start);
+            }
+            ret = true;
+        } else {
+            SWIRLY_WARNING << "request queue is full"sv;
+            if (inflight_ == 0) {
+                reject();
+            } else {
+                rejected_.push_back(returned_ + inflight_);
+            }
+            ret = true;
         }
-        ret = true;
     } catch (const std::exception& e) {
         SWIRLY_ERROR << "exception handling message: "sv << e.what();
     }
     req_.clear();
+    body_.clear();
     return ret;
 }
 
+void HttpSess::reject()
+{
+    const ServiceUnavailableException e{"request queue is full"sv};
+    const auto wasEmpty = out_.empty();
+    const auto size = out_.size();
+    os_.reset(e.httpStatus(), e.httpReason());
+    os_ << e;
+    os_.commit();
+    if (latency_) {
+        queueResponse(out_.size() - size, UnixClock::now());
+    }
+    if (wasEmpty) {
+        // May throw.
+        sub_.setEvents(EventIn | EventOut | errEvents_);
+    }
+}
+
+void HttpSess::beginRequest() noexcept
+{
+    req_.setRecvTime(recvTime_);
+    beginTime_ = readTime_;
+    if (!isZero(recvTime_)) {
+        latency_->recordKernel(readTime_ - recvTime_);
+    }
+}
+
+Time HttpSess::endRequest() noexcept
+{
+    const auto now = UnixClock::now();
+    latency_->recordParse(now - beginTime_);
+    return now;
+}
+
+void HttpSess::queueResponse(size_t size, Time now)
+{
+    // The offset wraps at 4GiB, like the kernel's.
+    outBytes_ += size;
+    sending_.emplace_back(outBytes_, now);
+}
+
+void HttpSess::onTxTimestamp(Time ts, uint32_t id) noexcept
+{
+    // The id is the offset of the last byte sent, so every response that ends at or before it has
+    // been sent in full.
+    auto it = sending_.begin();
+    for (; it != sending_.end() && static_cast<int32_t>(it->first - 1 - id) <= 0; ++it) {
+        latency_->recordSend(ts - it->second);
+    }
+    sending_.erase(sending_.begin(), it);
+}
+
 void HttpSess::onIoEvent(int fd, unsigned events, Time now)
 {
     try {
+        if (events & EventErr) {
+            Time ts;
+            uint32_t id;
+            while (sock_.recvTxTimestamp(ts, id)) {
+                onTxTimestamp(ts, id);
+            }
+        }
         if (events & EventOut) {
-            buf_.consume(os::write(fd, buf_.data()));
-            if (buf_.empty()) {
-                if (shouldKeepAlive()) {
+            out_.flush(fd);
+            if (out_.empty()) {
+                // Remain open for the responses to any pipelined requests.
+                if (shouldKeepAlive() || inflight_ > 0) {
                     // May throw.
-                    sub_.setEvents(EventIn);
+                    sub_.setEvents(EventIn | errEvents_);
                 } else {
                     close();
                 }
@@ -146,12 +308,17 @@ void HttpSess::onIoEvent(int fd, unsigned events, Time now)
         }
         if (events & EventIn) {
             char in[MaxData];
-            const auto size = os::read(fd, in, sizeof(in));
+            size_t size;
+            if (latency_) {
+                size = sock_.recv({in, sizeof(in)}, 0, recvTime_);
+                readTime_ = UnixClock::now();
+            } else {
+                size = os::read(fd, in, sizeof(in));
+            }
             if (size > 0) {
                 parse({in, size});
-                tmr_.cancel();
-                tmr_ = reactor_.timer(now + IdleTimeout, Priority::Low,
-                                      bind<&HttpSess::onTimer>(this));
+                // The idle timer is re-armed lazily when it fires.
+                lastActive_ = now;
             } else {
                 close();
             }
@@ -164,6 +331,12 @@ void HttpSess::onIoEvent(int fd, unsigned events, Time now)
 
 void HttpSess::onTimer(Timer& tmr, Time now)
 {
+    const auto expiry = lastActive_ + IdleTimeout;
+    if (now < expiry) {
+        // Active since the timer was armed, so defer until the idle deadline.
+        tmr_ = reactor_.timer(expiry, Priority::Low, bind<&HttpSess::onTimer>(this));
+        return;
+    }
     SWIRLY_INFO << "timeout"sv;
     close();
 }
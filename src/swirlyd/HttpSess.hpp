@@ -23,16 +23,28 @@
 
 #include <swirly/app/MemAlloc.hpp>
 
+#include <swirly/sys/LocalAcceptor.hpp>
 #include <swirly/sys/TcpAcceptor.hpp>
 
 #include <swirly/util/Log.hpp>
 
 #include <boost/intrusive/list.hpp>
 
+#include <string>
+#include <variant>
+#include <vector>
+
 namespace swirly {
 
+class HttpLatency;
+class RestChannel;
 class RestServ;
 
+/**
+ * Peer address of a TCP session, or listening path of a Unix domain session.
+ */
+using HttpEndpoint = std::variant<TcpEndpoint, LocalStreamEndpoint>;
+
 class SWIRLY_API HttpSess
 : public MemAlloc
 , BasicHttpParser<HttpSess> {
@@ -40,7 +52,17 @@ class SWIRLY_API HttpSess
     using AutoUnlinkOption = boost::intrusive::link_mode<boost::intrusive::auto_unlink>;
 
   public:
-    HttpSess(Reactor& r, IoSocket&& sock, const TcpEndpoint& ep, RestServ& rs, Time now);
+    /**
+     * If latency is not null, then kernel timestamping is enabled on the socket, and the latency of
+     * each request is recorded.
+     */
+    HttpSess(Reactor& r, IoSocket&& sock, const HttpEndpoint& ep, RestServ& rs,
+             HttpLatency* latency, Time now);
+    /**
+     * Forward requests to the engine thread over the channel, rather than handling them directly.
+     */
+    HttpSess(Reactor& r, IoSocket&& sock, const HttpEndpoint& ep, RestChannel& rc,
+             HttpLatency* latency, Time now);
     ~HttpSess();
 
     // Copy.
@@ -53,12 +75,20 @@ class SWIRLY_API HttpSess
 
     boost::intrusive::list_member_hook<AutoUnlinkOption> listHook;
 
+    /**
+     * Append a response returned by the engine thread for a forwarded request.
+     */
+    void onResponse(std::string_view data) noexcept;
+
   private:
     void close() noexcept;
 
     bool onMessageBegin() noexcept
     {
         ++pending_;
+        if (latency_) {
+            beginRequest();
+        }
         return true;
     }
     bool onUrl(std::string_view sv) noexcept;
@@ -75,26 +105,61 @@ class SWIRLY_API HttpSess
     bool onChunkHeader(size_t len) noexcept { return true; }
     bool onChunkEnd() noexcept { return true; }
 
+    /**
+     * Queue a 503 response to a request that could not be forwarded.
+     */
+    void reject();
+    void beginRequest() noexcept;
+    Time endRequest() noexcept;
+    void queueResponse(std::size_t size, Time now);
+    void onTxTimestamp(Time ts, std::uint32_t id) noexcept;
+
     void onIoEvent(int fd, unsigned events, Time now);
     void onTimer(Timer& tmr, Time now);
 
     LogMsg& logMsg() const noexcept
     {
         auto& ref = swirly::logMsg();
-        ref << '<' << ep_ << "> "sv;
+        std::visit([&ref](const auto& ep) { ref << '<' << ep << "> "sv; }, ep_);
         return ref;
     }
 
     Reactor& reactor_;
     IoSocket sock_;
-    TcpEndpoint ep_;
-    RestServ& restServ_;
+    HttpEndpoint ep_;
+    // Exactly one of these is set.
+    RestServ* restServ_{nullptr};
+    RestChannel* restChannel_{nullptr};
     Reactor::Handle sub_;
     Timer tmr_;
+    // Time of last input, which determines the idle deadline.
+    Time lastActive_;
     int pending_{0};
+    // Number of forwarded requests awaiting a response.
+    int inflight_{0};
+    // Number of responses returned by the engine thread.
+    std::uint64_t returned_{0};
+    // For each rejected request, the number of returned responses after which its 503 is queued.
+    std::vector<std::uint64_t> rejected_;
     HttpRequest req_;
-    Buffer buf_;
-    HttpStream os_{buf_};
+    // Raw body of the current request, which is forwarded along with the parsed request.
+    std::string body_;
+    HttpOutQueue out_;
+    HttpStream os_{out_};
+    // The remaining members are only used if timestamping is enabled.
+    HttpLatency* latency_{nullptr};
+    // Transmit timestamps are delivered through the error queue.
+    unsigned errEvents_{0};
+    // Kernel receive timestamp and completion time of the last read.
+    Time recvTime_{}, readTime_{};
+    // Completion time of the read in which the current request began.
+    Time beginTime_{};
+    // Total bytes queued for output, which is the stream offset used by transmit timestamps.
+    std::uint32_t outBytes_{0};
+    // Time that each request awaiting a response was posted to the engine thread.
+    std::vector<Time> posted_;
+    // End offset and queue time of each response awaiting its transmit timestamp.
+    std::vector<std::pair<std::uint32_t, Time>> sending_;
 };
 
 } // namespace swirly
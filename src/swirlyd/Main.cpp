@@ -15,6 +15,10 @@
  * 02110-1301, USA.
  */
 #include "HttpServ.hpp"
+#include "MdServ.hpp"
+#include "ReplClnt.hpp"
+#include "ReplServ.hpp"
+#include "RestChannel.hpp"
 #include "RestServ.hpp"
 
 #include <swirly/sqlite/Journ.hpp>
@@ -22,16 +26,21 @@
 
 #include <swirly/web/Rest.hpp>
 
+#include <swirly/lob/MemModel.hpp>
+
 #include <swirly/fin/Journ.hpp>
 #include <swirly/fin/Model.hpp>
 #include <swirly/fin/MsgQueue.hpp>
 
+#include <swirly/app/CompositeAgent.hpp>
 #include <swirly/app/MemCtx.hpp>
 #include <swirly/app/Thread.hpp>
 
 #include <swirly/sys/Daemon.hpp>
 #include <swirly/sys/EpollReactor.hpp>
+#include <swirly/sys/IoUringReactor.hpp>
 #include <swirly/sys/File.hpp>
+#include <swirly/sys/Memory.hpp>
 #include <swirly/sys/PidFile.hpp>
 #include <swirly/sys/Signal.hpp>
 #include <swirly/sys/System.hpp>
@@ -46,6 +55,8 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <optional>
+#include <vector>
 
 #include <fcntl.h> // open()
 #include <syslog.h>
@@ -58,6 +69,10 @@ using namespace swirly;
 
 namespace {
 
+// Bound on the messages journaled per cycle, so that replication and pruning are not starved by
+// the engine's message stream.
+enum { MaxBatch = 64 };
+
 void openLogFile(const char* path)
 {
     const auto file = os::open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
@@ -122,11 +137,203 @@ void getOpts(int argc, char* argv[], Opts& opts)
     }
 }
 
+constexpr auto PruneInterval = 1s;
+
+/**
+ * Agent that discards the messages retained in the journal for replication, except for the most
+ * recent, and any that the connected follower has yet to acknowledge.
+ */
+class JournPruner {
+  public:
+    /**
+     * @param retain Number of messages retained, or zero to retain all.
+     */
+    JournPruner(Journ& journ, size_t retain, const ReplServ* replServ = nullptr) noexcept
+    : journ_(journ)
+    , retain_{retain}
+    , replServ_{replServ}
+    {
+    }
+
+    int operator()()
+    {
+        const auto now = UnixClock::now();
+        if (retain_ == 0 || now - pruned_ < PruneInterval) {
+            return 0;
+        }
+        pruned_ = now;
+        const auto seq = journ_.seq();
+        if (seq <= retain_) {
+            return 0;
+        }
+        auto last = seq - retain_;
+        if (replServ_ && replServ_->synced()) {
+            last = min<uint64_t>(last, replServ_->ackSeq());
+        }
+        if (last <= truncated_) {
+            return 0;
+        }
+        journ_.truncate(last);
+        truncated_ = last;
+        return 1;
+    }
+
+  private:
+    Journ& journ_;
+    const size_t retain_;
+    const ReplServ* const replServ_;
+    uint64_t truncated_{0};
+    Time pruned_{};
+};
+
+/**
+ * Apply the leader's message stream to the journal until promoted by SIGUSR1.
+ *
+ * @return false if terminated before promotion.
+ */
+bool follow(const TcpEndpoint& ep, Journ& journ, size_t journRetain, const fs::path& logFile)
+{
+    ReplClnt replClnt{ep, journ};
+    bool promoted{false};
+    {
+        auto replAgent = [&replClnt]() { return replClnt.poll(UnixClock::now()); };
+        // The follower's journal is also retained for its own followers once promoted.
+        JournPruner journPruner{journ, journRetain};
+        CompositeAgent followAgent{replAgent, journPruner};
+        AgentThread replThread{followAgent, ThreadConfig{"repl"s}};
+
+        SWIRLY_NOTICE << "following leader at "sv << ep;
+
+        // Wait for promotion or termination.
+        SigWait sigWait;
+        while (const auto sig = sigWait()) {
+            switch (sig) {
+            case SIGHUP:
+                SWIRLY_INFO << "received SIGHUP"sv;
+                if (!logFile.empty()) {
+                    SWIRLY_NOTICE << "reopening log file: "sv << logFile;
+                    openLogFile(logFile.c_str());
+                }
+                continue;
+            case SIGINT:
+                SWIRLY_INFO << "received SIGINT"sv;
+                break;
+            case SIGTERM:
+                SWIRLY_INFO << "received SIGTERM"sv;
+                break;
+            case SIGUSR1:
+                SWIRLY_INFO << "received SIGUSR1"sv;
+                promoted = true;
+                break;
+            default:
+                SWIRLY_INFO << "received signal: "sv << sig;
+                continue;
+            }
+            break;
+        }
+    }
+    if (promoted) {
+        SWIRLY_NOTICE << "promoted to leader at seq "sv << replClnt.seq();
+    }
+    return promoted;
+}
+
+/**
+ * Load the engine state from the image saved at the last clean shutdown, if any.
+ *
+ * @return false if there is no usable image.
+ */
+bool loadImage(Rest& rest, const MemCtx& imageCtx, Time now)
+{
+    if (!imageCtx.warm() || !imageCtx.root()) {
+        return false;
+    }
+    optional<MemModel> model;
+    try {
+        model.emplace(imageCtx.root(), imageCtx.rootExtent());
+    } catch (const Exception& e) {
+        SWIRLY_WARNING << "ignoring image: "sv << e.what();
+        return false;
+    }
+    SWIRLY_NOTICE << "loading image saved at "sv << model->created();
+    rest.load(*model, now);
+    return true;
+}
+
+/**
+ * Returns the thread configuration from the keys prefixed with the thread's name.
+ */
+ThreadConfig threadConfig(const Config& config, const string& name)
+{
+    ThreadConfig tc{name};
+    tc.cpus = parseCpuList(config.get((name + "_cpus").c_str(), ""));
+    tc.priority = config.get((name + "_priority").c_str(), 0);
+    tc.numaNode = config.get((name + "_numa_node").c_str(), -1);
+    return tc;
+}
+
+unique_ptr<Reactor> makeReactor(string_view type)
+{
+    if (type == "io_uring"sv) {
+        return makeIoUringReactor(1024);
+    }
+    return make_unique<EpollReactor>(1024);
+}
+
+/**
+ * HTTP front-end, which accepts connections on its own SO_REUSEPORT listener, and forwards parsed
+ * requests to the engine thread.
+ */
+struct HttpFront {
+    HttpFront(string_view reactorType, const TcpEndpoint& ep, RestChannel& rc, bool timestamps,
+              Millis pollTimeout, ThreadConfig config)
+    : reactor{makeReactor(reactorType)}
+    , serv{*reactor, ep, rc, timestamps}
+    , thread{*reactor, serv, pollTimeout, config}
+    {
+    }
+    unique_ptr<Reactor> reactor;
+    HttpServ serv;
+    ReactorThread thread;
+};
+
 MemCtx memCtx;
 
+struct PutMemStats {
+    const MemCtx& memCtx;
+};
+
+ostream& operator<<(ostream& os, PutMemStats p)
+{
+    os << "mem: reserved "sv << (p.memCtx.reserved() >> 10) << "KiB of "sv
+       << (p.memCtx.maxSize() >> 10) << "KiB"sv;
+    for (size_t sc{0}; sc < MemCtx::SizeClasses; ++sc) {
+        const auto st = p.memCtx.stats(sc);
+        if (st.allocs > 0) {
+            os << ", "sv << MemCtx::blockSize(sc) << "B live "sv << st.live << " peak "sv
+               << st.highWater;
+        }
+    }
+    const auto st = p.memCtx.largeStats();
+    if (st.allocs > 0) {
+        os << ", large live "sv << st.live << " peak "sv << st.highWater;
+    }
+    if (const auto n = p.memCtx.overflows(); n > 0) {
+        os << ", heap overflows "sv << n;
+    }
+    return os;
+}
+
+void reportMem(Timer& tmr, Time now)
+{
+    SWIRLY_INFO << PutMemStats{memCtx};
+}
+
 } // namespace
 
 namespace swirly {
+// Replace the weak defaults, so that MemAlloc objects are allocated from the pool.
+inline namespace app {
 
 void* alloc(size_t size)
 {
@@ -143,6 +350,7 @@ void dealloc(void* ptr, size_t size) noexcept
     return memCtx.dealloc(ptr, size);
 }
 
+} // namespace app
 } // namespace swirly
 
 int main(int argc, char* argv[])
@@ -168,7 +376,13 @@ int main(int argc, char* argv[])
             config.read(is);
         }
 
-        memCtx = MemCtx{config.get<size_t>("mem_size", 1) << 20};
+        MemOpts memOpts;
+        memOpts.hugePages = config.get("mem_hugepages", false);
+        memOpts.prefault = config.get("mem_prefault", false);
+        memOpts.lock = config.get("mem_lock", false);
+        // An undersized pool degrades to the system heap, rather than failing requests.
+        memOpts.overflow = true;
+        memCtx = MemCtx{config.get<size_t>("mem_size", 64) << 20, memOpts};
 
         const auto logLevel = config.get("log_level", ""sv);
         if (!logLevel.empty()) {
@@ -248,9 +462,29 @@ int main(int argc, char* argv[])
             openLogFile(logFile.c_str());
         }
 
+        const fs::path imageFile{config.get("image_file", "")};
+        const auto imageSize = config.get<size_t>("image_size", 64);
+        const auto journRetain = config.get<size_t>("journ_retain", 1000000);
         const fs::path mqFile{config.get("mq_file", "")};
+        const char* const httpPath{config.get("http_path", "")};
         const char* const httpPort{config.get("http_port", "8080")};
+        const auto httpThreads = config.get<size_t>("http_threads", 0);
+        const auto httpQueueSize = config.get<size_t>("http_queue_size", 1024);
+        const auto httpTimestamps = config.get("http_timestamps", false);
+        const Millis pollTimeout{config.get("poll_timeout", 1)};
+        const string_view reactorType{config.get("reactor", "epoll")};
+        if (reactorType != "epoll"sv && reactorType != "io_uring"sv) {
+            throw Exception{errMsg() << "invalid reactor: "sv << reactorType};
+        }
         const auto maxExecs = config.get<size_t>("max_execs", 1 << 4);
+        const string mdGroup{config.get("md_group", "")};
+        const char* const mdIf{config.get("md_if", "")};
+        const auto mdLoop = config.get("md_loop", true);
+        const char* const mdPort{config.get("md_port", "")};
+        const auto mdTtl = config.get("md_ttl", 1);
+        const string replLeader{config.get("repl_leader", "")};
+        const char* const replPort{config.get("repl_port", "")};
+        const fs::path statsFile{config.get("stats_file", "")};
 
         SWIRLY_NOTICE << "initialising daemon"sv;
         SWIRLY_INFO << "conf_file:     "sv << opts.confFile;
@@ -258,69 +492,227 @@ int main(int argc, char* argv[])
         SWIRLY_INFO << "start_time:    "sv << opts.startTime;
 
         SWIRLY_INFO << "file_mode:     "sv << setfill('0') << setw(3) << oct << swirly::fileMode();
+        SWIRLY_INFO << "http_path:     "sv << httpPath;
         SWIRLY_INFO << "http_port:     "sv << httpPort;
+        SWIRLY_INFO << "http_queue_size: "sv << httpQueueSize << "KiB"sv;
+        SWIRLY_INFO << "http_threads:  "sv << httpThreads;
+        SWIRLY_INFO << "http_timestamps: "sv << (httpTimestamps ? "yes"sv : "no"sv);
+        SWIRLY_INFO << "image_file:    "sv << imageFile;
+        SWIRLY_INFO << "image_size:    "sv << imageSize << "MiB"sv;
+        SWIRLY_INFO << "journ_retain:  "sv << journRetain;
         SWIRLY_INFO << "log_file:      "sv << logFile;
         SWIRLY_INFO << "log_level:     "sv << getLogLevel();
         SWIRLY_INFO << "max_execs:     "sv << maxExecs;
+        SWIRLY_INFO << "md_group:      "sv << mdGroup;
+        SWIRLY_INFO << "md_if:         "sv << mdIf;
+        SWIRLY_INFO << "md_loop:       "sv << (mdLoop ? "yes"sv : "no"sv);
+        SWIRLY_INFO << "md_port:       "sv << mdPort;
+        SWIRLY_INFO << "md_ttl:        "sv << mdTtl;
+        const auto memInfo = memCtx.info();
         SWIRLY_INFO << "mem_size:      "sv << (memCtx.maxSize() >> 20) << "MiB"sv;
+        SWIRLY_INFO << "mem_hugepages: "sv
+                    << (memInfo.pageSize > PageSize
+                            ? "hugetlb"sv
+                            : memInfo.transparent ? "transparent"sv : "no"sv);
+        SWIRLY_INFO << "mem_prefault:  "sv << (memInfo.prefaulted ? "yes"sv : "no"sv);
+        SWIRLY_INFO << "mem_lock:      "sv << (memInfo.locked ? "yes"sv : "no"sv);
+        if (memOpts.lock && !memInfo.locked) {
+            SWIRLY_WARNING << "failed to lock memory pool: check RLIMIT_MEMLOCK"sv;
+        }
         SWIRLY_INFO << "mq_file:       "sv << mqFile;
         SWIRLY_INFO << "pid_file:      "sv << pidFile;
+        SWIRLY_INFO << "poll_timeout:  "sv << pollTimeout.count() << "ms"sv;
+        SWIRLY_INFO << "reactor:       "sv << reactorType;
+        SWIRLY_INFO << "repl_leader:   "sv << replLeader;
+        SWIRLY_INFO << "repl_port:     "sv << replPort;
         SWIRLY_INFO << "run_dir:       "sv << runDir;
+        SWIRLY_INFO << "stats_file:    "sv << statsFile;
 
+        // Capacity in bytes.
+        constexpr size_t MqCapacity{1 << 18};
+        // Any record in the queue can then be replicated.
+        static_assert(MqCapacity <= MaxReplMsg);
         MsgQueue mq;
         if (!mqFile.empty()) {
+            if (!fs::exists(mqFile)) {
+                createFrameQueue(mqFile.c_str(), MqCapacity, 0644);
+            }
             mq = MsgQueue{mqFile.c_str()};
         } else {
-            mq = MsgQueue{1 << 10};
+            mq = MsgQueue{MqCapacity};
+        }
+        SqlJourn journ{config};
+        if (!replLeader.empty()) {
+            // The model is loaded from the journal database once promoted.
+            if (!follow(parseEndpoint<Tcp>(replLeader), journ, journRetain, logFile)) {
+                return 0;
+            }
+        }
+        unique_ptr<MemCtx> imageCtx;
+        if (!imageFile.empty()) {
+            imageCtx = make_unique<MemCtx>(imageFile.c_str(), imageSize << 20);
         }
         Rest rest{mq, maxExecs};
-        {
+        // A follower's journal has moved on since the image was saved.
+        if (!imageCtx || !replLeader.empty() || !loadImage(rest, *imageCtx, opts.startTime)) {
             SqlModel model{config};
             rest.load(model, opts.startTime);
         }
-        RestServ restServ{rest};
-        SqlJourn journ{config};
+        RestServ restServ{rest, memCtx};
+
+        unique_ptr<MdServ> mdServ;
+        if (!mdGroup.empty()) {
+            if (*mdPort == '\0') {
+                throw Exception{errMsg() << "md_port is required with md_group"sv};
+            }
+            mdServ = make_unique<MdServ>(parseEndpoint<Udp>(mdGroup),
+                                         TcpEndpoint{Tcp::v4(), stou16(mdPort)}, mdIf, mdTtl,
+                                         mdLoop);
+            // Seed the snapshot with the books as loaded. The publisher thread has not started,
+            // so posting them would block once its queue was full.
+            for (const auto& market : rest.serv().markets()) {
+                mdServ->seed(market);
+            }
+            rest.setMarketSlot(bind<&MdServ::post>(mdServ.get()));
+            SWIRLY_NOTICE << "publishing market data to "sv << mdGroup
+                          << " with snapshots on port "sv << mdPort;
+        }
 
-        EpollReactor reactor{1024};
+        const auto reactorPtr = makeReactor(reactorType);
+        auto& reactor = *reactorPtr;
         const TcpEndpoint ep{Tcp::v4(), stou16(httpPort)};
-        HttpServ httpServ{reactor, ep, restServ};
+        // Without front-end threads, HTTP is served on the engine's reactor thread.
+        unique_ptr<HttpServ> httpServ;
+        vector<unique_ptr<RestChannel>> restChannels;
+        if (httpThreads == 0) {
+            httpServ = make_unique<HttpServ>(reactor, ep, restServ, httpTimestamps);
+        } else {
+            for (size_t i{0}; i < httpThreads; ++i) {
+                restChannels.push_back(make_unique<RestChannel>(httpQueueSize << 10));
+            }
+        }
+        unique_ptr<HttpLocalServ> httpLocalServ;
+        if (*httpPath != '\0') {
+            httpLocalServ
+                = make_unique<HttpLocalServ>(reactor, LocalStreamEndpoint{httpPath}, restServ);
+        }
+        vector<RestChannel*> restChannelPtrs;
+        for (const auto& rc : restChannels) {
+            restChannelPtrs.push_back(rc.get());
+        }
+        RestAgent restAgent{reactor, restServ, move(restChannelPtrs)};
+
+        unique_ptr<ReplServ> replServ;
+        if (*replPort != '\0') {
+            replServ = make_unique<ReplServ>(TcpEndpoint{Tcp::v4(), stou16(replPort)}, journ);
+            SWIRLY_NOTICE << "started replication server on port "sv << replPort;
+        }
 
-        ReactorThread reactorThread{reactor, ThreadConfig{"reactor"s}};
-        auto journAgent = [&mq, &journ]() {
+        // Report memory usage periodically to help size the pool.
+        auto memTmr
+            = reactor.timer(UnixClock::now() + 1min, 1min, Priority::Low, bind<&reportMem>());
+        // The engine's message stream is not fanned out: the journal is its only consumer, and
+        // messages are replicated from the journal thread only after they have been journaled.
+        // Market data is published from a separate queue of books.
+        auto journMsg = [&journ, replServ = replServ.get()](const Msg& msg) {
+            journ.write(msg);
+            if (replServ) {
+                replServ->send(msg);
+            }
+        };
+        auto journAgent = [&mq, &journMsg]() {
             int n{0};
-            Msg msg;
-            while (mq.pop(msg)) {
-                journ.write(msg);
+            while (n < MaxBatch && mq.fetch(journMsg)) {
                 ++n;
             }
             return n;
         };
-        AgentThread journThread{journAgent, ThreadConfig{"journ"s}};
+        auto replAgent = [replServ = replServ.get()]() {
+            return replServ ? replServ->poll(UnixClock::now()) : 0;
+        };
+        JournPruner journPruner{journ, journRetain, replServ.get()};
+        // Replication and pruning are low-rate, so they share the journal thread.
+        CompositeAgent journReplAgent{journAgent, replAgent, journPruner};
+        // Agent counters are published for external tools such as swirly-agent-stat.
+        AgentStatsBlock statsBlock;
+        if (!statsFile.empty()) {
+            if (!fs::exists(statsFile)) {
+                createAgentStatsBlock(statsFile.c_str(), 8, 0644);
+            }
+            statsBlock = AgentStatsBlock{statsFile.c_str()};
+        }
+        {
+            auto journConfig = threadConfig(config, "journ"s);
+            if (!statsFile.empty()) {
+                journConfig.stats = statsBlock.alloc(journConfig.name);
+            }
+            // The publisher is started before and stopped after the engine thread, which waits for
+            // it to drain its queue.
+            optional<AgentThread> mdThread;
+            auto mdAgent = [mdServ = mdServ.get()]() { return mdServ->poll(UnixClock::now()); };
+            if (mdServ) {
+                mdThread.emplace(mdAgent, threadConfig(config, "md"s));
+            }
+            // Front-ends are started first and stopped last, so that they are always available to
+            // drain responses from the engine thread.
+            vector<unique_ptr<HttpFront>> httpFronts;
+            for (size_t i{0}; i < httpThreads; ++i) {
+                auto httpConfig = threadConfig(config, "http"s);
+                httpConfig.name += to_string(i);
+                httpFronts.push_back(make_unique<HttpFront>(
+                    reactorType, ep, *restChannels[i], httpTimestamps, pollTimeout, httpConfig));
+            }
+            optional<ReactorThread> reactorThread;
+            if (httpThreads == 0) {
+                reactorThread.emplace(reactor, threadConfig(config, "reactor"s));
+            } else {
+                reactorThread.emplace(reactor, restAgent, pollTimeout,
+                                      threadConfig(config, "reactor"s));
+            }
+            AgentThread journThread{journReplAgent, journConfig};
 
-        SWIRLY_NOTICE << "started http server on port "sv << httpPort;
+            SWIRLY_NOTICE << "started http server on port "sv << httpPort;
+            if (httpLocalServ) {
+                SWIRLY_NOTICE << "started http server on path "sv << httpPath;
+            }
 
-        // Wait for termination.
-        SigWait sigWait;
-        while (const auto sig = sigWait()) {
-            switch (sig) {
-            case SIGHUP:
-                SWIRLY_INFO << "received SIGHUP"sv;
-                if (!logFile.empty()) {
-                    SWIRLY_NOTICE << "reopening log file: "sv << logFile;
-                    openLogFile(logFile.c_str());
+            // Wait for termination.
+            SigWait sigWait;
+            while (const auto sig = sigWait()) {
+                switch (sig) {
+                case SIGHUP:
+                    SWIRLY_INFO << "received SIGHUP"sv;
+                    if (!logFile.empty()) {
+                        SWIRLY_NOTICE << "reopening log file: "sv << logFile;
+                        openLogFile(logFile.c_str());
+                    }
+                    continue;
+                case SIGINT:
+                    SWIRLY_INFO << "received SIGINT"sv;
+                    break;
+                case SIGTERM:
+                    SWIRLY_INFO << "received SIGTERM"sv;
+                    break;
+                default:
+                    SWIRLY_INFO << "received signal: "sv << sig;
+                    continue;
                 }
-                continue;
-            case SIGINT:
-                SWIRLY_INFO << "received SIGINT"sv;
-                break;
-            case SIGTERM:
-                SWIRLY_INFO << "received SIGTERM"sv;
                 break;
-            default:
-                SWIRLY_INFO << "received signal: "sv << sig;
-                continue;
             }
-            break;
+        }
+        if (imageCtx) {
+            if (!threadFailed()) {
+                // The image must not be ahead of the journal, so drain the queue once the threads
+                // have stopped.
+                while (mq.fetch(journMsg)) {
+                }
+                imageCtx->persist(saveImage(rest.serv(), *imageCtx, UnixClock::now()));
+                SWIRLY_NOTICE << "saved image to "sv << imageFile;
+            } else {
+                // The model may be inconsistent after a thread failure, so leave the image unclean
+                // and recover from the database on the next start.
+                SWIRLY_WARNING << "image not saved after thread failure"sv;
+            }
         }
         ret = 0;
     } catch (const exception& e) {
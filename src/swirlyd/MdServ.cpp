@@ -0,0 +1,219 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MdServ.hpp"
+
+#include <swirly/fin/Market.hpp>
+
+#include <swirly/app/Backoff.hpp>
+#include <swirly/app/Thread.hpp>
+
+#include <swirly/util/Log.hpp>
+
+#include <algorithm>
+
+namespace swirly {
+using namespace std;
+
+namespace {
+
+// The publisher thread does not back off, so avoid a system call on every cycle.
+constexpr auto AcceptInterval = 10ms;
+enum { MaxBatch = 64, QueueCapacity = 1 << 12 };
+// Bound on the wait for queue space, which is in the order of milliseconds.
+enum { MaxSpins = 1 << 16 };
+
+} // namespace
+
+MdServ::MdServ(const UdpEndpoint& group, const TcpEndpoint& ep, const char* ifname, int ttl,
+               bool loop)
+: queue_{QueueCapacity}
+// The publisher must see every book, so it applies backpressure to the engine.
+, consumer_{queue_.attach(true)}
+, sock_{group.protocol()}
+, group_{group}
+, out_{MaxBatch, MaxMdUpdate}
+, serv_{ep.protocol()}
+{
+    if (ifname && *ifname != '\0') {
+        sock_.setIpMcastIf(ifname);
+    }
+    sock_.setIpMcastTtl(ttl);
+    sock_.setIpMcastLoop(loop);
+    sock_.setNonBlock();
+
+    serv_.setSoReuseAddr(true);
+    serv_.bind(ep);
+    serv_.listen(SOMAXCONN);
+    serv_.setNonBlock();
+}
+
+MdServ::~MdServ() = default;
+
+void MdServ::seed(const Market& market)
+{
+    // Consumers start from a snapshot, so the books as loaded need not be published.
+    toMdBook(market, books_[market.id()]);
+}
+
+void MdServ::post(const Market& market, Time now)
+{
+    // Books deferred by an earlier post are retried first, without waiting.
+    while (!deferred_.empty() && postBook(*deferred_.back())) {
+        deferred_.pop_back();
+    }
+    if (deferred_.empty()) {
+        // Every change should be published, so wait briefly for the publisher to drain its queue,
+        // unless it has stopped.
+        for (int i{0}; i < MaxSpins && !threadFailed(); ++i) {
+            if (postBook(market)) {
+                return;
+            }
+            cpuRelax();
+        }
+        SWIRLY_WARNING << "market-data queue full: deferring books"sv;
+    }
+    if (find(deferred_.begin(), deferred_.end(), &market) == deferred_.end()) {
+        deferred_.push_back(&market);
+    }
+}
+
+int MdServ::poll(Time now)
+{
+    int n{0};
+    MdBook book;
+    while (queue_.pop(consumer_, book)) {
+        publish(book);
+        ++n;
+    }
+    if (!out_.empty()) {
+        send();
+    }
+    if (now - polled_ >= AcceptInterval) {
+        polled_ = now;
+        if (accept(now)) {
+            ++n;
+        }
+    }
+    for (auto it = snaps_.begin(); it != snaps_.end();) {
+        if (flush(*it)) {
+            ++n;
+        }
+        if (!it->sock || it->out.empty()) {
+            it = snaps_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return n;
+}
+
+bool MdServ::postBook(const Market& market) noexcept
+{
+    return queue_.post([&market](MdBook& book) noexcept { toMdBook(market, book); });
+}
+
+void MdServ::publish(const MdBook& next)
+{
+    auto [it, inserted] = books_.try_emplace(Id64{next.marketId});
+    auto& prev = it->second;
+    if (inserted) {
+        memset(&prev, 0, sizeof(prev));
+    }
+
+    if (out_.full()) {
+        send();
+    }
+    auto* const hdr = buffer_cast<MdHeader*>(out_.prepare());
+    auto* const top = reinterpret_cast<MdTop*>(hdr + 1);
+    auto* const deltas = reinterpret_cast<MdDelta*>(top + 1);
+
+    const auto count = diffMdBooks(prev, next, deltas);
+    if (count == 0 && !inserted && prev.state == next.state && prev.lastTime == next.lastTime) {
+        // Nothing visible has changed, such as a revision beyond the published depth.
+        return;
+    }
+    hdr->seq = ++seq_;
+    hdr->type = MdType::Update;
+    hdr->count = count;
+    *top = toMdTop(next);
+    prev = next;
+
+    out_.commit(sizeof(MdHeader) + sizeof(MdTop) + count * sizeof(MdDelta), group_);
+}
+
+void MdServ::send()
+{
+    // Updates drained from the queue in the same cycle are sent with a single system call.
+    while (!out_.empty()) {
+        error_code ec;
+        sock_.sendmmsg(out_, 0, ec);
+        if (ec) {
+            // Consumers recover from the gap with a snapshot.
+            SWIRLY_WARNING << "market-data send failed with "sv << out_.size()
+                           << " updates pending at seq "sv << seq_ << ": "sv << ec.message();
+            out_.clear();
+        }
+    }
+}
+
+bool MdServ::accept(Time now)
+{
+    error_code ec;
+    TcpEndpoint ep;
+    auto sock = serv_.accept(ep, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            // Such as ECONNABORTED or EMFILE, neither of which should stop the publisher.
+            SWIRLY_WARNING << "market-data snapshot accept failed: "sv << ec.message();
+        }
+        return false;
+    }
+    SWIRLY_INFO << "sending market-data snapshot at seq "sv << seq_ << " to "sv << ep;
+    sock.setNonBlock();
+
+    Snapshot snap{move(sock), {}};
+    const auto len = sizeof(MdHeader) + books_.size() * sizeof(MdBook);
+    auto buf = snap.out.prepare(len);
+    auto* const hdr = buffer_cast<MdHeader*>(buf);
+    hdr->seq = seq_;
+    hdr->type = MdType::Snapshot;
+    hdr->count = books_.size();
+    auto* book = reinterpret_cast<MdBook*>(hdr + 1);
+    for (const auto& [id, value] : books_) {
+        memcpy(book++, &value, sizeof(value));
+    }
+    snap.out.commit(len);
+    snaps_.push_back(move(snap));
+    return true;
+}
+
+bool MdServ::flush(Snapshot& snap)
+{
+    error_code ec;
+    const auto size = snap.sock.send(snap.out.data(), MSG_NOSIGNAL, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            SWIRLY_WARNING << "market-data snapshot send failed: "sv << ec.message();
+            snap.sock.close();
+        }
+        return false;
+    }
+    snap.out.consume(size);
+    return true;
+}
+
+} // namespace swirly
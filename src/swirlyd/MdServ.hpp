@@ -0,0 +1,124 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_MDSERV_HPP
+#define SWIRLYD_MDSERV_HPP
+
+#include <swirly/lob/MarketData.hpp>
+
+#include <swirly/app/BroadcastQueue.hpp>
+
+#include <swirly/sys/Buffer.hpp>
+#include <swirly/sys/TcpSocket.hpp>
+#include <swirly/sys/UdpSocket.hpp>
+
+#include <swirly/util/Time.hpp>
+
+#include <map>
+#include <vector>
+
+namespace swirly {
+inline namespace fin {
+class Market;
+} // namespace fin
+
+/**
+ * Market-data publisher.
+ *
+ * The engine thread posts the book of each market that changes. The publisher diffs each book
+ * against the last that it published, and multicasts a sequenced update comprising the top of
+ * book and the depth levels that have changed. The cost of publishing is therefore independent of
+ * the number of consumers.
+ *
+ * Consumers that detect a gap in the sequence recover by connecting to the snapshot port, which
+ * sends the full book of every market, tagged with the sequence number of the last update that it
+ * includes, and then closes the connection.
+ */
+class SWIRLY_API MdServ {
+  public:
+    /**
+     * @param group Multicast group and port.
+     * @param ep Snapshot endpoint.
+     * @param ifname Outgoing multicast interface, or null for the default.
+     */
+    MdServ(const UdpEndpoint& group, const TcpEndpoint& ep, const char* ifname, int ttl,
+           bool loop);
+    ~MdServ();
+
+    // Copy.
+    MdServ(const MdServ&) = delete;
+    MdServ& operator=(const MdServ&) = delete;
+
+    // Move.
+    MdServ(MdServ&&) = delete;
+    MdServ& operator=(MdServ&&) = delete;
+
+    void getSockName(TcpEndpoint& ep) { serv_.getSockName(ep); }
+    /**
+     * Returns the sequence number of the last update sent.
+     */
+    std::uint64_t seq() const noexcept { return seq_; }
+
+    /**
+     * Add the market's book to the snapshot without publishing an update. Must be called before
+     * the publisher thread starts.
+     */
+    void seed(const Market& market);
+    /**
+     * Post the market's book to the publisher. Must be called from the engine thread.
+     *
+     * The engine waits a bounded time for the publisher to drain its queue. If the queue is still
+     * full, the market is deferred, and its current book is posted on a later call. Each post
+     * carries the whole book, so a deferred book is superseded rather than lost.
+     */
+    void post(const Market& market, Time now);
+    /**
+     * Publish posted books and serve snapshots. Must be called from the publisher thread.
+     *
+     * @return the amount of work done.
+     */
+    int poll(Time now);
+
+  private:
+    struct Snapshot {
+        IoSocket sock;
+        Buffer out;
+    };
+    bool postBook(const Market& market) noexcept;
+    void publish(const MdBook& next);
+    void send();
+    bool accept(Time now);
+    bool flush(Snapshot& snap);
+
+    BroadcastQueue<MdBook> queue_;
+    // Markets whose books could not be posted, which are owned by the engine thread.
+    std::vector<const Market*> deferred_;
+    const std::size_t consumer_;
+    UdpSocket sock_;
+    const UdpEndpoint group_;
+    // Updates pending send.
+    UdpMsgVec out_;
+    TcpSocketServ serv_;
+    // Last published book of each market, ordered by market id.
+    std::map<Id64, MdBook> books_;
+    std::vector<Snapshot> snaps_;
+    std::uint64_t seq_{0};
+    Time polled_{};
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_MDSERV_HPP
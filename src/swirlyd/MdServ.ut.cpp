@@ -0,0 +1,156 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "MdServ.hpp"
+
+#include <swirly/fin/Market.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <thread>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+// Returns the size of the next update, or zero if none arrives in time.
+size_t recvUpdate(UdpSocket& sock, char* buf, size_t size)
+{
+    for (int i{0}; i < 1000; ++i) {
+        error_code ec;
+        UdpEndpoint ep;
+        const auto n = sock.recvfrom(buf, size, MSG_DONTWAIT, ep, ec);
+        if (!ec) {
+            return n;
+        }
+        this_thread::sleep_for(1ms);
+    }
+    return 0;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MdServSuite)
+
+BOOST_AUTO_TEST_CASE(MdServLoopbackCase)
+{
+    // The group is joined on the loopback interface, so nothing leaves the host.
+    UdpSocket recv{Udp::v4()};
+    recv.setSoReuseAddr(true);
+    const auto ep = parseEndpoint<Udp>("239.255.77.1:0");
+    recv.bind(ep);
+    recv.joinGroup(ep.address(), "lo");
+    UdpEndpoint group;
+    recv.getSockName(group);
+
+    MdServ serv{group, parseEndpoint<Tcp>("127.0.0.1:0"), "lo", 0, true};
+    TcpEndpoint snapEp;
+    serv.getSockName(snapEp);
+
+    // Seeded books are included in snapshots, but are not published.
+    Market eurusd{1_id64, "EURUSD"sv, 0_jd, 0x01};
+    serv.seed(eurusd);
+
+    Market gbpusd{2_id64, "GBPUSD"sv, 0_jd, 0x02};
+    auto now = UnixClock::now();
+    serv.post(gbpusd, now);
+    BOOST_TEST(serv.poll(now) > 0);
+    BOOST_TEST(serv.seq() == 1U);
+
+    // Fields are packed, so they are compared in parentheses, rather than bound by reference.
+    char buf[MaxMdUpdate];
+    const auto size = recvUpdate(recv, buf, sizeof(buf));
+    BOOST_TEST_REQUIRE(size >= sizeof(MdHeader) + sizeof(MdTop));
+    MdHeader hdr;
+    MdTop top;
+    memcpy(&hdr, buf, sizeof(hdr));
+    memcpy(&top, buf + sizeof(hdr), sizeof(top));
+    BOOST_TEST((hdr.seq == 1U));
+    BOOST_TEST((hdr.type == MdType::Update));
+    BOOST_TEST(top.marketId == 2_id64);
+    BOOST_TEST((top.state == 0x02U));
+
+    // A snapshot is sent to each connection, which is then closed.
+    TcpSocketClnt clnt{snapEp.protocol()};
+    clnt.connect(snapEp);
+    for (int i{1}; i <= 10; ++i) {
+        serv.poll(now + i * 10ms);
+    }
+    Buffer snap;
+    for (;;) {
+        const auto n = clnt.recv(snap.prepare(64 << 10), 0);
+        if (n == 0) {
+            break;
+        }
+        snap.commit(n);
+    }
+    BOOST_TEST_REQUIRE(snap.size() == sizeof(MdHeader) + 2 * sizeof(MdBook));
+    const auto* data = buffer_cast<const char*>(snap.data());
+    memcpy(&hdr, data, sizeof(hdr));
+    BOOST_TEST((hdr.seq == 1U));
+    BOOST_TEST((hdr.type == MdType::Snapshot));
+    BOOST_TEST((hdr.count == 2U));
+    MdBook book;
+    memcpy(&book, data + sizeof(hdr), sizeof(book));
+    BOOST_TEST(book.marketId == 1_id64);
+    BOOST_TEST((book.state == 0x01U));
+    memcpy(&book, data + sizeof(hdr) + sizeof(book), sizeof(book));
+    BOOST_TEST(book.marketId == 2_id64);
+}
+
+BOOST_AUTO_TEST_CASE(MdServDeferCase)
+{
+    UdpSocket recv{Udp::v4()};
+    recv.setSoReuseAddr(true);
+    const auto ep = parseEndpoint<Udp>("239.255.77.2:0");
+    recv.bind(ep);
+    recv.joinGroup(ep.address(), "lo");
+    UdpEndpoint group;
+    recv.getSockName(group);
+
+    MdServ serv{group, parseEndpoint<Tcp>("127.0.0.1:0"), "lo", 0, true};
+
+    // Fill the queue without polling.
+    Market eurusd{1_id64, "EURUSD"sv, 0_jd, 0x01};
+    auto now = UnixClock::now();
+    for (int i{0}; i < 1 << 12; ++i) {
+        serv.post(eurusd, now);
+    }
+    // The wait is bounded, so the book is deferred rather than blocking the engine.
+    Market gbpusd{2_id64, "GBPUSD"sv, 0_jd, 0x02};
+    serv.post(gbpusd, now);
+
+    // Identical books are published once.
+    BOOST_TEST(serv.poll(now) > 0);
+    BOOST_TEST(serv.seq() == 1U);
+
+    // The deferred book is posted ahead of the next.
+    serv.post(eurusd, now);
+    BOOST_TEST(serv.poll(now) > 0);
+    BOOST_TEST(serv.seq() == 2U);
+
+    char buf[MaxMdUpdate];
+    BOOST_TEST(recvUpdate(recv, buf, sizeof(buf)) > 0U);
+    const auto size = recvUpdate(recv, buf, sizeof(buf));
+    BOOST_TEST_REQUIRE(size >= sizeof(MdHeader) + sizeof(MdTop));
+    MdTop top;
+    memcpy(&top, buf + sizeof(MdHeader), sizeof(top));
+    BOOST_TEST(top.marketId == 2_id64);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,51 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_REPL_HPP
+#define SWIRLYD_REPL_HPP
+
+#include <swirly/Config.h>
+
+#include <cstdint>
+
+namespace swirly {
+
+/**
+ * Replication frame header. Each header is followed by an encoded message of the specified size.
+ * Sequence numbers are contiguous and start from one.
+ */
+struct SWIRLY_PACKED ReplHeader {
+    std::uint64_t seq;
+    std::uint32_t size;
+};
+
+/**
+ * Maximum size of a replicated message. This exceeds the largest record that the engine's message
+ * queue can hold, and bounds the follower's receive buffer.
+ */
+enum : std::uint32_t { MaxReplMsg = 1 << 20 };
+
+/**
+ * Acknowledgement sent by the follower with the last sequence number applied to its journal. The
+ * first acknowledgement on a connection identifies the follower's starting position.
+ */
+struct SWIRLY_PACKED ReplAck {
+    std::uint64_t seq;
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_REPL_HPP
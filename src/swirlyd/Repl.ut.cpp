@@ -0,0 +1,256 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "ReplClnt.hpp"
+#include "ReplServ.hpp"
+
+#include <swirly/fin/Journ.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+class MemJourn : public Journ {
+  public:
+    MemJourn() = default;
+    ~MemJourn() override = default;
+
+    const vector<string>& msgs() const noexcept { return msgs_; }
+
+  protected:
+    uint64_t doSeq() const noexcept override { return msgs_.size(); }
+
+    size_t doRead(uint64_t seq, void* buf, size_t size) override
+    {
+        if (seq < first_ || seq > msgs_.size()) {
+            return 0;
+        }
+        const auto& msg = msgs_[seq - 1];
+        if (msg.size() <= size) {
+            memcpy(buf, msg.data(), msg.size());
+        }
+        return msg.size();
+    }
+
+    void doWrite(const Msg& msg) override
+    {
+        msgs_.emplace_back(reinterpret_cast<const char*>(&msg), msgSize(msg));
+    }
+
+    void doTruncate(uint64_t seq) override
+    {
+        // As if deleted from the journal table.
+        if (!msgs_.empty()) {
+            first_ = max(first_, min<uint64_t>(seq, msgs_.size() - 1) + 1);
+        }
+    }
+
+  private:
+    vector<string> msgs_;
+    uint64_t first_{1};
+};
+
+Msg updateMarket(int64_t id)
+{
+    Msg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.type = MsgType::UpdateMarket;
+    msg.updateMarket.id = Id64{id};
+    msg.updateMarket.state = 1;
+    return msg;
+}
+
+void writeArchive(MemJourn& journ, ReplServ& serv, size_t count)
+{
+    vector<char> buf(msgSize(MsgType::ArchiveTrade, count));
+    auto& msg = *reinterpret_cast<Msg*>(buf.data());
+    msg.type = MsgType::ArchiveTrade;
+    msg.archiveTrade.marketId = 1_id64;
+    msg.archiveTrade.modified = 0;
+    msg.archiveTrade.count = count;
+    for (size_t i{0}; i < count; ++i) {
+        msg.archiveTrade.ids[i] = Id64(i + 1);
+    }
+    journ.write(msg);
+    serv.send(msg);
+}
+
+void write(MemJourn& journ, int64_t first, int64_t last)
+{
+    for (auto id = first; id <= last; ++id) {
+        journ.write(updateMarket(id));
+    }
+}
+
+void write(MemJourn& journ, ReplServ& serv, int64_t first, int64_t last)
+{
+    for (auto id = first; id <= last; ++id) {
+        const auto msg = updateMarket(id);
+        journ.write(msg);
+        serv.send(msg);
+    }
+}
+
+template <typename FnT>
+bool pollUntil(ReplServ& serv, ReplClnt& clnt, FnT pred, int max = 3000)
+{
+    for (int i{0}; i < max; ++i) {
+        const auto now = UnixClock::now();
+        serv.poll(now);
+        clnt.poll(now);
+        if (pred()) {
+            return true;
+        }
+        this_thread::sleep_for(1ms);
+    }
+    return false;
+}
+
+TcpEndpoint loopback()
+{
+    return parseEndpoint<Tcp>("127.0.0.1:0");
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ReplSuite)
+
+BOOST_AUTO_TEST_CASE(ReplRoundTripCase)
+{
+    MemJourn leader, follower;
+    // Journaled before the follower connects.
+    write(leader, 1, 3);
+
+    ReplServ serv{loopback(), leader};
+    TcpEndpoint ep;
+    serv.getSockName(ep);
+    ReplClnt clnt{ep, follower};
+
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 3; }));
+    BOOST_TEST(serv.synced());
+
+    write(leader, serv, 4, 5);
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 5 && serv.lag() == 0; }));
+    BOOST_TEST(follower.msgs() == leader.msgs());
+}
+
+BOOST_AUTO_TEST_CASE(ReplResumeCase)
+{
+    MemJourn leader, follower;
+    write(leader, 1, 4);
+    // The follower's database is a copy of the leader's at seq 2.
+    write(follower, 1, 2);
+
+    TcpEndpoint ep;
+    {
+        ReplServ serv{loopback(), leader};
+        serv.getSockName(ep);
+        ReplClnt clnt{ep, follower};
+        BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 4; }));
+    }
+    ReplClnt clnt{ep, follower};
+    {
+        unique_ptr<ReplServ> serv{make_unique<ReplServ>(ep, leader)};
+        BOOST_TEST(pollUntil(*serv, clnt, [&]() { return serv->synced(); }));
+
+        // The leader restarts, and journals while the follower is disconnected.
+        serv.reset();
+        write(leader, 5, 6);
+        serv = make_unique<ReplServ>(ep, leader);
+
+        BOOST_TEST(pollUntil(*serv, clnt, [&]() { return clnt.seq() == 6; }));
+        write(leader, *serv, 7, 7);
+        BOOST_TEST(pollUntil(*serv, clnt, [&]() { return clnt.seq() == 7; }));
+    }
+    BOOST_TEST(follower.msgs() == leader.msgs());
+}
+
+BOOST_AUTO_TEST_CASE(ReplGapCase)
+{
+    MemJourn leader, follower;
+    write(leader, 1, 3);
+
+    ReplServ serv{loopback(), leader};
+    TcpEndpoint ep;
+    serv.getSockName(ep);
+    ReplClnt clnt{ep, follower};
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 3; }));
+
+    // The follower's journal is written behind the replication stream.
+    write(follower, 4, 4);
+    write(leader, serv, 4, 5);
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.closed(); }));
+
+    // The follower reconnects, and resumes from its own position.
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 5 && serv.lag() == 0; }));
+    BOOST_TEST(!clnt.closed());
+}
+
+BOOST_AUTO_TEST_CASE(ReplLargeCase)
+{
+    MemJourn leader, follower;
+
+    ReplServ serv{loopback(), leader};
+    TcpEndpoint ep;
+    serv.getSockName(ep);
+    ReplClnt clnt{ep, follower};
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return serv.synced(); }));
+
+    // Larger than the follower's buffer before the limit was introduced.
+    writeArchive(leader, serv, 1 << 15);
+    BOOST_TEST(pollUntil(serv, clnt, [&]() { return clnt.seq() == 1; }));
+    BOOST_TEST(follower.msgs() == leader.msgs());
+
+    // Beyond the limit, the leader refuses to replicate the message.
+    writeArchive(leader, serv, MaxReplMsg / sizeof(Id64));
+    BOOST_TEST(!serv.synced());
+    BOOST_TEST(!pollUntil(serv, clnt, [&]() { return clnt.seq() > 1; }, 300));
+}
+
+BOOST_AUTO_TEST_CASE(ReplRejectCase)
+{
+    MemJourn leader, ahead, behind;
+    write(leader, 1, 3);
+    write(ahead, 1, 4);
+    // Messages that the follower needs are no longer retained.
+    leader.truncate(1);
+
+    ReplServ serv{loopback(), leader};
+    TcpEndpoint ep;
+    serv.getSockName(ep);
+    {
+        ReplClnt clnt{ep, ahead};
+        BOOST_TEST(!pollUntil(serv, clnt, [&]() { return serv.synced(); }, 300));
+        BOOST_TEST(clnt.seq() == 4U);
+    }
+    {
+        ReplClnt clnt{ep, behind};
+        BOOST_TEST(!pollUntil(serv, clnt, [&]() { return clnt.seq() > 0; }, 300));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,168 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "ReplClnt.hpp"
+
+#include <swirly/fin/Journ.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/util/Log.hpp>
+
+namespace swirly {
+using namespace std;
+
+namespace {
+
+constexpr auto ReconnectInterval = 1s;
+constexpr auto ReportInterval = 10s;
+// Room for a complete frame of the maximum size, in addition to a partially received frame.
+constexpr size_t BufSize{2 * (sizeof(ReplHeader) + MaxReplMsg)};
+
+} // namespace
+
+ReplClnt::ReplClnt(const TcpEndpoint& ep, Journ& journ)
+: ep_{ep}
+, journ_(journ)
+, buf_{BufSize}
+{
+    connect();
+}
+
+ReplClnt::~ReplClnt() = default;
+
+uint64_t ReplClnt::seq() const noexcept
+{
+    return journ_.seq();
+}
+
+int ReplClnt::poll(Time now)
+{
+    if (!sock_) {
+        if (now - closed_ >= ReconnectInterval) {
+            closed_ = now;
+            connect();
+        }
+        return 0;
+    }
+    error_code ec;
+    const auto size = sock_.recv(buf_.prepare(buf_.available()), 0, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            SWIRLY_ERROR << "replication recv failed: "sv << ec.message();
+            close();
+            closed_ = now;
+            return 0;
+        }
+    } else if (size == 0) {
+        SWIRLY_WARNING << "leader disconnected at seq "sv << seq();
+        close();
+        closed_ = now;
+        return 0;
+    } else {
+        buf_.commit(size);
+    }
+
+    int n{0};
+    while (buf_.size() >= sizeof(ReplHeader)) {
+        const auto* const hdr = buffer_cast<const ReplHeader*>(buf_.data());
+        if (hdr->size > MaxReplMsg) {
+            // Otherwise the buffer would fill before the frame was complete.
+            SWIRLY_ERROR << "replication frame of "sv << hdr->size << " bytes at seq "sv
+                         << hdr->seq << " exceeds limit of "sv << MaxReplMsg << " bytes"sv;
+            close();
+            closed_ = now;
+            return n;
+        }
+        const auto len = sizeof(ReplHeader) + hdr->size;
+        if (buf_.size() < len) {
+            break;
+        }
+        if (hdr->seq != seq() + 1) {
+            // Reconnect, so that the leader resumes from the journal's sequence number.
+            SWIRLY_WARNING << "replication sequence gap: expected seq "sv << seq() + 1
+                           << ", received seq "sv << hdr->seq;
+            close();
+            closed_ = now;
+            return n;
+        }
+        // The journal persists the sequence number with the message.
+        journ_.write(*reinterpret_cast<const Msg*>(hdr + 1));
+        buf_.consume(len);
+        ++n;
+    }
+    // Acknowledgements are cumulative, so a new one is started only when the last has been sent in
+    // full.
+    if (ackSent_ == sizeof(ReplAck) && ack_.seq != seq()) {
+        ack_.seq = seq();
+        ackSent_ = 0;
+    }
+    flush();
+    if (now - reported_ >= ReportInterval) {
+        SWIRLY_INFO << "replicated seq: "sv << seq();
+        reported_ = now;
+    }
+    return n;
+}
+
+void ReplClnt::connect()
+{
+    error_code ec;
+    TcpSocketClnt sock{ep_.protocol(), ec};
+    if (!ec) {
+        sock.connect(ep_, ec);
+    }
+    if (ec) {
+        SWIRLY_WARNING << "failed to connect to leader at "sv << ep_ << ": "sv << ec.message();
+        return;
+    }
+    SWIRLY_NOTICE << "connected to leader at seq "sv << seq();
+    sock.setTcpNoDelay(true);
+    sock.setNonBlock();
+    sock_ = move(sock);
+    // Identify the starting position before any messages are applied.
+    ack_.seq = seq();
+    ackSent_ = 0;
+    flush();
+}
+
+bool ReplClnt::flush()
+{
+    if (ackSent_ == sizeof(ReplAck)) {
+        return false;
+    }
+    error_code ec;
+    const auto* const data = reinterpret_cast<const char*>(&ack_);
+    const auto size = sock_.send(data + ackSent_, sizeof(ReplAck) - ackSent_, MSG_NOSIGNAL, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            SWIRLY_ERROR << "replication send failed: "sv << ec.message();
+            close();
+        }
+        return false;
+    }
+    // The remainder of a partial write is sent on the next cycle.
+    ackSent_ += size;
+    return true;
+}
+
+void ReplClnt::close() noexcept
+{
+    sock_.close();
+    buf_.clear();
+    ackSent_ = sizeof(ReplAck);
+}
+
+} // namespace swirly
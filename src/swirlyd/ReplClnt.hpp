@@ -0,0 +1,88 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_REPLCLNT_HPP
+#define SWIRLYD_REPLCLNT_HPP
+
+#include "Repl.hpp"
+
+#include <swirly/sys/MirrorBuffer.hpp>
+#include <swirly/sys/TcpSocket.hpp>
+
+#include <swirly/util/Time.hpp>
+
+namespace swirly {
+inline namespace fin {
+class Journ;
+} // namespace fin
+
+/**
+ * Follower side of the replication stream.
+ *
+ * Applies the leader's sequenced messages to the local journal, so that the follower's database
+ * tracks the leader's. The follower resumes from the sequence number of its journal, and reconnects
+ * if the connection to the leader is lost. The follower is promoted by loading its model from that
+ * database.
+ */
+class SWIRLY_API ReplClnt {
+  public:
+    ReplClnt(const TcpEndpoint& ep, Journ& journ);
+    ~ReplClnt();
+
+    // Copy.
+    ReplClnt(const ReplClnt&) = delete;
+    ReplClnt& operator=(const ReplClnt&) = delete;
+
+    // Move.
+    ReplClnt(ReplClnt&&) = delete;
+    ReplClnt& operator=(ReplClnt&&) = delete;
+
+    /**
+     * Returns true if the connection to the leader has been closed.
+     */
+    bool closed() const noexcept { return !sock_; }
+    /**
+     * Returns the sequence number of the last message applied.
+     */
+    std::uint64_t seq() const noexcept;
+
+    /**
+     * Apply messages received from the leader, and reconnect if disconnected.
+     *
+     * @return the number of messages applied.
+     */
+    int poll(Time now);
+
+  private:
+    void connect();
+    bool flush();
+    void close() noexcept;
+
+    const TcpEndpoint ep_;
+    Journ& journ_;
+    TcpSocketClnt sock_;
+    MirrorBuffer buf_;
+    // Acknowledgement being sent, and the number of its bytes that have been sent.
+    ReplAck ack_{};
+    std::size_t ackSent_{sizeof(ReplAck)};
+    // Time of the last disconnection or connection attempt.
+    Time closed_{};
+    Time reported_{};
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_REPLCLNT_HPP
@@ -0,0 +1,236 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "ReplServ.hpp"
+
+#include "Repl.hpp"
+
+#include <swirly/fin/Journ.hpp>
+#include <swirly/fin/Msg.hpp>
+
+#include <swirly/util/Log.hpp>
+
+namespace swirly {
+using namespace std;
+
+namespace {
+
+// The journal thread does not back off, so avoid a system call on every cycle.
+constexpr auto AcceptInterval = 100ms;
+constexpr auto ReadInterval = 1ms;
+constexpr auto ReportInterval = 10s;
+// Messages that would exceed the backlog are replayed from the journal once it has drained.
+enum { MaxBacklog = 64 << 20, MaxReplay = 1024, ReplaySize = 4096 };
+
+} // namespace
+
+ReplServ::ReplServ(const TcpEndpoint& ep, Journ& journ)
+: serv_{ep.protocol()}
+, journ_(journ)
+{
+    serv_.setSoReuseAddr(true);
+    serv_.bind(ep);
+    serv_.listen(SOMAXCONN);
+    serv_.setNonBlock();
+}
+
+ReplServ::~ReplServ() = default;
+
+uint64_t ReplServ::seq() const noexcept
+{
+    return journ_.seq();
+}
+
+void ReplServ::send(const Msg& msg)
+{
+    if (!synced_) {
+        return;
+    }
+    const auto seq = journ_.seq();
+    // Stream directly only if the follower has caught up, otherwise the message is replayed.
+    if (sentSeq_ + 1 != seq || out_.size() >= MaxBacklog) {
+        return;
+    }
+    const auto size = msgSize(msg);
+    if (size > MaxReplMsg) {
+        tooLarge(seq, size);
+        return;
+    }
+    auto buf = out_.prepare(sizeof(ReplHeader) + size);
+    auto* const hdr = buffer_cast<ReplHeader*>(buf);
+    hdr->seq = seq;
+    hdr->size = size;
+    memcpy(hdr + 1, &msg, size);
+    out_.commit(sizeof(ReplHeader) + size);
+    sentSeq_ = seq;
+}
+
+int ReplServ::poll(Time now)
+{
+    int n{0};
+    if (!sock_) {
+        if (now - polled_ >= AcceptInterval) {
+            polled_ = now;
+            if (accept(now)) {
+                ++n;
+            }
+        }
+        return n;
+    }
+    if (now - polled_ >= ReadInterval) {
+        polled_ = now;
+        if (read()) {
+            ++n;
+        }
+    }
+    if (synced_ && replay()) {
+        ++n;
+    }
+    if (sock_ && flush()) {
+        ++n;
+    }
+    if (synced_ && now - reported_ >= ReportInterval) {
+        SWIRLY_INFO << "replication seq: "sv << seq() << ", lag: "sv << lag();
+        reported_ = now;
+    }
+    return n;
+}
+
+bool ReplServ::accept(Time now)
+{
+    error_code ec;
+    TcpEndpoint ep;
+    auto sock = serv_.accept(ep, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            // Transient errors, such as an aborted connection, must not stop the journal thread.
+            SWIRLY_ERROR << "replication accept failed: "sv << ec.message();
+        }
+        return false;
+    }
+    SWIRLY_NOTICE << "follower connected from "sv << ep;
+    sock.setNonBlock();
+    sock.setTcpNoDelay(true);
+    sock_ = move(sock);
+    reported_ = now;
+    return true;
+}
+
+bool ReplServ::read()
+{
+    error_code ec;
+    auto buf = in_.prepare(sizeof(ReplAck) * 64);
+    const auto size = sock_.recv(buf, 0, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            SWIRLY_ERROR << "replication recv failed: "sv << ec.message();
+            close();
+        }
+        return false;
+    }
+    if (size == 0) {
+        SWIRLY_WARNING << "follower disconnected at seq "sv << ackSeq_;
+        close();
+        return false;
+    }
+    in_.commit(size);
+    while (in_.size() >= sizeof(ReplAck)) {
+        const uint64_t seq{buffer_cast<const ReplAck*>(in_.data())->seq};
+        in_.consume(sizeof(ReplAck));
+        if (!synced_) {
+            // The first acknowledgement is the follower's starting position.
+            if (seq > journ_.seq()) {
+                SWIRLY_ERROR << "follower at seq "sv << seq << " is ahead of leader at seq "sv
+                             << journ_.seq() << "; resynchronise the follower's database"sv;
+                close();
+                return false;
+            }
+            SWIRLY_NOTICE << "follower resuming from seq "sv << seq;
+            sentSeq_ = seq;
+            synced_ = true;
+        }
+        ackSeq_ = seq;
+    }
+    return true;
+}
+
+bool ReplServ::replay()
+{
+    const auto seq = journ_.seq();
+    int n{0};
+    // Bound the work done on each cycle, so that the journal thread is not starved.
+    for (; sentSeq_ < seq && n < MaxReplay && out_.size() < MaxBacklog; ++n) {
+        const auto next = sentSeq_ + 1;
+        auto buf = out_.prepare(sizeof(ReplHeader) + ReplaySize);
+        auto size = journ_.read(next, buffer_cast<ReplHeader*>(buf) + 1, ReplaySize);
+        if (size > ReplaySize) {
+            buf = out_.prepare(sizeof(ReplHeader) + size);
+            size = journ_.read(next, buffer_cast<ReplHeader*>(buf) + 1, size);
+        }
+        if (size == 0) {
+            SWIRLY_ERROR << "seq "sv << next << " is no longer retained by the journal"sv
+                         << "; resynchronise the follower's database"sv;
+            close();
+            return false;
+        }
+        if (size > MaxReplMsg) {
+            tooLarge(next, size);
+            return false;
+        }
+        auto* const hdr = buffer_cast<ReplHeader*>(buf);
+        hdr->seq = next;
+        hdr->size = size;
+        out_.commit(sizeof(ReplHeader) + size);
+        sentSeq_ = next;
+    }
+    return n > 0;
+}
+
+bool ReplServ::flush()
+{
+    if (out_.empty()) {
+        return false;
+    }
+    error_code ec;
+    const auto size = sock_.send(out_.data(), MSG_NOSIGNAL, ec);
+    if (ec) {
+        if (ec.value() != EAGAIN) {
+            SWIRLY_ERROR << "replication send failed: "sv << ec.message();
+            close();
+        }
+        return false;
+    }
+    out_.consume(size);
+    return true;
+}
+
+void ReplServ::tooLarge(uint64_t seq, size_t size) noexcept
+{
+    SWIRLY_ERROR << "message of "sv << size << " bytes at seq "sv << seq
+                 << " exceeds replication limit of "sv << MaxReplMsg << " bytes"sv
+                 << "; resynchronise the follower's database"sv;
+    close();
+}
+
+void ReplServ::close() noexcept
+{
+    sock_.close();
+    in_.clear();
+    out_.clear();
+    synced_ = false;
+}
+
+} // namespace swirly
@@ -0,0 +1,105 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_REPLSERV_HPP
+#define SWIRLYD_REPLSERV_HPP
+
+#include <swirly/sys/Buffer.hpp>
+#include <swirly/sys/TcpSocket.hpp>
+
+#include <swirly/util/Time.hpp>
+
+namespace swirly {
+inline namespace fin {
+class Journ;
+struct Msg;
+} // namespace fin
+
+/**
+ * Leader side of the replication stream.
+ *
+ * Streams each message written to the journal to a single follower, identified by the journal's
+ * sequence number. A follower that connects behind the leader, or that falls behind, catches up
+ * from the messages retained in the journal. The leader never waits for the follower. All member
+ * functions must be called from the journal thread.
+ */
+class SWIRLY_API ReplServ {
+  public:
+    ReplServ(const TcpEndpoint& ep, Journ& journ);
+    ~ReplServ();
+
+    // Copy.
+    ReplServ(const ReplServ&) = delete;
+    ReplServ& operator=(const ReplServ&) = delete;
+
+    // Move.
+    ReplServ(ReplServ&&) = delete;
+    ReplServ& operator=(ReplServ&&) = delete;
+
+    void getSockName(TcpEndpoint& ep) { serv_.getSockName(ep); }
+    /**
+     * Returns true if a follower is connected and has identified its position.
+     */
+    bool synced() const noexcept { return synced_; }
+    /**
+     * Returns the sequence number of the last message journaled.
+     */
+    std::uint64_t seq() const noexcept;
+    /**
+     * Returns the sequence number of the last message acknowledged by the follower.
+     */
+    std::uint64_t ackSeq() const noexcept { return ackSeq_; }
+    /**
+     * Returns the number of messages not yet acknowledged by the follower.
+     */
+    std::uint64_t lag() const noexcept { return synced_ ? seq() - ackSeq_ : 0; }
+
+    /**
+     * Stream the message that was last written to the journal.
+     */
+    void send(const Msg& msg);
+    /**
+     * Accept follower, read acknowledgements, catch up and flush pending output.
+     *
+     * @return the amount of work done.
+     */
+    int poll(Time now);
+
+  private:
+    bool accept(Time now);
+    bool read();
+    bool replay();
+    bool flush();
+    /**
+     * Close the connection, because the message cannot be replicated.
+     */
+    void tooLarge(std::uint64_t seq, std::size_t size) noexcept;
+    void close() noexcept;
+
+    TcpSocketServ serv_;
+    Journ& journ_;
+    IoSocket sock_;
+    Buffer in_, out_;
+    // Sequence number of the last message buffered for the follower.
+    std::uint64_t sentSeq_{0};
+    std::uint64_t ackSeq_{0};
+    bool synced_{false};
+    Time polled_{}, reported_{};
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_REPLSERV_HPP
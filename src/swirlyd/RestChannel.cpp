@@ -0,0 +1,274 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "RestChannel.hpp"
+
+#include "RestServ.hpp"
+
+#include <swirly/fin/Exception.hpp>
+
+#include <swirly/util/Log.hpp>
+
+namespace swirly {
+using namespace std;
+
+namespace {
+
+// Maximum number of requests handled from one channel before moving to the next.
+enum { MaxBatch = 16 };
+
+constexpr auto InternalServerError = "HTTP/1.1 500 Internal Server Error\r\n"
+                                     "Cache-Control: no-cache\r\n"
+                                     "Content-Length: 0\r\n\r\n"sv;
+
+struct RequestHeader {
+    uint64_t token;
+    int32_t method;
+    uint32_t urlLen;
+    uint32_t accntLen;
+    uint32_t permLen;
+    uint32_t timeLen;
+    uint32_t bodyLen;
+};
+
+char* put(char* ptr, string_view sv) noexcept
+{
+    memcpy(ptr, sv.data(), sv.size());
+    return ptr + sv.size();
+}
+
+string_view take(const char*& ptr, size_t len) noexcept
+{
+    const string_view sv{ptr, len};
+    ptr += len;
+    return sv;
+}
+
+void appendHeader(HttpRequest& req, string_view field, string_view value)
+{
+    if (!value.empty()) {
+        req.appendHeaderField(field, true);
+        req.appendHeaderValue(value, true);
+    }
+}
+
+} // namespace
+
+RestDoorbell::RestDoorbell()
+: efd_{0, EFD_NONBLOCK}
+{
+}
+
+RestDoorbell::~RestDoorbell() = default;
+
+Reactor::Handle RestDoorbell::subscribe(Reactor& r)
+{
+    return r.subscribe(efd_.fd(), EventIn, bind<&RestDoorbell::onInput>(this));
+}
+
+void RestDoorbell::notify() noexcept
+{
+    error_code ec;
+    efd_.write(1, ec);
+    if (ec) {
+        SWIRLY_ERROR << "failed to write eventfd: "sv << ec.message();
+    }
+}
+
+void RestDoorbell::onInput(int fd, unsigned events, Time now)
+{
+    // Reset the counter. The consumer's agent runs after the reactor returns.
+    efd_.read();
+}
+
+RestChannel::RestChannel(size_t capacity)
+: requests_{capacity}
+, responses_{capacity}
+{
+    // Responses are bounded by half of the queue.
+    pending_.reserve(capacity / 2);
+}
+
+RestChannel::~RestChannel() = default;
+
+bool RestChannel::postRequest(uintptr_t token, const HttpRequest& req, string_view body) noexcept
+{
+    const auto url = req.url();
+    const auto accnt = req.accnt();
+    const auto perm = req.perm();
+    const auto time = req.time();
+    const RequestHeader hdr{token,
+                            static_cast<int32_t>(req.method()),
+                            static_cast<uint32_t>(url.size()),
+                            static_cast<uint32_t>(accnt.size()),
+                            static_cast<uint32_t>(perm.size()),
+                            static_cast<uint32_t>(time.size()),
+                            static_cast<uint32_t>(body.size())};
+    const auto size
+        = sizeof(hdr) + url.size() + accnt.size() + perm.size() + time.size() + body.size();
+    if (!requests_.post(0, size, [&](char* ptr) noexcept {
+        memcpy(ptr, &hdr, sizeof(hdr));
+        ptr = put(ptr + sizeof(hdr), url);
+        ptr = put(ptr, accnt);
+        ptr = put(ptr, perm);
+        ptr = put(ptr, time);
+        put(ptr, body);
+    })) {
+        return false;
+    }
+    requestBell_.ring();
+    return true;
+}
+
+RestAgent::RestAgent(Reactor& r, RestServ& rs, vector<RestChannel*> channels)
+: restServ_(rs)
+, channels_{move(channels)}
+{
+    subs_.reserve(channels_.size());
+    for (auto* const chan : channels_) {
+        subs_.push_back(chan->requestBell_.subscribe(r));
+    }
+}
+
+RestAgent::~RestAgent() = default;
+
+int RestAgent::operator()()
+{
+    int n{fetchRequests()};
+    if (n == 0) {
+        for (auto* const chan : channels_) {
+            chan->requestBell_.arm();
+        }
+        if ((n = fetchRequests()) > 0) {
+            for (auto* const chan : channels_) {
+                chan->requestBell_.disarm();
+            }
+        }
+    }
+    return n;
+}
+
+int RestAgent::fetchRequests()
+{
+    int n{0};
+    for (auto* const chan : channels_) {
+        if (!chan->pending_.empty()) {
+            if (!postPending(*chan)) {
+                continue;
+            }
+            ++n;
+        }
+        const auto fn = [this, chan](int32_t type, const char* data, size_t size) {
+            this->handleRequest(*chan, data, size);
+        };
+        // A parked response holds back the channel's requests, so that responses remain in order.
+        for (int i{0}; i < MaxBatch && chan->pending_.empty() && chan->requests_.fetch(fn); ++i) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+void RestAgent::handleRequest(RestChannel& chan, const char* data, size_t size) noexcept
+{
+    RequestHeader hdr;
+    memcpy(&hdr, data, sizeof(hdr));
+    data += sizeof(hdr);
+
+    const auto url = take(data, hdr.urlLen);
+    const auto accnt = take(data, hdr.accntLen);
+    const auto perm = take(data, hdr.permLen);
+    const auto time = take(data, hdr.timeLen);
+    const auto body = take(data, hdr.bodyLen);
+
+    out_.clear();
+    bool parsed{false};
+    try {
+        // The front-end has already parsed the same request, so this is not expected to fail.
+        req_.clear();
+        req_.setMethod(static_cast<HttpMethod>(hdr.method));
+        req_.appendUrl(url);
+        appendHeader(req_, "Swirly-Accnt"sv, accnt);
+        appendHeader(req_, "Swirly-Perm"sv, perm);
+        appendHeader(req_, "Swirly-Time"sv, time);
+        if (!body.empty()) {
+            req_.appendBody(body);
+        }
+        req_.flush();
+        parsed = true;
+        restServ_.handleRequest(req_, os_);
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR << "exception handling forwarded request: "sv << e.what();
+        if (!parsed) {
+            renderError(400, "Bad Request", e.what());
+        } else {
+            renderError(500, "Internal Server Error", e.what());
+        }
+    }
+
+    // A response must fit within half of the queue, so that it can always be posted once the
+    // front-end has caught up.
+    if (FrameQueue::frameSize(sizeof(uintptr_t) + out_.size()) > chan.responses_.capacity() / 2) {
+        SWIRLY_ERROR << "response too large: "sv << out_.size();
+        renderError(500, "Internal Server Error", "response too large");
+    }
+    const auto len = out_.size();
+    const uintptr_t token{hdr.token};
+    if (!chan.responses_.post(0, sizeof(token) + len, [&](char* ptr) noexcept {
+        memcpy(ptr, &token, sizeof(token));
+        out_.copy(ptr + sizeof(token));
+    })) {
+        // Rather than stall matching behind a slow front-end, park the response until the
+        // front-end has drained its queue. This does not allocate, because the capacity was
+        // reserved.
+        chan.pending_.resize(sizeof(token) + len);
+        memcpy(chan.pending_.data(), &token, sizeof(token));
+        out_.copy(chan.pending_.data() + sizeof(token));
+    } else {
+        chan.responseBell_.ring();
+    }
+    out_.clear();
+}
+
+bool RestAgent::postPending(RestChannel& chan) noexcept
+{
+    const auto& buf = chan.pending_;
+    if (!chan.responses_.post(0, buf.size(), [&buf](char* ptr) noexcept {
+        memcpy(ptr, buf.data(), buf.size());
+    })) {
+        return false;
+    }
+    chan.responseBell_.ring();
+    chan.pending_.clear();
+    return true;
+}
+
+void RestAgent::renderError(int status, const char* reason, const char* detail) noexcept
+{
+    out_.clear();
+    try {
+        os_.reset(status, reason);
+        ServException::toJson(status, reason, detail, os_);
+        os_.commit();
+    } catch (const std::exception& e) {
+        SWIRLY_ERROR << "exception rendering error: "sv << e.what();
+        out_.clear();
+        // Does not allocate, because the queue is empty.
+        out_.splice(InternalServerError);
+    }
+}
+
+} // namespace swirly
@@ -0,0 +1,213 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef SWIRLYD_RESTCHANNEL_HPP
+#define SWIRLYD_RESTCHANNEL_HPP
+
+#include <swirly/web/Request.hpp>
+#include <swirly/web/Stream.hpp>
+
+#include <swirly/app/FrameQueue.hpp>
+
+#include <swirly/sys/Event.hpp>
+#include <swirly/sys/Reactor.hpp>
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace swirly {
+
+class RestServ;
+
+/**
+ * Wakes the consumer of a queue, which may be blocked in its reactor. The consumer arms the
+ * doorbell when it finds the queue empty, so that the producer only writes to the eventfd when the
+ * consumer may be about to block.
+ */
+class RestDoorbell {
+  public:
+    RestDoorbell();
+    ~RestDoorbell();
+
+    // Copy.
+    RestDoorbell(const RestDoorbell&) = delete;
+    RestDoorbell& operator=(const RestDoorbell&) = delete;
+
+    // Move.
+    RestDoorbell(RestDoorbell&&) = delete;
+    RestDoorbell& operator=(RestDoorbell&&) = delete;
+
+    /**
+     * Subscribe the consumer's reactor to the doorbell.
+     */
+    [[nodiscard]] Reactor::Handle subscribe(Reactor& r);
+    /**
+     * Called by the consumer after it has found the queue empty. The queue must then be checked
+     * again, because the producer may have posted before the doorbell was armed.
+     */
+    void arm() noexcept
+    {
+        __atomic_store_n(&armed_, true, __ATOMIC_RELAXED);
+        // Order the store before the consumer's next load of the write position.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    void disarm() noexcept { __atomic_store_n(&armed_, false, __ATOMIC_RELAXED); }
+    /**
+     * Called by the producer after posting to the queue.
+     */
+    void ring() noexcept
+    {
+        // Order the producer's store of the write position before the load of the flag.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&armed_, __ATOMIC_RELAXED)
+            && __atomic_exchange_n(&armed_, false, __ATOMIC_RELAXED)) {
+            notify();
+        }
+    }
+
+  private:
+    void notify() noexcept;
+    void onInput(int fd, unsigned events, Time now);
+
+    EventFd efd_;
+    bool armed_{false};
+};
+
+/**
+ * Pair of single-producer, single-consumer queues that connect an HTTP front-end thread to the
+ * engine thread. Requests from each front-end are handled in the order that they were parsed, so
+ * responses to pipelined requests are returned in order.
+ */
+class RestChannel {
+    friend class RestAgent;
+
+  public:
+    /**
+     * @param capacity Capacity in bytes of each queue.
+     */
+    explicit RestChannel(std::size_t capacity);
+    ~RestChannel();
+
+    // Copy.
+    RestChannel(const RestChannel&) = delete;
+    RestChannel& operator=(const RestChannel&) = delete;
+
+    // Move.
+    RestChannel(RestChannel&&) = delete;
+    RestChannel& operator=(RestChannel&&) = delete;
+
+    /**
+     * Forward a parsed request, along with its raw body, to the engine thread. The token is
+     * returned with the response.
+     *
+     * Returns false if the request queue is full.
+     */
+    bool postRequest(std::uintptr_t token, const HttpRequest& req, std::string_view body) noexcept;
+
+    /**
+     * Subscribe the front-end's reactor, so that it is woken when responses are returned.
+     */
+    [[nodiscard]] Reactor::Handle subscribeResponses(Reactor& r)
+    {
+        return responseBell_.subscribe(r);
+    }
+    /**
+     * Invoke function with the token and serialised response of each queued response.
+     *
+     * Returns the number of responses.
+     */
+    template <typename FnT>
+    int fetchResponses(FnT fn)
+    {
+        int n{drainResponses(fn)};
+        if (n == 0) {
+            responseBell_.arm();
+            if ((n = drainResponses(fn)) > 0) {
+                responseBell_.disarm();
+            }
+        }
+        return n;
+    }
+
+  private:
+    template <typename FnT>
+    int drainResponses(FnT& fn)
+    {
+        int n{0};
+        while (responses_.fetch([&fn](std::int32_t type, const char* data, std::size_t size) {
+            std::uintptr_t token;
+            std::memcpy(&token, data, sizeof(token));
+            fn(token, std::string_view{data + sizeof(token), size - sizeof(token)});
+        })) {
+            ++n;
+        }
+        return n;
+    }
+
+    FrameQueue requests_;
+    FrameQueue responses_;
+    RestDoorbell requestBell_;
+    RestDoorbell responseBell_;
+    // Serialised response that could not be posted because the response queue was full.
+    std::vector<char> pending_;
+};
+
+/**
+ * Agent that runs on the engine thread. It handles the requests forwarded by each front-end, and
+ * returns the serialised responses over the same channel.
+ */
+class RestAgent {
+  public:
+    /**
+     * The reactor is that of the engine thread, which is woken when requests are forwarded.
+     */
+    RestAgent(Reactor& r, RestServ& rs, std::vector<RestChannel*> channels);
+    ~RestAgent();
+
+    // Copy.
+    RestAgent(const RestAgent&) = delete;
+    RestAgent& operator=(const RestAgent&) = delete;
+
+    // Move.
+    RestAgent(RestAgent&&) = delete;
+    RestAgent& operator=(RestAgent&&) = delete;
+
+    int operator()();
+
+  private:
+    int fetchRequests();
+    void handleRequest(RestChannel& chan, const char* data, std::size_t size) noexcept;
+    /**
+     * Returns true if the channel's parked response was posted.
+     */
+    bool postPending(RestChannel& chan) noexcept;
+    /**
+     * Replace the response with an error, or with a bodiless 500 if the error cannot be rendered.
+     */
+    void renderError(int status, const char* reason, const char* detail) noexcept;
+
+    RestServ& restServ_;
+    std::vector<RestChannel*> channels_;
+    std::vector<Reactor::Handle> subs_;
+    HttpRequest req_;
+    HttpOutQueue out_;
+    HttpStream os_{out_};
+};
+
+} // namespace swirly
+
+#endif // SWIRLYD_RESTCHANNEL_HPP
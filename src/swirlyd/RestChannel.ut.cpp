@@ -0,0 +1,258 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include "RestChannel.hpp"
+
+#include "HttpSess.hpp"
+#include "RestServ.hpp"
+
+#include <swirly/web/Rest.hpp>
+
+#include <swirly/fin/MsgQueue.hpp>
+
+#include <swirly/app/MemCtx.hpp>
+
+#include <swirly/sys/EpollReactor.hpp>
+
+#include <swirly/util/Finally.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+int sessDeleted{0};
+
+void testLogger(int level, string_view msg) noexcept
+{
+    if (msg.find("~HttpSess()"sv) != string_view::npos) {
+        ++sessDeleted;
+    }
+}
+
+struct Engine {
+    explicit Engine(size_t capacity)
+    : chan{capacity}
+    {
+    }
+    MsgQueue mq{1 << 16};
+    Rest rest{mq, 100};
+    MemCtx memCtx;
+    RestServ restServ{rest, memCtx};
+    RestChannel chan;
+    EpollReactor reactor{64};
+    RestAgent agent{reactor, restServ, {&chan}};
+};
+
+bool post(RestChannel& chan, uintptr_t token, HttpMethod method, string_view url)
+{
+    HttpRequest req;
+    req.setMethod(method);
+    req.appendUrl(url);
+    req.flush();
+    return chan.postRequest(token, req, {});
+}
+
+vector<pair<uintptr_t, string>> fetch(RestChannel& chan)
+{
+    vector<pair<uintptr_t, string>> resps;
+    chan.fetchResponses(
+        [&resps](uintptr_t token, string_view data) { resps.emplace_back(token, data); });
+    return resps;
+}
+
+string status(string_view resp)
+{
+    // HTTP/1.1 NNN
+    return string{resp.substr(9, 3)};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RestChannelSuite)
+
+BOOST_AUTO_TEST_CASE(RestChannelRoundTripCase)
+{
+    Engine e{1 << 16};
+    BOOST_TEST(post(e.chan, 1, HttpMethod::Get, "/refdata"sv));
+    BOOST_TEST(post(e.chan, 2, HttpMethod::Get, "/foo"sv));
+    BOOST_TEST(post(e.chan, 3, HttpMethod::Post, "/refdata"sv));
+    BOOST_TEST(e.agent() == 3);
+
+    const auto resps = fetch(e.chan);
+    BOOST_TEST(resps.size() == 3U);
+    BOOST_TEST(resps[0].first == 1U);
+    BOOST_TEST(status(resps[0].second) == "200");
+    BOOST_TEST(resps[0].second.find("\"assets\":[]"sv) != string::npos);
+    BOOST_TEST(resps[1].first == 2U);
+    BOOST_TEST(status(resps[1].second) == "404");
+    BOOST_TEST(resps[2].first == 3U);
+    BOOST_TEST(status(resps[2].second) == "405");
+}
+
+BOOST_AUTO_TEST_CASE(RestChannelParkCase)
+{
+    // Room for only a few responses.
+    Engine e{1 << 10};
+    enum { Count = 16 };
+    for (int i{1}; i <= Count; ++i) {
+        BOOST_TEST(post(e.chan, i, HttpMethod::Get, "/refdata"sv));
+        e.agent();
+    }
+    // The engine does not wait for the front-end to drain its queue.
+    auto resps = fetch(e.chan);
+    BOOST_TEST(resps.size() < size_t{Count});
+
+    vector<uintptr_t> tokens;
+    for (int i{0}; i < Count && !resps.empty(); ++i) {
+        for (const auto& resp : resps) {
+            tokens.push_back(resp.first);
+        }
+        e.agent();
+        resps = fetch(e.chan);
+    }
+    BOOST_TEST(tokens.size() == size_t{Count});
+    for (size_t i{0}; i < tokens.size(); ++i) {
+        BOOST_TEST(tokens[i] == i + 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(RestChannelWakeCase)
+{
+    Engine e{1 << 16};
+    EpollReactor r{64};
+    const auto sub = e.chan.subscribeResponses(r);
+
+    // The engine arms the doorbell when it finds no requests.
+    BOOST_TEST(e.agent() == 0);
+    BOOST_TEST(e.reactor.poll(0ms) == 0);
+    BOOST_TEST(post(e.chan, 1, HttpMethod::Get, "/refdata"sv));
+    BOOST_TEST(e.reactor.poll(0ms) == 1);
+
+    // The doorbell is rung once per arming.
+    BOOST_TEST(post(e.chan, 2, HttpMethod::Get, "/refdata"sv));
+    BOOST_TEST(e.reactor.poll(0ms) == 0);
+
+    // Likewise for the front-end.
+    BOOST_TEST(fetch(e.chan).empty());
+    BOOST_TEST(r.poll(0ms) == 0);
+    BOOST_TEST(e.agent() == 2);
+    BOOST_TEST(r.poll(0ms) == 1);
+    BOOST_TEST(fetch(e.chan).size() == 2U);
+    BOOST_TEST(r.poll(0ms) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(HttpSessInflightCloseCase)
+{
+    const auto prevLevel = setLogLevel(Log::Info);
+    const auto prevLogger = setLogger(testLogger);
+    // clang-format off
+    const auto finally = makeFinally([prevLevel, prevLogger]() noexcept {
+        setLogLevel(prevLevel);
+        setLogger(prevLogger);
+    });
+    // clang-format on
+
+    Engine e{1 << 16};
+    EpollReactor r{64};
+    auto socks = socketpair(LocalStream{});
+    new HttpSess{r, move(socks.second), LocalStreamEndpoint{}, e.chan, nullptr, UnixClock::now()};
+
+    const auto req = "GET /refdata HTTP/1.1\r\nHost: localhost\r\n\r\n"sv;
+    socks.first.send(req.data(), req.size(), 0);
+    r.poll(0ms);
+
+    // Closed by the client while the request is with the engine.
+    socks.first.close();
+    r.poll(0ms);
+    sessDeleted = 0;
+    BOOST_TEST(e.agent() == 1);
+    BOOST_TEST(sessDeleted == 0);
+
+    // The session is deleted once the response has been returned.
+    BOOST_TEST(e.chan.fetchResponses([](uintptr_t token, string_view data) {
+        reinterpret_cast<HttpSess*>(token)->onResponse(data);
+    }) == 1);
+    BOOST_TEST(sessDeleted == 1);
+}
+
+BOOST_AUTO_TEST_CASE(HttpSessQueueFullCase)
+{
+    // Room for only a few requests.
+    Engine e{1 << 9};
+    EpollReactor r{64};
+    auto socks = socketpair(LocalStream{});
+    new HttpSess{r, move(socks.second), LocalStreamEndpoint{}, e.chan, nullptr, UnixClock::now()};
+
+    enum { Count = 16 };
+    string reqs;
+    vector<string> expected;
+    for (int i{0}; i < Count; ++i) {
+        if (i % 2 == 0) {
+            reqs += "GET /refdata HTTP/1.1\r\nHost: localhost\r\n\r\n"sv;
+            expected.emplace_back("200");
+        } else {
+            reqs += "GET /foo HTTP/1.1\r\nHost: localhost\r\n\r\n"sv;
+            expected.emplace_back("404");
+        }
+    }
+    socks.first.send(reqs.data(), reqs.size(), 0);
+
+    string in;
+    char buf[4096];
+    for (int i{0}; i < 100; ++i) {
+        r.poll(0ms);
+        e.agent();
+        e.chan.fetchResponses([](uintptr_t token, string_view data) {
+            reinterpret_cast<HttpSess*>(token)->onResponse(data);
+        });
+        r.poll(0ms);
+        ssize_t n;
+        while ((n = ::recv(*socks.first, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            in.append(buf, n);
+        }
+        // The session remains open.
+        BOOST_REQUIRE(n < 0);
+    }
+
+    // Rejected requests are answered in order.
+    vector<string> statuses;
+    for (auto pos = in.find("HTTP/1.1 "); pos != string::npos; pos = in.find("HTTP/1.1 ", pos + 1)) {
+        statuses.push_back(in.substr(pos + 9, 3));
+    }
+    BOOST_TEST(statuses.size() == size_t{Count});
+    int rejected{0};
+    for (size_t i{0}; i < statuses.size(); ++i) {
+        if (statuses[i] == "503") {
+            ++rejected;
+        } else {
+            BOOST_TEST(statuses[i] == expected[i]);
+        }
+    }
+    BOOST_TEST(rejected > 0);
+    BOOST_TEST(rejected < Count);
+
+    socks.first.close();
+    r.poll(0ms);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
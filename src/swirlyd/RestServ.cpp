@@ -22,15 +22,29 @@
 
 #include <swirly/fin/Exception.hpp>
 
+#include <swirly/app/MemCtx.hpp>
+
 #include <swirly/util/Finally.hpp>
 #include <swirly/util/Log.hpp>
 
 #include <chrono>
+#include <sstream>
 
 namespace swirly {
 using namespace std;
 namespace {
 
+template <typename FnT>
+string_view render(string& cache, FnT fn)
+{
+    if (cache.empty()) {
+        ostringstream os;
+        fn(os);
+        cache = os.str();
+    }
+    return cache;
+}
+
 class ScopedIds {
   public:
     ScopedIds(string_view sv, vector<Id64>& ids) noexcept
@@ -92,7 +106,7 @@ string_view getTrader(const HttpRequest& req)
 
 RestServ::~RestServ() = default;
 
-void RestServ::handleRequest(const HttpRequest& req, HttpStream& os) noexcept
+void RestServ::handleRequest(const HttpRequest& req, HttpStream& os)
 {
     TimeRecorder tr{profile_};
     const auto finally = makeFinally([this]() noexcept {
@@ -135,7 +149,7 @@ void RestServ::handleRequest(const HttpRequest& req, HttpStream& os) noexcept
         os.reset(status, reason);
         ServException::toJson(status, reason, e.what(), os);
     }
-    os.commit(); // noexcept
+    os.commit(); // May throw.
 }
 
 bool RestServ::reset(const HttpRequest& req) noexcept
@@ -173,6 +187,9 @@ void RestServ::restRequest(const HttpRequest& req, Time now, HttpStream& os)
     } else if (tok == "accnt"sv) {
         // /accnt
         accntRequest(req, now, os);
+    } else if (tok == "stats"sv) {
+        // /stats
+        statsRequest(req, now, os);
     } else {
         // Support both plural and singular forms.
         if (!tok.empty() && tok.back() == 's') {
@@ -196,7 +213,7 @@ void RestServ::refDataRequest(const HttpRequest& req, Time now, HttpStream& os)
             // GET /refdata
             matchMethod_ = true;
             const int bs{EntitySet::Asset | EntitySet::Instr};
-            rest_.getRefData(bs, now, os);
+            os.splice(render(refData_, [&](ostream& out) { rest_.getRefData(bs, now, out); }));
         }
         return;
     }
@@ -241,7 +258,7 @@ void RestServ::assetRequest(const HttpRequest& req, Time now, HttpStream& os)
         if (req.method() == HttpMethod::Get) {
             // GET /refdata/assets
             matchMethod_ = true;
-            rest_.getAsset(now, os);
+            os.splice(render(assets_, [&](ostream& out) { rest_.getAsset(now, out); }));
         }
         return;
     }
@@ -273,7 +290,7 @@ void RestServ::instrRequest(const HttpRequest& req, Time now, HttpStream& os)
         if (req.method() == HttpMethod::Get) {
             // GET /refdata/instrs
             matchMethod_ = true;
-            rest_.getInstr(now, os);
+            os.splice(render(instrs_, [&](ostream& out) { rest_.getInstr(now, out); }));
         }
         return;
     }
@@ -806,4 +823,50 @@ void RestServ::posnRequest(const HttpRequest& req, Time now, HttpStream& os)
     }
 }
 
+void RestServ::statsRequest(const HttpRequest& req, Time now, HttpStream& os)
+{
+    if (path_.empty()) {
+        return;
+    }
+
+    const auto tok = path_.top();
+    path_.pop();
+
+    if (tok == "mem"sv && path_.empty()) {
+
+        // /stats/mem
+        matchPath_ = true;
+
+        if (req.method() == HttpMethod::Get) {
+            // GET /stats/mem
+            matchMethod_ = true;
+            getAdmin(req);
+            os << "{\"max_size\":"sv << memCtx_.maxSize()    //
+               << ",\"reserved\":"sv << memCtx_.reserved()   //
+               << ",\"overflows\":"sv << memCtx_.overflows() //
+               << ",\"size_classes\":["sv;
+            for (size_t sc{0}; sc < MemCtx::SizeClasses; ++sc) {
+                const auto st = memCtx_.stats(sc);
+                if (sc > 0) {
+                    os << ',';
+                }
+                os << "{\"block_size\":"sv << MemCtx::blockSize(sc) //
+                   << ",\"allocs\":"sv << st.allocs                 //
+                   << ",\"frees\":"sv << st.frees                   //
+                   << ",\"live\":"sv << st.live                     //
+                   << ",\"high_water\":"sv << st.highWater          //
+                   << ",\"reserved\":"sv << st.reserved             //
+                   << ",\"refills\":"sv << st.refills               //
+                   << ",\"flushes\":"sv << st.flushes << '}';
+            }
+            const auto st = memCtx_.largeStats();
+            os << "],\"large\":{\"allocs\":"sv << st.allocs //
+               << ",\"frees\":"sv << st.frees                 //
+               << ",\"live\":"sv << st.live                   //
+               << ",\"high_water\":"sv << st.highWater        //
+               << ",\"reserved\":"sv << st.reserved << "}}"sv;
+        }
+    }
+}
+
 } // namespace swirly
@@ -24,9 +24,13 @@
 
 #include <swirly/util/Time.hpp>
 
+#include <string>
 #include <vector>
 
 namespace swirly {
+inline namespace app {
+class MemCtx;
+} // namespace app
 inline namespace web {
 class HttpRequest;
 class HttpStream;
@@ -35,8 +39,9 @@ class Rest;
 
 class RestServ {
   public:
-    explicit RestServ(Rest& rest) noexcept
+    RestServ(Rest& rest, const MemCtx& memCtx) noexcept
     : rest_(rest)
+    , memCtx_(memCtx)
     , profile_{"profile"sv}
     {
     }
@@ -50,7 +55,12 @@ class RestServ {
     RestServ(RestServ&&) = delete;
     RestServ& operator=(RestServ&&) = delete;
 
-    void handleRequest(const HttpRequest& req, HttpStream& os) noexcept;
+    /**
+     * Render and queue the response to a request.
+     *
+     * @throw std::bad_alloc if there is no room for the response, in which case nothing is queued.
+     */
+    void handleRequest(const HttpRequest& req, HttpStream& os);
 
   private:
     bool reset(const HttpRequest& req) noexcept;
@@ -69,12 +79,18 @@ class RestServ {
     void tradeRequest(const HttpRequest& req, Time now, HttpStream& os);
     void posnRequest(const HttpRequest& req, Time now, HttpStream& os);
 
+    void statsRequest(const HttpRequest& req, Time now, HttpStream& os);
+
     Rest& rest_;
+    const MemCtx& memCtx_;
     bool matchMethod_{false};
     bool matchPath_{false};
     Tokeniser path_;
     std::vector<Id64> ids_;
     std::vector<Symbol> symbols_;
+    // Reference data is immutable once loaded, so these responses are rendered once and then
+    // spliced into each response by reference.
+    std::string refData_, assets_, instrs_;
     Profile profile_;
 };
 
@@ -0,0 +1,116 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/app/AgentStats.hpp>
+
+#include <swirly/util/Log.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+void printHist(ostream& os, const AgentStats& stats)
+{
+    for (size_t i{0}; i < AgentStats::Buckets; ++i) {
+        if (stats.batchSizes[i] > 0) {
+            os << ' ' << (1 << i) << (i + 1 < AgentStats::Buckets ? ":"sv : "+:"sv)
+               << stats.batchSizes[i];
+        }
+    }
+}
+
+void printTotals(ostream& os, const AgentStatsBlock& block)
+{
+    for (size_t i{0}; i < block.slots(); ++i) {
+        if (!block.used(i)) {
+            continue;
+        }
+        const auto st = snapshot(block[i]);
+        os << name(st) << ": work "sv << st.workItems << ", busy "sv << st.busyCycles
+           << ", idle "sv << st.idleCycles << ", idle time "sv << st.idleNanos / 1000000
+           << "ms, batches"sv;
+        printHist(os, st);
+        os << '\n';
+    }
+}
+
+void printRates(ostream& os, const AgentStatsBlock& block, chrono::seconds interval)
+{
+    using Clock = chrono::steady_clock;
+
+    vector<AgentStats> prev(block.slots());
+    auto then = Clock::now();
+    for (size_t i{0}; i < block.slots(); ++i) {
+        prev[i] = snapshot(block[i]);
+    }
+    os << setw(16) << left << "name"sv << right << setw(12) << "work/s"sv << setw(12)
+       << "busy/s"sv << setw(12) << "idle/s"sv << setw(8) << "duty%"sv << setw(10) << "batch"sv
+       << '\n';
+    for (;;) {
+        this_thread::sleep_for(interval);
+        const auto now = Clock::now();
+        const auto secs = chrono::duration<double>(now - then).count();
+        then = now;
+        for (size_t i{0}; i < block.slots(); ++i) {
+            if (!block.used(i)) {
+                continue;
+            }
+            const auto st = snapshot(block[i]);
+            const auto& pv = prev[i];
+            const auto work = st.workItems - pv.workItems;
+            const auto busy = st.busyCycles - pv.busyCycles;
+            const auto idle = st.idleCycles - pv.idleCycles;
+            // Time outside of idle spells is attributed to the agent.
+            const auto idleSecs = (st.idleNanos - pv.idleNanos) / 1e9;
+            const auto duty = max(0.0, 100.0 * (1.0 - idleSecs / secs));
+            os << setw(16) << left << name(st) << right << fixed << setprecision(0) << setw(12)
+               << work / secs << setw(12) << busy / secs << setw(12) << idle / secs
+               << setprecision(1) << setw(8) << duty << setw(10)
+               << (busy > 0 ? static_cast<double>(work) / busy : 0.0) << '\n';
+            prev[i] = st;
+        }
+        os << flush;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        if (argc < 2) {
+            cerr << "usage: swirly-agent-stat FILE [INTERVAL]\n"sv;
+            return 1;
+        }
+        const AgentStatsBlock block{argv[1], true};
+        if (argc < 3) {
+            printTotals(cout, block);
+        } else {
+            printRates(cout, block, chrono::seconds{stoi(argv[2])});
+        }
+        ret = 0;
+    } catch (const exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+    }
+    return ret;
+}
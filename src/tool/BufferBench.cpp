@@ -0,0 +1,87 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/sys/Buffer.hpp>
+#include <swirly/sys/MirrorBuffer.hpp>
+
+#include <swirly/util/Log.hpp>
+#include <swirly/util/Profile.hpp>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+constexpr int Iters{1000000};
+constexpr size_t MaxRecv{64 << 10};
+
+/**
+ * Simulate a pipelined connection: each iteration receives a chunk of random size, and then
+ * consumes as many whole messages as are available, leaving any partial message in the buffer.
+ */
+template <typename BufferT>
+void run(BufferT& buf, string_view name, size_t msgSize)
+{
+    mt19937 gen{static_cast<mt19937::result_type>(msgSize)};
+    uniform_int_distribution<size_t> dis{1, 4 * msgSize};
+
+    const vector<char> src(MaxRecv, 'x');
+    size_t sum{0};
+
+    Profile p{string{name} + '_' + to_string(msgSize)};
+    for (int i{0}; i < Iters; ++i) {
+        const auto n = dis(gen);
+        TimeRecorder tr{p};
+        const auto out = buf.prepare(MaxRecv);
+        memcpy(buffer_cast<char*>(out), src.data(), n);
+        buf.commit(n);
+        while (buf.size() >= msgSize) {
+            sum += *buffer_cast<const char*>(buf.data());
+            buf.consume(msgSize);
+        }
+    }
+    if (sum == 0) {
+        SWIRLY_WARNING << "no messages consumed"sv;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        for (const size_t msgSize : {64, 1024, 16384}) {
+            {
+                Buffer buf;
+                run(buf, "vector"sv, msgSize);
+            }
+            {
+                MirrorBuffer buf{2 * MaxRecv};
+                run(buf, "ring"sv, msgSize);
+            }
+        }
+        ret = 0;
+    } catch (const exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+    }
+    return ret;
+}
@@ -17,6 +17,7 @@
 #include <swirly/app/Thread.hpp>
 
 #include <swirly/sys/EpollReactor.hpp>
+#include <swirly/sys/IoUringReactor.hpp>
 #include <swirly/sys/Signal.hpp>
 #include <swirly/sys/TcpAcceptor.hpp>
 
@@ -131,7 +132,14 @@ int main(int argc, char* argv[])
     int ret = 1;
     try {
 
-        EpollReactor reactor{1024};
+        // The reactor may be selected with the first argument: epoll (default) or io_uring.
+        unique_ptr<Reactor> reactorPtr;
+        if (argc > 1 && argv[1] == "io_uring"sv) {
+            reactorPtr = makeIoUringReactor(1024);
+        } else {
+            reactorPtr = make_unique<EpollReactor>(1024);
+        }
+        auto& reactor = *reactorPtr;
         const TcpEndpoint ep{Tcp::v4(), 7777};
         EchoServ echoServ{reactor, ep};
 
@@ -0,0 +1,195 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/lob/MarketData.hpp>
+
+#include <swirly/sys/Buffer.hpp>
+#include <swirly/sys/TcpSocket.hpp>
+#include <swirly/sys/UdpSocket.hpp>
+
+#include <swirly/util/Log.hpp>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+/**
+ * Market-data consumer, which maintains the book of each market from the multicast updates, and
+ * recovers from gaps with a snapshot.
+ */
+class MdRecv {
+  public:
+    explicit MdRecv(const TcpEndpoint& snapEp)
+    : snapEp_{snapEp}
+    {
+    }
+    void onPacket(const char* data, size_t size)
+    {
+        if (size < sizeof(MdHeader) + sizeof(MdTop)) {
+            SWIRLY_WARNING << "short packet: "sv << size;
+            return;
+        }
+        MdHeader hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        const uint64_t seq{hdr.seq};
+        if (seq_ > 0 && seq <= seq_) {
+            // Already applied.
+            return;
+        }
+        if (seq_ == 0 || seq != seq_ + 1) {
+            if (seq_ > 0) {
+                SWIRLY_WARNING << "gap from seq "sv << seq_ + 1 << " to "sv << seq - 1;
+            }
+            // Retain the update, which may be newer than the snapshot.
+            pending_.emplace(seq, string{data, size});
+            recover();
+            return;
+        }
+        apply(data);
+    }
+
+  private:
+    void recover()
+    {
+        snapshot();
+        // Apply retained updates, which must follow on from the snapshot.
+        for (auto it = pending_.begin(); it != pending_.end(); it = pending_.erase(it)) {
+            if (it->first <= seq_) {
+                continue;
+            }
+            if (it->first != seq_ + 1) {
+                // Recover again on the next update.
+                seq_ = 0;
+                break;
+            }
+            apply(it->second.data());
+        }
+        pending_.clear();
+    }
+    void snapshot()
+    {
+        TcpSocketClnt sock{snapEp_.protocol()};
+        sock.connect(snapEp_);
+        Buffer buf;
+        for (;;) {
+            const auto size = sock.recv(buf.prepare(64 << 10), 0);
+            if (size == 0) {
+                break;
+            }
+            buf.commit(size);
+        }
+        if (buf.size() < sizeof(MdHeader)) {
+            throw runtime_error{"short snapshot"};
+        }
+        const auto* data = buffer_cast<const char*>(buf.data());
+        MdHeader hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.type != MdType::Snapshot
+            || buf.size() != sizeof(MdHeader) + hdr.count * sizeof(MdBook)) {
+            throw runtime_error{"invalid snapshot"};
+        }
+        data += sizeof(hdr);
+        books_.clear();
+        for (size_t i{0}; i < hdr.count; ++i) {
+            MdBook book;
+            memcpy(&book, data + i * sizeof(book), sizeof(book));
+            books_[Id64{book.marketId}] = book;
+            print(hdr.seq, book);
+        }
+        SWIRLY_NOTICE << "snapshot at seq "sv << hdr.seq << " with "sv << hdr.count
+                      << " markets"sv;
+        seq_ = hdr.seq;
+    }
+    void apply(const char* data)
+    {
+        MdHeader hdr;
+        MdTop top;
+        memcpy(&hdr, data, sizeof(hdr));
+        memcpy(&top, data + sizeof(hdr), sizeof(top));
+        MdDelta deltas[MaxMdDeltas];
+        const auto count = min<size_t>(hdr.count, MaxMdDeltas);
+        memcpy(deltas, data + sizeof(hdr) + sizeof(top), count * sizeof(MdDelta));
+
+        auto [it, inserted] = books_.try_emplace(Id64{top.marketId});
+        if (inserted) {
+            memset(&it->second, 0, sizeof(it->second));
+        }
+        applyMdUpdate(top, deltas, count, it->second);
+        print(hdr.seq, it->second);
+        seq_ = hdr.seq;
+    }
+    void print(uint64_t seq, const MdBook& book)
+    {
+        cout << seq << ' ' << book.marketId;
+        for (size_t i{0}; i < MaxLevels; ++i) {
+            const auto& bid = book.bids[i];
+            const auto& offer = book.offers[i];
+            cout << " | "sv << bid.lots << '@' << bid.ticks << ' ' << offer.lots << '@'
+                 << offer.ticks;
+        }
+        cout << endl;
+    }
+
+    const TcpEndpoint snapEp_;
+    std::map<Id64, MdBook> books_;
+    // Updates received while recovering, ordered by sequence number.
+    std::map<uint64_t, string> pending_;
+    uint64_t seq_{0};
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        if (argc < 3) {
+            cerr << "usage: swirly-md-recv GROUP:PORT SNAPSHOT_HOST:PORT [IFNAME]\n"sv;
+            return 1;
+        }
+        const auto group = parseEndpoint<Udp>(argv[1]);
+        const auto snapEp = parseEndpoint<Tcp>(argv[2]);
+        const char* const ifname{argc > 3 ? argv[3] : nullptr};
+
+        UdpSocket sock{group.protocol()};
+        // Allow several consumers on the same host.
+        sock.setSoReuseAddr(true);
+        sock.bind(group);
+        if (ifname) {
+            sock.joinGroup(group.address(), ifname);
+        } else {
+            sock.joinGroup(group.address(), 0U);
+        }
+
+        MdRecv recv{snapEp};
+        char buf[MaxMdUpdate];
+        for (;;) {
+            UdpEndpoint ep;
+            const auto size = sock.recvfrom(buf, sizeof(buf), 0, ep);
+            recv.onPacket(buf, size);
+        }
+        ret = 0;
+    } catch (const exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+    }
+    return ret;
+}
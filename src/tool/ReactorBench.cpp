@@ -0,0 +1,106 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/sys/EpollReactor.hpp>
+#include <swirly/sys/IoSocket.hpp>
+#include <swirly/sys/IoUringReactor.hpp>
+#include <swirly/sys/LocalAddress.hpp>
+
+#include <swirly/util/Log.hpp>
+#include <swirly/util/Profile.hpp>
+
+#include <vector>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+constexpr int Iters{100000};
+constexpr size_t Conns{64};
+
+struct EchoHandler {
+    void onInput(int fd, unsigned events, Time now)
+    {
+        char buf[64];
+        const auto size = os::read(fd, buf, sizeof(buf));
+        if (size > 0) {
+            os::write(fd, buf, size);
+        }
+    }
+};
+
+/**
+ * Round-trip a message through the reactor on a single connection, then on a batch of connections
+ * that become ready at the same time.
+ */
+void run(Reactor& r, string_view name)
+{
+    EchoHandler h;
+    vector<pair<IoSocket, IoSocket>> socks;
+    vector<Reactor::Handle> subs;
+    for (size_t i{0}; i < Conns; ++i) {
+        socks.push_back(socketpair(LocalStream{}));
+        subs.push_back(r.subscribe(*socks.back().second, EventIn, bind<&EchoHandler::onInput>(&h)));
+    }
+    char buf[8]{};
+    {
+        Profile p{string{name} + "_single"};
+        for (int i{0}; i < Iters; ++i) {
+            TimeRecorder tr{p};
+            socks[0].first.send(buf, sizeof(buf), 0);
+            while (r.poll(0ms) == 0) {
+            }
+            socks[0].first.recv(buf, sizeof(buf), 0);
+        }
+    }
+    {
+        Profile p{string{name} + "_batch"};
+        for (int i{0}; i < Iters / static_cast<int>(Conns); ++i) {
+            TimeRecorder tr{p};
+            for (auto& sock : socks) {
+                sock.first.send(buf, sizeof(buf), 0);
+            }
+            for (size_t n{0}; n < Conns;) {
+                n += r.poll(0ms);
+            }
+            for (auto& sock : socks) {
+                sock.first.recv(buf, sizeof(buf), 0);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        {
+            EpollReactor r{1024};
+            run(r, "epoll"sv);
+        }
+        {
+            IoUringReactor r{1024};
+            run(r, "io_uring"sv);
+        }
+        ret = 0;
+    } catch (const exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+    }
+    return ret;
+}
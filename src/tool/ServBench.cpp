@@ -83,14 +83,33 @@ class NullJourn : public Journ {
     ~NullJourn() override = default;
 
   protected:
+    uint64_t doSeq() const noexcept override { return 0; }
+
+    size_t doRead(uint64_t seq, void* buf, size_t size) override { return 0; }
+
     void doWrite(const Msg& msg) override {}
+
+    void doTruncate(uint64_t seq) override {}
 };
 
 MemCtx memCtx;
 
+struct PutLevelStats {
+    const LevelSet& levels;
+};
+
+ostream& operator<<(ostream& os, PutLevelStats p)
+{
+    const auto& st = p.levels.stats();
+    return os << st.allocs << " created, "sv << st.recycled << " recycled ("sv
+              << (st.allocs > 0 ? 100 * st.recycled / st.allocs : 0) << "%)"sv;
+}
+
 } // namespace
 
 namespace swirly {
+// Replace the weak defaults, so that MemAlloc objects are allocated from the pool.
+inline namespace app {
 
 void* alloc(size_t size)
 {
@@ -107,6 +126,7 @@ void dealloc(void* ptr, size_t size) noexcept
     return memCtx.dealloc(ptr, size);
 }
 
+} // namespace app
 } // namespace swirly
 
 int main(int argc, char* argv[])
@@ -114,7 +134,9 @@ int main(int argc, char* argv[])
     int ret = 1;
     try {
 
-        memCtx = MemCtx{1 << 20};
+        MemOpts memOpts;
+        memOpts.overflow = true;
+        memCtx = MemCtx{64 << 20, memOpts};
 
         unique_ptr<Model> model;
         if (argc > 1) {
@@ -128,7 +150,7 @@ int main(int argc, char* argv[])
         const BusinessDay busDay{MarketZone};
         const auto now = UnixClock::now();
 
-        MsgQueue mq{1 << 10};
+        MsgQueue mq{1 << 18};
         Serv serv{mq, 1 << 4};
         serv.load(*model, now);
         model = nullptr;
@@ -136,9 +158,7 @@ int main(int argc, char* argv[])
         NullJourn journ;
         auto journAgent = [&mq, &journ]() {
             int n{0};
-            Msg msg;
-            while (mq.pop(msg)) {
-                journ.write(msg);
+            while (mq.fetch([&journ](const Msg& msg) { journ.write(msg); })) {
                 ++n;
             }
             return n;
@@ -251,6 +271,9 @@ int main(int argc, char* argv[])
             arch(pipayl, market.id(), now);
         }
 
+        SWIRLY_INFO << "bid levels: "sv << PutLevelStats{market.bidSide().levels()};
+        SWIRLY_INFO << "offer levels: "sv << PutLevelStats{market.offerSide().levels()};
+
         ret = 0;
     } catch (const exception& e) {
         SWIRLY_ERROR << "exception: "sv << e.what();
@@ -14,48 +14,71 @@
  * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
  * 02110-1301, USA.
  */
-#include <swirly/sys/EpollReactor.hpp>
+#include <swirly/sys/Timer.hpp>
+#include <swirly/sys/TimerWheel.hpp>
 
 #include <swirly/util/Log.hpp>
-#include <swirly/util/RefCount.hpp>
+#include <swirly/util/Profile.hpp>
 
-#include <iostream>
 #include <random>
+#include <string>
+#include <vector>
 
 using namespace std;
 using namespace swirly;
 
 namespace {
 
-struct TimerHandler : RefCount<TimerHandler, ThreadUnsafePolicy> {
+constexpr int Iters{1000000};
+
+struct TimerHandler {
     void onTimer(Timer& tmr, Time now) {}
 };
 
+/**
+ * Reschedule randomly chosen timers from a population of live timers, which replaces and
+ * therefore cancels the previous timer, and then dispatch any that have expired.
+ */
+template <typename QueueT>
+void run(QueueT& tq, string_view name, int live, Time now)
+{
+    mt19937 gen{static_cast<mt19937::result_type>(live)};
+    uniform_int_distribution<> dis;
+
+    TimerHandler h;
+    // Expiries are spread over a minute, so that only a small fraction expire during the run.
+    const auto expiry = [&]() { return now + 1s + Micros{dis(gen) % 60000000}; };
+
+    vector<Timer> ts;
+    ts.reserve(live);
+    for (int i{0}; i < live; ++i) {
+        ts.push_back(tq.insert(expiry(), bind<&TimerHandler::onTimer>(&h)));
+    }
+    Profile p{string{name} + '_' + to_string(live)};
+    for (int i{0}; i < Iters; ++i) {
+        TimeRecorder tr{p};
+        now += 1us;
+        ts[dis(gen) % live] = tq.insert(expiry(), bind<&TimerHandler::onTimer>(&h));
+        tq.dispatch(now);
+    }
+}
+
 } // namespace
 
 int main(int argc, char* argv[])
 {
     int ret = 1;
     try {
-
-        random_device rd;
-        mt19937 gen{rd()};
-        uniform_int_distribution<> dis;
-
-        EpollReactor r{1024};
-        Timer ts[128];
-
-        auto h = makeIntrusive<TimerHandler>();
-        for (int i{0}; i < 5000000; ++i) {
+        for (const int live : {10000, 100000, 1000000}) {
             const auto now = UnixClock::now();
-            auto& t = ts[dis(gen) % 128];
-            if (t && dis(gen) % 2 == 0) {
-                t = {};
-            } else {
-                t = r.timer(now + Micros{dis(gen) % 100}, Priority::High,
-                            bind<&TimerHandler::onTimer>(h.get()));
+            {
+                TimerQueue tq;
+                run(tq, "heap"sv, live, now);
+            }
+            {
+                TimerWheel tw{now};
+                run(tw, "wheel"sv, live, now);
             }
-            r.poll(0ms);
         }
         ret = 0;
     } catch (const exception& e) {
@@ -0,0 +1,100 @@
+/*
+ * The Restful Matching-Engine.
+ * Copyright (C) 2013, 2018 Swirly Cloud Limited.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+ * even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if
+ * not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#include <swirly/sys/UdpSocket.hpp>
+
+#include <swirly/util/Log.hpp>
+
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+using namespace swirly;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+constexpr size_t Packets{1 << 20};
+constexpr size_t MaxBatch{64};
+
+/**
+ * Send packets over loopback in batches of the specified size, receiving each batch before the
+ * next is sent, so that the socket buffer never overflows. The time spent in each direction is
+ * accumulated separately.
+ */
+void run(UdpSocket& ssock, UdpSocket& rsock, const UdpEndpoint& ep, size_t batch, size_t msgSize)
+{
+    UdpMsgVec out{batch, msgSize};
+    UdpMsgVec in{batch, msgSize};
+
+    Clock::duration sendTime{}, recvTime{};
+    size_t sent{0}, recvd{0};
+    while (sent < Packets) {
+        for (size_t i{0}; i < batch; ++i) {
+            auto buf = out.prepare();
+            memset(buffer_cast<char*>(buf), 'x', msgSize);
+            memcpy(buffer_cast<char*>(buf), &sent, sizeof(sent));
+            out.commit(msgSize, ep);
+        }
+        auto start = Clock::now();
+        while (!out.empty()) {
+            sent += ssock.sendmmsg(out, 0);
+        }
+        auto end = Clock::now();
+        sendTime += end - start;
+
+        start = end;
+        while (recvd < sent) {
+            recvd += rsock.recvmmsg(in, 0);
+        }
+        end = Clock::now();
+        recvTime += end - start;
+    }
+    const auto pps = [](size_t n, Clock::duration d) {
+        return static_cast<long>(n / chrono::duration<double>(d).count());
+    };
+    SWIRLY_INFO << "batch "sv << batch << ": send "sv << pps(sent, sendTime) << " pps, recv "sv
+                << pps(recvd, recvTime) << " pps"sv;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int ret = 1;
+    try {
+        const size_t msgSize = argc > 1 ? stoul(argv[1]) : 64;
+        if (msgSize < sizeof(size_t)) {
+            throw invalid_argument{"message size too small"};
+        }
+        UdpSocket rsock{Udp::v4()};
+        rsock.bind(UdpEndpoint{IpAddress::from_string("127.0.0.1"), 0});
+        UdpEndpoint ep;
+        rsock.getSockName(ep);
+
+        UdpSocket ssock{Udp::v4()};
+        SWIRLY_INFO << "sending "sv << Packets << " packets of "sv << msgSize << " bytes to "sv
+                    << ep;
+        for (size_t batch{1}; batch <= MaxBatch; batch <<= 1) {
+            run(ssock, rsock, ep, batch, msgSize);
+        }
+        ret = 0;
+    } catch (const exception& e) {
+        SWIRLY_ERROR << "exception: "sv << e.what();
+    }
+    return ret;
+}